@@ -1,56 +1,122 @@
 #pragma once
 
 #include "types.h"
+#include "atom_arena.h"
+#include "attention_columns.h"
+#include "metadata.h"
+#include "mutation_log.h"
+#include "pattern_query.h"
+#include "capability_registry.h"
+#include "change_feed.h"
+#include "graph_index.h"
+#include "embedding_index.h"
+#include "seqlock.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <random>
+#include <iterator>
+#include <type_traits>
 
 namespace SwarmCog {
 
 /**
  * Base Atom class - fundamental unit of knowledge representation
  * Inspired by OpenCog's AtomSpace but adapted for multi-agent systems
+ *
+ * Truth and attention values sit behind sequence locks, so reads never
+ * block. While the atom is stored, its attention lives in the shard's
+ * AttentionColumns and the lock only guards where to find it. Setters log
+ * and publish a change after leaving the lock, so readers never wait on
+ * the mutation log or on subscribers. Metadata is kept in a separately
+ * allocated cold block with its own mutex.
  */
 class Atom {
+    friend class AgentSpace;
+
 protected:
-    AtomId id_;
+    // Where the attention value lives: the atom itself, or a column slot
+    struct AttentionBinding {
+        AttentionColumns* columns = nullptr;
+        uint32_t slot = 0;
+        AttentionValue detached;  // Used only while not bound to columns
+    };
+
+    // Rarely touched state, allocated on first use
+    struct ColdState {
+        AtomMetadata metadata;
+        std::mutex mutex;  // Guards metadata and orders setMetadata against attachToSpace
+    };
+
+    mutable AtomId id_;  // External string alias, stable across spaces; generated on first use
+    mutable std::once_flag id_once_;
+    std::atomic<AtomHandle> handle_{AtomHandle()};  // Assigned by the owning AgentSpace
     AtomType type_;
     std::string name_;
-    TruthValue truth_value_;
-    AttentionValue attention_value_;
+    SeqLock<TruthValue> truth_value_;
+    SeqLock<AttentionBinding> attention_;
+    std::atomic<MutationLog*> mutation_log_{nullptr};  // Set while stored in a space that logs mutations
+    std::atomic<AgentSpace*> space_{nullptr};          // Set while stored in a space
+    std::atomic<const AgentSpace*> owner_{nullptr};    // Claimed by a space from insertion until removal
+    std::atomic<uint32_t> announcing_{0};              // Setters that may still use the two above
     Timestamp timestamp_;
-    std::map<std::string, std::string> metadata_;
-    mutable std::mutex mutex_;
+    mutable std::atomic<ColdState*> cold_{nullptr};
 
 public:
     Atom(AtomType type, const std::string& name = "");
-    virtual ~Atom() = default;
+    virtual ~Atom();
+    Atom(const Atom&) = delete;
+    Atom& operator=(const Atom&) = delete;
 
     // Getters
-    const AtomId& getId() const { return id_; }
+    const AtomId& getId() const;
+    AtomHandle getHandle() const { return handle_.load(std::memory_order_acquire); }
     AtomType getType() const { return type_; }
     const std::string& getName() const { return name_; }
     TruthValue getTruthValue() const;
     AttentionValue getAttentionValue() const;
     Timestamp getTimestamp() const { return timestamp_; }
     
-    // Setters
-    void setName(const std::string& name);
+    // Setters; names are indexed, so setName only before the atom is stored
+    void setName(const std::string& name) { name_ = name; }
     void setTruthValue(const TruthValue& tv);
+    // Revises the truth value with another estimate in one atomic step
+    void reviseTruthValue(const TruthValue& other);
     void setAttentionValue(const AttentionValue& av);
     void setMetadata(const std::string& key, const std::string& value);
+    void setMetadata(MetadataKeyId key, MetadataValue value);
     std::string getMetadata(const std::string& key) const;
+    std::string getMetadata(MetadataKeyId key) const;
+    std::optional<MetadataValue> getMetadataValue(MetadataKeyId key) const;
+    std::vector<AtomMetadata::Entry> getMetadataEntries() const;
     
     // Virtual methods
     virtual std::string toString() const;
     virtual std::map<std::string, std::string> toDict() const;
     
     // Operators
-    bool operator==(const Atom& other) const { return id_ == other.id_; }
+    bool operator==(const Atom& other) const { return getId() == other.getId(); }
     bool operator!=(const Atom& other) const { return !(*this == other); }
 
 private:
     static std::string generateId();
+    // Replaces the id of an atom no other thread can see yet
+    void assignId(const AtomId& id);
+    
+    // Hand-off to and from an AgentSpace shard: attention storage, the
+    // space's mutation log, if it keeps one, and the space itself
+    void attachToSpace(AttentionColumns& columns, uint32_t slot, MutationLog* log, AgentSpace* space);
+    void detachFromSpace();
+    void setMutationLog(MutationLog* log);
+    // Waits out setters that may still use a mutation log or space just unset
+    void drainWriters();
+    // Log and publish a value a setter stored as `version`
+    void announceTruthValue(TruthValue tv, uint64_t version);
+    void announceAttentionValue(AttentionValue av, uint64_t version);
+    AttentionValue loadAttentionValue(uint64_t& version) const;
+    ColdState& cold() const;
+    // Sets, logs and publishes a metadata entry; returns the value it
+    // replaced. Caller holds cold().mutex.
+    std::optional<MetadataValue> storeMetadataLocked(MetadataKeyId key, MetadataValue value);
 };
 
 /**
@@ -72,6 +138,8 @@ public:
 
 /**
  * Link class - represents relationships between atoms
+ * The outgoing set should not be modified once the link is inserted into
+ * an AgentSpace, since the space indexes links by their targets.
  */
 class Link : public Atom {
 private:
@@ -89,43 +157,233 @@ public:
     std::map<std::string, std::string> toDict() const override;
 };
 
+class AgentSpaceSnapshot;
+using AgentSpaceSnapshotPtr = std::shared_ptr<const AgentSpaceSnapshot>;
+
 /**
  * AgentSpace - Thread-safe knowledge representation system for multi-agent coordination
  * Central repository for all atoms, relationships, and knowledge
  */
 class AgentSpace {
+    friend class Atom;
+    friend class AgentSpaceSnapshot;
+
 private:
+    // Slot table entry; the generation is bumped whenever the slot is freed
+    struct AtomSlot {
+        AtomPtr atom;
+        uint32_t generation = 1;
+        uint64_t content_key = 0;  // Non-zero when registered in the shard's content index
+        std::vector<AtomHandle> incoming;  // Links in this space that point at the atom
+    };
+
+    // Immutable copy of one shard, shared by every snapshot taken while the
+    // shard stays unchanged. Slots are copied in fixed-size chunks, and a
+    // chunk no write has touched since the previous view is shared with it,
+    // so a snapshot copies only what changed. The lookup tables are built
+    // from the chunks on first use, outside every lock. Indices hold local slots.
+    struct ShardView {
+        static constexpr uint32_t kChunkSlots = 256;
+        using Chunk = std::vector<AtomSlot>;
+        
+        struct Index {
+            std::unordered_map<AtomType, std::vector<uint32_t>> atoms_by_type;
+            std::unordered_map<std::string, std::vector<uint32_t>> atoms_by_name;
+            std::unordered_map<AtomId, uint32_t> atoms_by_id;
+        };
+        
+        uint64_t version = 0;
+        std::vector<std::shared_ptr<const Chunk>> chunks;  // all full but the last
+        std::vector<uint64_t> chunk_versions;  // the shard's chunk versions they were copied at
+        uint32_t slot_count = 0;
+        size_t live_atoms = 0;
+        
+        const AtomSlot& slot(uint32_t local_slot) const {
+            return (*chunks[local_slot / kChunkSlots])[local_slot % kChunkSlots];
+        }
+        const Index& index() const;
+        
+    private:
+        mutable std::once_flag index_once_;
+        mutable Index index_;
+    };
+
+    // Ordered value -> atoms map for one indexed metadata key
+    using MetadataIndex = std::map<MetadataValue, std::unordered_set<AtomHandle>>;
+
+    /**
+     * One lock-striped partition of the space. An atom lives in the shard
+     * encoded in its handle (global slot = local slot * shard count + shard),
+     * together with its type-index entry. Alias and name entries live in the
+     * shard their key hashes to, so string lookups touch a single shard;
+     * the same goes for generated-name reservations and the unique-name
+     * counter of each base name.
+     * With hash-consing enabled an atom's home shard is chosen by its content
+     * key, so the duplicate check and the insert share one shard lock.
+     * Metadata index entries live with the atom they point at.
+     */
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::vector<AtomSlot> slots;
+        std::vector<uint32_t> free_slots;
+        size_t live_atoms = 0;
+        std::unordered_map<AtomType, std::unordered_set<AtomHandle>> atoms_by_type;
+        std::unordered_map<AtomId, AtomHandle> atom_aliases;
+        std::unordered_map<std::string, std::unordered_set<AtomHandle>> atoms_by_name;
+        std::unordered_multimap<uint64_t, AtomHandle> content_index;
+        std::unordered_map<std::string, uint32_t> name_counters;  // Next suffix to try per base name, dropped with the base's atom
+        std::unordered_set<std::string> reserved_names;  // Generated names handed out but not yet indexed
+        // Symmetric (agent, agent) -> trust link entries whose lower slot is
+        // in this shard; the key packs both slot indices
+        std::unordered_map<uint64_t, AtomHandle> trust_links;
+        // One entry per indexed key, in every shard; keys are added only
+        // while every shard lock is held and never dropped
+        std::unordered_map<MetadataKeyId, MetadataIndex> metadata_indices;
+        AttentionColumns attention;  // STI/LTI/VLTI by local slot
+        uint64_t version = 0;  // Bumped on every change to slots or incoming sets
+        std::vector<uint64_t> chunk_versions;  // Per ShardView chunk of slots: version of its last change
+        std::shared_ptr<const ShardView> view;  // Last published view, guarded by snapshot_mutex_
+    };
+
     std::string name_;
-    std::unordered_map<AtomId, AtomPtr> atoms_;
-    std::unordered_map<AtomType, std::unordered_set<AtomId>> atoms_by_type_;
-    std::unordered_map<std::string, std::unordered_set<AtomId>> atoms_by_name_;
+    AgentSpaceConfig config_;
+    std::shared_ptr<AtomArena> arena_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    
+    // Link-derived indices (incoming sets, trust pairs) live in the shards of
+    // the atoms they describe. Link inserts, and removals of nodes no link
+    // points at, hold this lock shared and only contend on their shards;
+    // other removals, and whole-space reads that must not see a change half
+    // done (snapshots, graph builds), hold it exclusively. It is always
+    // taken before any shard lock.
+    mutable std::shared_mutex link_index_mutex_;
     
-    // Thread safety
-    mutable std::shared_mutex atoms_mutex_;
     ThreadSafeCounter atom_counter_;
     
+    // Background insertion of an opened snapshot file
+    struct SnapshotLoad;
+    std::unique_ptr<SnapshotLoad> snapshot_load_;
+    
     // Attention mechanism
-    std::vector<AtomId> attentional_focus_;
+    std::atomic<uint64_t> attention_ticks_{0};
+    std::vector<AtomHandle> attentional_focus_;
     mutable std::mutex focus_mutex_;
+    
+    // Serializes snapshot publication (shard view caches)
+    mutable std::mutex snapshot_mutex_;
+    
+    // Write-ahead log; changed only while every lock is held
+    std::shared_ptr<MutationLog> mutation_log_;
+    
+    // Capabilities of stored agent nodes; updated under the agent's shard lock
+    CapabilityRegistry capabilities_;
+    
+    // Cached adjacency graphs; fed link changes under link_index_mutex_
+    mutable GraphIndex graph_index_;
+    
+    // Embedding vectors of stored atoms; entries go with their atoms
+    EmbeddingIndex embedding_index_;
+    
+    // Declared last so its dispatcher stops before anything it reads goes away
+    ChangeFeed change_feed_{*this};
 
 public:
-    explicit AgentSpace(const std::string& name = "default_space");
-    ~AgentSpace() = default;
+    explicit AgentSpace(const std::string& name = "default_space",
+                        const AgentSpaceConfig& config = AgentSpaceConfig());
+    ~AgentSpace();
+
+    // Atom allocation from the space's slab arena (does not insert the atom)
+    NodePtr createNode(AtomType type, const std::string& name = "", const std::string& value = "");
+    LinkPtr createLink(AtomType type, const std::vector<AtomPtr>& outgoing = {}, const std::string& name = "");
 
-    // Basic atom operations
+    // Basic atom operations. With hash-consing enabled, adding an atom equal
+    // to a stored one returns the stored atom, with the new atom's truth value
+    // folded in by revision; the caller's atom is left untouched. An atom
+    // stored in another space is rejected with nullptr.
     AtomPtr addAtom(AtomPtr atom);
+    // Inserts a batch under a single acquisition of every lock, spreading the
+    // atoms across shards; returns the stored (canonical) atoms in input order
+    std::vector<AtomPtr> addAtoms(const std::vector<AtomPtr>& atoms);
     bool removeAtom(const AtomId& id);
+    bool removeAtom(AtomHandle handle);
     AtomPtr getAtom(const AtomId& id) const;
+    AtomPtr getAtom(AtomHandle handle) const;
+    AtomHandle getHandle(const AtomId& id) const;
     std::vector<AtomPtr> getAtoms() const;
     std::vector<AtomPtr> getAtomsByType(AtomType type) const;
     std::vector<AtomPtr> getAtomsByName(const std::string& name) const;
     
+    // Visitor queries: each match is passed as a const AtomPtr& straight from
+    // the index, without copying, under its shard's shared lock. A visitor
+    // may return false to stop early, and must not call back into the space.
+    // While a snapshot is loading, forEachOfType and forEachIncoming first
+    // load the atoms they will visit; the others wait for the load.
+    template<typename Visitor> void forEachAtom(Visitor&& visit) const;
+    template<typename Visitor> void forEachOfType(AtomType type, Visitor&& visit) const;
+    template<typename Visitor> void forEachWithName(const std::string& name, Visitor&& visit) const;
+    template<typename Visitor> void forEachIncoming(AtomHandle handle, Visitor&& visit) const;
+    // Visits local slots [first, first + count) of every shard, for scans
+    // spread over many calls; returns where to resume, or 0 once past the end
+    template<typename Visitor> size_t forEachInSlotRange(size_t first, size_t count, Visitor&& visit) const;
+    
+    // Pins a consistent, immutable view of the space for lock-free reading
+    AgentSpaceSnapshotPtr snapshot() const;
+    // Runs a pattern query against a fresh snapshot
+    QueryResult query(const PatternQuery& pattern, size_t limit = 0) const;
+    
+    // Binary snapshot files (see snapshot_file.h). Saving writes a consistent
+    // cut. Opening maps the file and returns at once, or nullptr if it cannot
+    // be read; a background thread then inserts the saved atoms in chunks.
+    // Until it finishes, lookups by id, by type and of incoming or trust links
+    // load the atoms they need (and their targets) from the mapping on demand,
+    // and getAtomCount() counts the whole file; scans, name and metadata
+    // lookups, snapshots and graphs wait for the load instead.
+    bool saveSnapshot(const std::string& path) const;
+    static std::shared_ptr<AgentSpace> openSnapshot(const std::string& path,
+                                                    const AgentSpaceConfig& config = AgentSpaceConfig());
+    // Blocks until an opened snapshot is fully loaded; false if the file
+    // turned out to be corrupt and only part of it was loaded
+    bool waitForSnapshot() const;
+    
+    // Write-ahead logging (see mutation_log.h). An attached log records every
+    // add, remove and clear, and every truth, attention or metadata change
+    // made through the setters of stored atoms. Attention decay is derived
+    // state and is not logged.
+    void setMutationLog(std::shared_ptr<MutationLog> log);
+    std::shared_ptr<MutationLog> getMutationLog() const;
+    // Applies a log, after any segment an interrupted checkpoint left behind,
+    // on top of the current contents; returns the records that took effect
+    size_t replayMutationLog(const std::string& path);
+    // Saves a snapshot and, once it is durable, drops the log records it covers
+    bool checkpoint(const std::string& snapshot_path);
+    // Latest snapshot (or an empty space called `name`) with the log replayed
+    // over it and reattached for further writes; nullptr on I/O failure
+    static std::shared_ptr<AgentSpace> recover(const std::string& name,
+                                               const std::string& snapshot_path,
+                                               const std::string& log_path,
+                                               const AgentSpaceConfig& config = AgentSpaceConfig(),
+                                               const MutationLogConfig& log_config = MutationLogConfig());
+    
+    // Change feed (see change_feed.h): batched add, remove and update events
+    // pushed to a handler on the feed's dispatcher thread
+    SubscriptionId subscribe(const ChangeFilter& filter, ChangeHandler handler,
+                             const SubscriptionConfig& config = SubscriptionConfig());
+    bool unsubscribe(SubscriptionId id);
+    ChangeFeed& getChangeFeed() { return change_feed_; }
+    
     // Agent-specific operations
     NodePtr addAgentNode(const std::string& name, const std::vector<std::string>& capabilities = {});
+    // Replaces a stored agent node's capabilities in its metadata and in the
+    // capability registry; setting the metadata directly bypasses the registry
+    bool setAgentCapabilities(AtomHandle agent, const std::vector<std::string>& capabilities);
+    const CapabilityRegistry& getCapabilityRegistry() const { return capabilities_; }
     NodePtr addCapabilityNode(const std::string& name, const std::string& description = "");
     NodePtr addGoalNode(const std::string& goal, double priority = 0.5);
     NodePtr addBeliefNode(const std::string& belief, const std::string& value = "");
-    NodePtr addMemoryNode(const std::string& content, const std::string& type = "episodic");
+    NodePtr addMemoryNode(const std::string& content, const std::string& type = "episodic",
+                          const AgentId& owner = "", const std::vector<float>& embedding = {});
+    // Memory nodes owned by an agent, optionally of one memory type
+    std::vector<NodePtr> getMemoryNodes(const AgentId& owner, const std::string& type = "") const;
     
     // Relationship operations
     LinkPtr addCollaborationLink(const AgentId& agent1, const AgentId& agent2, const std::string& type = "general");
@@ -136,26 +394,428 @@ public:
     std::vector<AtomPtr> findAtoms(AtomType type, const std::string& name = "") const;
     std::vector<AtomId> getCollaborators(const AgentId& agent_id) const;
     double getTrustLevel(const AgentId& agent1, const AgentId& agent2) const;
+    double getTrustLevel(AtomHandle agent1, AtomHandle agent2) const;
+    LinkPtr getTrustLink(AtomHandle agent1, AtomHandle agent2) const;
     std::vector<AtomPtr> getMostImportantAtoms(size_t limit = 10) const;
     
+    // Secondary indices on metadata keys (AgentSpaceConfig::metadata_indices
+    // declares the initial set). setMetadata on a stored atom keeps every
+    // index current. Lookups on a key without an index scan the space.
+    // Creating an index over existing atoms returns false if one exists.
+    bool createMetadataIndex(MetadataKeyId key);
+    bool hasMetadataIndex(MetadataKeyId key) const;
+    std::vector<AtomPtr> findByMetadata(MetadataKeyId key, const MetadataValue& value) const;
+    // Atoms with low <= value <= high, ordered by value
+    std::vector<AtomPtr> findByMetadataRange(MetadataKeyId key, const MetadataValue& low,
+                                             const MetadataValue& high) const;
+    
+    // Incoming-set queries (links whose outgoing set contains the atom)
+    std::vector<LinkPtr> getIncoming(AtomHandle handle) const;
+    std::vector<LinkPtr> getIncoming(AtomHandle handle, AtomType link_type) const;
+    size_t getIncomingCount(AtomHandle handle) const;
+    
+    // CSR adjacency graph over the links of the spec's types (see
+    // graph_index.h); cached and brought up to date on each call, so hold on
+    // to the result for a batch of traversals rather than asking per query
+    std::shared_ptr<const AdjacencyGraph> getGraph(const GraphSpec& spec) const;
+    
+    // Embeddings (see embedding_index.h): optional fixed-dimension vectors on
+    // stored atoms, searched by cosine similarity. Removing an atom drops its
+    // embedding. Embeddings are kept in memory only, not in snapshots or the log.
+    bool setEmbedding(AtomHandle handle, const std::vector<float>& embedding);
+    std::vector<float> getEmbedding(AtomHandle handle) const;
+    // Up to k stored atoms most similar to the query, most similar first
+    std::vector<std::pair<AtomPtr, double>> findSimilar(const std::vector<float>& query, size_t k) const;
+    // The same restricted to memory nodes, optionally of one owner
+    std::vector<std::pair<NodePtr, double>> findSimilarMemories(const std::vector<float>& query, size_t k,
+                                                                const AgentId& owner = "") const;
+    const EmbeddingIndex& getEmbeddingIndex() const { return embedding_index_; }
+    
     // Attention management
     void addToAttentionalFocus(const AtomId& atom_id);
+    void addToAttentionalFocus(AtomHandle handle);
     void removeFromAttentionalFocus(const AtomId& atom_id);
     std::vector<AtomId> getAttentionalFocus() const;
     void updateAttentionValues();
+    // Batched STI access for attention dynamics such as spreading activation,
+    // taking each touched shard's lock once. Handles no longer stored read
+    // as 0 and are skipped on update. Updated atoms are logged and published
+    // as ATTENTION_UPDATED, as setAttentionValue would; decay is not.
+    std::vector<double> loadSti(const std::vector<AtomHandle>& handles) const;
+    void addSti(const std::vector<std::pair<AtomHandle, double>>& deltas);
     
     // Utility methods
     size_t getAtomCount() const;
     std::string getName() const { return name_; }
+    const AgentSpaceConfig& getConfig() const { return config_; }
     void clear();
     std::map<std::string, size_t> getStatistics() const;
 
 private:
-    std::string generateUniqueNodeName(const std::string& base) const;
+    // Reserves a name no atom has and no other caller holds; the reservation
+    // ends when an atom with that name is indexed, or on release
+    std::string generateUniqueNodeName(const std::string& base);
+    void releaseNodeName(const std::string& name);
+    
+    // Shard addressing
+    Shard& shardOf(AtomHandle handle) const { return *shards_[handle.slot() % shards_.size()]; }
+    uint32_t localSlot(AtomHandle handle) const { return static_cast<uint32_t>(handle.slot() / shards_.size()); }
+    Shard& shardForTrustKey(uint64_t key) const { return *shards_[static_cast<uint32_t>(key) % shards_.size()]; }
+    Shard& shardForKey(const std::string& key) const;
+    size_t selectHomeShard() const;
+    
+    // Shard locks that become no-ops while this thread runs an addAtoms batch,
+    // which already holds every lock exclusively
+    std::shared_lock<std::shared_mutex> readLock(const Shard& shard) const;
+    std::unique_lock<std::shared_mutex> writeLock(Shard& shard) const;
+    
+    // Index maintenance; each helper takes the shard locks it needs
+    AtomPtr insertAtom(const AtomPtr& atom, const LinkPtr& link, size_t preferred_shard);
+    AtomPtr insertIntoShard(const AtomPtr& atom, size_t shard_index, uint64_t content_key);
     void addAtomToIndices(const AtomPtr& atom);
     void removeAtomFromIndices(const AtomPtr& atom);
+    bool eraseAtom(AtomHandle handle);
+    
+    // Metadata indices; callers hold the shard lock exclusively
+    void setAtomMetadata(Atom& atom, MetadataKeyId key, MetadataValue value);
+    void storeIndexedMetadata(Shard& shard, Atom& atom, AtomHandle handle, MetadataKeyId key, MetadataValue value);
+    static void indexMetadata(Shard& shard, const Atom& atom, AtomHandle handle);
+    static void unindexMetadata(Shard& shard, const Atom& atom, AtomHandle handle);
+    static void unindexValue(MetadataIndex& index, const MetadataValue& value, AtomHandle handle);
+    
+    // Persistence helpers
+    bool applyMutation(const MutationRecord& record);
+    void runSnapshotLoad();
+    void stopSnapshotLoad();
+    // Creates file atom `index` with the saved state; its targets must exist
+    AtomPtr createSnapshotAtom(SnapshotLoad& load, uint32_t index);
+    // Inserts file atom `index`, after any targets not yet inserted; caller holds load.mutex
+    AtomPtr loadSnapshotAtom(SnapshotLoad& load, uint32_t index);
+    AtomHandle loadSnapshotAlias(const AtomId& id) const;
+    // Until the load finishes, inserts every file atom of `type`, or every
+    // file link pointing at `handle`, so index queries see complete results
+    void loadSnapshotType(AtomType type) const;
+    void loadSnapshotIncoming(AtomHandle handle) const;
+    static void restoreAtomState(Atom& atom, const AtomId& id, Timestamp timestamp,
+                                 const TruthValue& tv, const AttentionValue& av);
+    
+    // Hash-consing; a zero key marks an atom that is not deduplicated
+    uint64_t contentKey(const AtomPtr& atom) const;
+    static bool sameContent(const Atom& a, const Atom& b);
+    
+    // Link-derived indices; callers hold link_index_mutex_, shared to add
+    // and exclusively to remove
+    void addToIncomingSets(const LinkPtr& link);
+    void removeFromIncomingSets(const LinkPtr& link);
+    void indexTrustLink(const LinkPtr& link);
+    void unindexTrustLink(const LinkPtr& link);
+    void unindexTrustLinksOf(const std::vector<AtomHandle>& incoming);
+    static uint64_t trustKey(AtomHandle agent1, AtomHandle agent2);
+    
+    // Lookups; each takes the owning shard lock in shared mode
+    AtomPtr lookupAtom(AtomHandle handle) const;
+    AtomPtr lookupLocked(const Shard& shard, AtomHandle handle) const;
+    bool isStoredLocked(const Shard& shard, AtomHandle handle) const;
+    AtomHandle resolveAlias(const AtomId& id) const;
+    std::vector<AtomHandle> copyIncoming(AtomHandle handle) const;
+    std::vector<AtomPtr> resolveHandles(const std::vector<AtomHandle>& handles) const;
+    LinkPtr lookupTrustLink(AtomHandle agent1, AtomHandle agent2) const;
+    
+    // Snapshot support; caller holds the shard lock. touchSlot records a
+    // change to a slot or its incoming set, so the next view recopies its chunk.
+    static std::shared_ptr<const ShardView> buildShardView(const Shard& shard);
+    static void touchSlot(Shard& shard, uint32_t local_slot);
+    
+    // Calls a visitor; visitors returning bool end the walk by returning false
+    template<typename Visitor>
+    static bool invokeVisitor(Visitor& visit, const AtomPtr& atom) {
+        if constexpr (std::is_same_v<std::invoke_result_t<Visitor&, const AtomPtr&>, bool>) {
+            return visit(atom);
+        } else {
+            visit(atom);
+            return true;
+        }
+    }
+    
+    // Visits handles grouped by shard, taking each shard lock once
+    template<typename Visitor>
+    void visitHandles(std::vector<AtomHandle> handles, Visitor& visit) const;
+};
+
+/**
+ * AgentSpaceSnapshot - Immutable, versioned view of an AgentSpace
+ *
+ * Obtained from AgentSpace::snapshot(). All queries run without locks and
+ * see the same consistent cut of the space however long the snapshot is
+ * held, so long analytic reads never stall writers. The atoms themselves are
+ * shared with the live space: truth and attention values stay current, while
+ * membership, indices and incoming sets are frozen at the snapshot version.
+ */
+class AgentSpaceSnapshot {
+    friend class AgentSpace;
+    friend class PatternMatcher;
+
+private:
+    uint64_t version_ = 0;
+    std::vector<std::shared_ptr<const AgentSpace::ShardView>> shards_;
+
+    const AgentSpace::AtomSlot* slotOf(AtomHandle handle) const;
+
+public:
+    /**
+     * Lazy forward range over the atoms of one type, optionally filtered by a
+     * predicate. Iteration walks the frozen type index in place and yields
+     * const AtomPtr& without allocating or touching reference counts.
+     */
+    template<typename Predicate>
+    class TypeRange {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = AtomPtr;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const AtomPtr*;
+            using reference = const AtomPtr&;
+
+            iterator() = default;
+            iterator(const TypeRange* range, size_t shard) : range_(range), shard_(shard) { settle(); }
+
+            reference operator*() const { return range_->atomAt(shard_, *slot_); }
+            pointer operator->() const { return &**this; }
+            iterator& operator++() { ++slot_; settle(); return *this; }
+            iterator operator++(int) { iterator copy = *this; ++*this; return copy; }
+            bool operator==(const iterator& other) const { return shard_ == other.shard_ && slot_ == other.slot_; }
+            bool operator!=(const iterator& other) const { return !(*this == other); }
+
+        private:
+            const TypeRange* range_ = nullptr;
+            size_t shard_ = 0;
+            const uint32_t* slot_ = nullptr;
+            const uint32_t* slot_end_ = nullptr;
+
+            // Moves to the next matching atom, crossing shard boundaries
+            void settle() {
+                size_t shard_count = range_->snapshot_->shards_.size();
+                while (shard_ < shard_count) {
+                    if (!slot_) {
+                        const auto* slots = range_->slotsIn(shard_);
+                        if (slots && !slots->empty()) {
+                            slot_ = slots->data();
+                            slot_end_ = slot_ + slots->size();
+                        } else {
+                            ++shard_;
+                            continue;
+                        }
+                    }
+                    while (slot_ != slot_end_ && !range_->predicate_(*range_->atomAt(shard_, *slot_))) {
+                        ++slot_;
+                    }
+                    if (slot_ != slot_end_) return;
+                    ++shard_;
+                    slot_ = slot_end_ = nullptr;
+                }
+                slot_ = nullptr;
+            }
+        };
+
+        TypeRange(const AgentSpaceSnapshot* snapshot, AtomType type, Predicate predicate)
+            : snapshot_(snapshot), type_(type), predicate_(std::move(predicate)) {}
+
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, snapshot_->shards_.size()); }
+
+        // Narrows the range further; the result is still lazy
+        template<typename Next>
+        auto filter(Next next) const {
+            auto combined = [first = predicate_, next = std::move(next)](const Atom& atom) {
+                return first(atom) && next(atom);
+            };
+            return TypeRange<decltype(combined)>(snapshot_, type_, std::move(combined));
+        }
+
+    private:
+        const AgentSpaceSnapshot* snapshot_;
+        AtomType type_;
+        Predicate predicate_;
+
+        const std::vector<uint32_t>* slotsIn(size_t shard) const {
+            const auto& index = snapshot_->shards_[shard]->index().atoms_by_type;
+            auto it = index.find(type_);
+            return it != index.end() ? &it->second : nullptr;
+        }
+
+        const AtomPtr& atomAt(size_t shard, uint32_t slot) const {
+            return snapshot_->shards_[shard]->slot(slot).atom;
+        }
+    };
+
+    struct MatchAll {
+        bool operator()(const Atom&) const { return true; }
+    };
+
+    // Increases with every change to the space; equal versions mean equal contents
+    uint64_t getVersion() const { return version_; }
+    size_t getAtomCount() const;
+    
+    AtomPtr getAtom(const AtomId& id) const;
+    AtomPtr getAtom(AtomHandle handle) const;
+    std::vector<AtomPtr> getAtoms() const;
+    std::vector<AtomPtr> getAtomsByType(AtomType type) const;
+    std::vector<AtomPtr> getAtomsByName(const std::string& name) const;
+    std::vector<LinkPtr> getIncoming(AtomHandle handle) const;
+    
+    // Lock-free lazy range and visitors; the snapshot must outlive them
+    TypeRange<MatchAll> atomsOfType(AtomType type) const { return TypeRange<MatchAll>(this, type, MatchAll()); }
+    template<typename Visitor> void forEachAtom(Visitor&& visit) const;
+    template<typename Visitor> void forEachOfType(AtomType type, Visitor&& visit) const;
+    
+    // Pattern matching (see pattern_query.h); a limit of 0 returns every match
+    QueryResult query(const PatternQuery& pattern, size_t limit = 0) const;
+};
+
+/**
+ * LinkBatch - Builder for creating many links in one AgentSpace batch
+ *
+ * Links are allocated from the space's arena as they are added, so callers
+ * can still set truth values or metadata on them, and are inserted together
+ * by commit() through AgentSpace::addAtoms.
+ */
+class LinkBatch {
+private:
+    AgentSpace& agentspace_;
+    std::vector<AtomPtr> links_;
+
+public:
+    explicit LinkBatch(AgentSpace& agentspace) : agentspace_(agentspace) {}
+
+    LinkBatch& reserve(size_t count) { links_.reserve(count); return *this; }
+    LinkPtr add(AtomType type, const std::vector<AtomPtr>& outgoing, const std::string& name = "");
+    size_t size() const { return links_.size(); }
+
+    // Inserts every pending link and empties the batch
+    std::vector<AtomPtr> commit();
 };
 
+// AgentSpace visitor templates
+template<typename Visitor>
+void AgentSpace::forEachAtom(Visitor&& visit) const {
+    waitForSnapshot();
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        for (const auto& slot : shard->slots) {
+            if (slot.atom && !invokeVisitor(visit, slot.atom)) return;
+        }
+    }
+}
+
+template<typename Visitor>
+void AgentSpace::forEachOfType(AtomType type, Visitor&& visit) const {
+    loadSnapshotType(type);
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        
+        auto it = shard->atoms_by_type.find(type);
+        if (it == shard->atoms_by_type.end()) continue;
+        
+        for (AtomHandle handle : it->second) {
+            if (!invokeVisitor(visit, shard->slots[localSlot(handle)].atom)) return;
+        }
+    }
+}
+
+template<typename Visitor>
+void AgentSpace::forEachWithName(const std::string& name, Visitor&& visit) const {
+    waitForSnapshot();
+    
+    // Name entries point into other shards; copy the handles before visiting
+    // so no two shard locks are ever held together
+    std::vector<AtomHandle> handles;
+    {
+        const Shard& shard = shardForKey(name);
+        auto lock = readLock(shard);
+        
+        auto it = shard.atoms_by_name.find(name);
+        if (it == shard.atoms_by_name.end()) return;
+        handles.assign(it->second.begin(), it->second.end());
+    }
+    
+    visitHandles(std::move(handles), visit);
+}
+
+template<typename Visitor>
+void AgentSpace::forEachIncoming(AtomHandle handle, Visitor&& visit) const {
+    loadSnapshotIncoming(handle);
+    visitHandles(copyIncoming(handle), visit);
+}
+
+template<typename Visitor>
+size_t AgentSpace::forEachInSlotRange(size_t first, size_t count, Visitor&& visit) const {
+    waitForSnapshot();
+    bool more = false;
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        
+        size_t end = std::min(first + count, shard->slots.size());
+        for (size_t i = first; i < end; ++i) {
+            if (shard->slots[i].atom && !invokeVisitor(visit, shard->slots[i].atom)) return first + count;
+        }
+        more = more || end < shard->slots.size();
+    }
+    return more ? first + count : 0;
+}
+
+template<typename Visitor>
+void AgentSpace::visitHandles(std::vector<AtomHandle> handles, Visitor& visit) const {
+    size_t shard_count = shards_.size();
+    std::sort(handles.begin(), handles.end(), [shard_count](AtomHandle a, AtomHandle b) {
+        return a.slot() % shard_count < b.slot() % shard_count;
+    });
+    
+    size_t i = 0;
+    while (i < handles.size()) {
+        const Shard& shard = shardOf(handles[i]);
+        auto lock = readLock(shard);
+        
+        for (; i < handles.size() && &shardOf(handles[i]) == &shard; ++i) {
+            const AtomSlot* slot = nullptr;
+            uint32_t local_index = localSlot(handles[i]);
+            if (local_index < shard.slots.size()) {
+                slot = &shard.slots[local_index];
+            }
+            if (slot && slot->atom && slot->generation == handles[i].generation() &&
+                !invokeVisitor(visit, slot->atom)) {
+                return;
+            }
+        }
+    }
+}
+
+// AgentSpaceSnapshot visitor templates
+template<typename Visitor>
+void AgentSpaceSnapshot::forEachAtom(Visitor&& visit) const {
+    for (const auto& shard : shards_) {
+        for (const auto& chunk : shard->chunks) {
+            for (const auto& slot : *chunk) {
+                if (slot.atom && !AgentSpace::invokeVisitor(visit, slot.atom)) return;
+            }
+        }
+    }
+}
+
+template<typename Visitor>
+void AgentSpaceSnapshot::forEachOfType(AtomType type, Visitor&& visit) const {
+    for (const auto& shard : shards_) {
+        const auto& index = shard->index().atoms_by_type;
+        auto it = index.find(type);
+        if (it == index.end()) continue;
+        
+        for (uint32_t local_slot : it->second) {
+            if (!AgentSpace::invokeVisitor(visit, shard->slot(local_slot).atom)) return;
+        }
+    }
+}
+
 // Factory functions for creating specific atom types
 NodePtr createAgentNode(const std::string& name, const std::vector<std::string>& capabilities = {});
 NodePtr createCapabilityNode(const std::string& name, const std::string& description = "");
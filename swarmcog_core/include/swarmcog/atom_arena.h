@@ -0,0 +1,135 @@
+#pragma once
+
+#include "types.h"
+#include <cstddef>
+
+namespace SwarmCog {
+
+/**
+ * AtomArena - Type-segregated slab allocator for atoms
+ *
+ * Every distinct block size (a Node or Link together with its shared_ptr
+ * control block) is served from its own pool of slabs, so atoms of one
+ * kind sit contiguously in memory. Freed blocks go onto an intrusive free
+ * list and are recycled by the next allocation of the same size. Slabs are
+ * only returned to the system when the arena itself is destroyed, which
+ * happens once the owning AgentSpace and every atom allocated from it are gone.
+ *
+ * The pools are striped: each thread allocates from, and frees into, the
+ * stripe it was assigned, so concurrent writers rarely share a lock. A block
+ * freed by another thread than the one that allocated it joins the freeing
+ * thread's free list. A stripe that runs dry takes such a list from another
+ * stripe before it takes a new slab, so blocks freed on background threads
+ * are reused rather than stranded. Only taking a slab goes through the
+ * shared list.
+ */
+class AtomArena {
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Slab {
+        void* memory = nullptr;
+        size_t size = 0;
+        bool mapped = false;  // true when obtained from mmap rather than operator new
+    };
+
+    struct Pool {
+        size_t block_size = 0;
+        FreeBlock* free_list = nullptr;
+        char* cursor = nullptr;
+        char* end = nullptr;
+    };
+
+    struct alignas(64) Stripe {
+        std::vector<Pool> pools;
+        // Allocations minus frees in this stripe; negative when it frees
+        // blocks other stripes handed out
+        std::ptrdiff_t live_blocks = 0;
+        mutable std::mutex mutex;
+    };
+
+    AtomArenaConfig config_;
+    std::unique_ptr<Stripe[]> stripes_;
+    size_t stripe_count_ = 1;
+    std::vector<Slab> slabs_;
+    size_t reserved_bytes_ = 0;
+    mutable std::mutex slab_mutex_;  // guards slabs_ and reserved_bytes_
+
+public:
+    static constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    explicit AtomArena(const AtomArenaConfig& config = AtomArenaConfig());
+    ~AtomArena();
+
+    AtomArena(const AtomArena&) = delete;
+    AtomArena& operator=(const AtomArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    void deallocate(void* ptr, size_t size, size_t alignment);
+
+    // Statistics
+    const AtomArenaConfig& getConfig() const { return config_; }
+    size_t getReservedBytes() const;
+    size_t getLiveBlocks() const;
+    size_t getSlabCount() const;
+
+    // Process-wide arena used by the free-standing factory functions
+    static std::shared_ptr<AtomArena> defaultArena();
+
+private:
+    bool isPooled(size_t size, size_t alignment) const;
+    Stripe& stripeForThread() const;
+    static Pool& poolFor(Stripe& stripe, size_t block_size);
+    // Detaches another stripe's free list of the size, or nullptr if none
+    // has one. Caller holds no stripe lock.
+    FreeBlock* reclaim(const Stripe& self, size_t block_size);
+    void refill(Pool& pool);
+    Slab acquireSlab(size_t size);
+    static void releaseSlab(const Slab& slab);
+};
+
+/**
+ * STL allocator adapter over AtomArena, used with std::allocate_shared so the
+ * atom and its control block share one pooled block. Each copy keeps the
+ * arena alive, so atoms may safely outlive the AgentSpace that created them.
+ */
+template<typename T>
+class AtomAllocator {
+private:
+    std::shared_ptr<AtomArena> arena_;
+
+    template<typename U> friend class AtomAllocator;
+
+public:
+    using value_type = T;
+
+    explicit AtomAllocator(std::shared_ptr<AtomArena> arena) : arena_(std::move(arena)) {}
+
+    template<typename U>
+    AtomAllocator(const AtomAllocator<U>& other) : arena_(other.arena_) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        arena_->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    bool operator==(const AtomAllocator<U>& other) const { return arena_ == other.arena_; }
+
+    template<typename U>
+    bool operator!=(const AtomAllocator<U>& other) const { return arena_ != other.arena_; }
+};
+
+// Allocate an atom (Node, Link, ...) from the given arena
+template<typename T, typename... Args>
+std::shared_ptr<T> allocateAtom(const std::shared_ptr<AtomArena>& arena, Args&&... args) {
+    return std::allocate_shared<T>(AtomAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+} // namespace SwarmCog
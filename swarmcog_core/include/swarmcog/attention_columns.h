@@ -0,0 +1,133 @@
+#pragma once
+
+#include "types.h"
+#include <set>
+#include <tuple>
+
+namespace SwarmCog {
+
+// Entries of one importance-term index, largest term first: (sign, signed
+// log-magnitude at tick 0, slot). See AttentionColumns.
+using TermIndex = std::set<std::tuple<int, double, uint32_t>, std::greater<std::tuple<int, double, uint32_t>>>;
+
+/**
+ * AttentionBlock - Fixed-capacity structure-of-arrays chunk of attention values
+ *
+ * STI, LTI and VLTI are stored in separate contiguous arrays, each entry
+ * with the decay tick its values are current as of. The values are relaxed
+ * atomic words behind a per-block sequence number, so readers copy them
+ * without locking and retry if a writer overlapped. Each indexed entry also
+ * keeps its importance split into decay terms, and its position in each
+ * term index, so moving it costs no search; those are writer-only.
+ */
+struct AttentionBlock {
+    static constexpr size_t kCapacity = 512;
+    static constexpr size_t kTerms = 3;
+
+    std::atomic<uint64_t> sequence{0};
+    alignas(64) std::atomic<double> sti[kCapacity] = {};
+    alignas(64) std::atomic<double> lti[kCapacity] = {};
+    alignas(64) std::atomic<double> vlti[kCapacity] = {};
+    std::atomic<uint64_t> stamp[kCapacity] = {};
+    bool indexed[kCapacity] = {};
+    double term[kTerms][kCapacity] = {};
+    TermIndex::iterator rank[kTerms][kCapacity];
+
+    // Applies `ticks` decay steps at once, in closed form
+    static void decay(double& sti, double& lti, double& vlti, uint64_t ticks);
+    // Splits importance into coefficients of its geometric terms: n ticks on,
+    // importance is sum(terms[j] * kRates[j]^n)
+    static void split(double sti, double lti, double vlti, double terms[kTerms]);
+    static const double kRates[kTerms];
+};
+
+/**
+ * AttentionColumns - Attention values of one AgentSpace shard, indexed by
+ * local slot and grown one AttentionBlock at a time
+ *
+ * Decay is lazy: a tick only advances the column's clock, and a value is
+ * decayed by the ticks it missed when it is next read or written. A tick
+ * therefore costs O(1) however many atoms the shard holds.
+ *
+ * load() and loadSti() take no lock: they find the block through a
+ * directory that is replaced, never modified, as blocks are added, and
+ * decay the copied value themselves. Writers and top() serialize on the
+ * column mutex. Blocks and directories live as long as the columns, so a
+ * reader holding a stale binding never touches freed memory.
+ *
+ * Bound slots are also indexed for top-K queries without bringing them
+ * current. STI, LTI and VLTI decay at different rates and feed into each
+ * other, so no single factor rescales importance and a stale entry's rank
+ * can change; what does not change is how importance splits into three
+ * geometric terms, one per rate. Each term has an ordered index keyed by its
+ * coefficient scaled back to tick 0 (in log space, so keys never overflow),
+ * which ranks that term identically at every tick. top() merges the three
+ * with the threshold algorithm: it reads the indices in step and stops once
+ * K slots score at least the sum of the terms under the cursors, which no
+ * unread slot can beat. Atoms that tie stop it after K entries.
+ *
+ * The optional sweep brings slots current, keeping decay exponents short;
+ * the index does not depend on it.
+ */
+class AttentionColumns {
+public:
+    AttentionColumns() = default;
+
+    AttentionColumns(const AttentionColumns&) = delete;
+    AttentionColumns& operator=(const AttentionColumns&) = delete;
+
+    // Slot lifecycle; bind allocates the block and indexes the slot
+    void bind(uint32_t slot, const AttentionValue& av);
+    AttentionValue unbind(uint32_t slot);
+
+    AttentionValue load(uint32_t slot) const;
+    void store(uint32_t slot, const AttentionValue& av);
+    // Batched STI access; addSti brings each slot current, adds its delta
+    // within the STI range and reindexes it under one lock acquisition
+    void loadSti(const std::vector<uint32_t>& slots, std::vector<double>& sti) const;
+    void addSti(const std::vector<std::pair<uint32_t, double>>& deltas);
+
+    // Advances the decay clock by one tick without touching any slot
+    void advance();
+    // Brings the first `slot_count` slots current, locking one block at a time
+    void sweep(size_t slot_count);
+    uint64_t getTick() const;
+
+    // Up to `limit` (importance, slot) pairs of bound slots, highest first
+    std::vector<std::pair<double, uint32_t>> top(size_t limit) const;
+
+    size_t getBlockCount() const;
+    // Unbinds every slot; blocks stay allocated for reuse
+    void clear();
+
+    static double importance(double sti, double lti, double vlti) { return sti + lti + vlti; }
+
+private:
+    using Directory = std::vector<AttentionBlock*>;
+
+    std::vector<std::unique_ptr<AttentionBlock>> blocks_;
+    std::vector<std::unique_ptr<Directory>> directories_;  // all published, newest last
+    std::atomic<const Directory*> directory_{nullptr};
+    TermIndex terms_[AttentionBlock::kTerms];
+    std::atomic<uint64_t> tick_{0};
+    mutable std::mutex mutex_;
+
+    AttentionBlock& blockOf(uint32_t slot) const {
+        return *(*directory_.load(std::memory_order_acquire))[slot / AttentionBlock::kCapacity];
+    }
+    static uint32_t indexInBlock(uint32_t slot) { return slot % AttentionBlock::kCapacity; }
+
+    // Lock-free
+    void read(uint32_t slot, AttentionValue& av) const;
+    // Caller holds mutex_
+    void write(uint32_t slot, const AttentionValue& av);
+    // Slot's term j and importance at the current tick, from its split
+    double termAt(uint32_t slot, size_t j) const;
+    double score(uint32_t slot) const;
+
+    // Term index maintenance; caller holds mutex_
+    void link(uint32_t slot);
+    void unlink(uint32_t slot);
+};
+
+} // namespace SwarmCog
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "types.h"
+#include <unordered_map>
+
+namespace SwarmCog {
+
+using CapabilityId = uint32_t;
+
+/**
+ * CapabilityRegistry - Inverted index from capabilities to agent nodes
+ *
+ * Capability names are interned to dense ids and registered agents to dense
+ * member indices. Each capability keeps a bitset over members and each
+ * member a bitset over capabilities, so "agents with all of these
+ * capabilities" is a word-wise AND of a few bitsets. Bitsets grow in whole
+ * 512-bit blocks, which keeps the AND loops fixed-width so the compiler
+ * vectorizes them.
+ */
+class CapabilityRegistry {
+public:
+    static constexpr size_t kBlockWords = 8;
+
+    // Replaces an agent's capabilities; an empty list unregisters the agent
+    void setCapabilities(AtomHandle agent, const std::vector<std::string>& capabilities);
+    void removeAgent(AtomHandle agent);
+    void clear();
+
+    CapabilityId intern(const std::string& capability);
+    // Returns false for a capability no agent has ever had
+    bool find(const std::string& capability, CapabilityId& id) const;
+
+    bool hasCapability(AtomHandle agent, const std::string& capability) const;
+    std::vector<std::string> getCapabilities(AtomHandle agent) const;
+
+    // Agents having every listed capability (an empty list matches none)
+    std::vector<AtomHandle> agentsWithAll(const std::vector<std::string>& capabilities) const;
+    std::vector<AtomHandle> agentsWithAll(const std::vector<CapabilityId>& capabilities) const;
+    size_t countWithAll(const std::vector<CapabilityId>& capabilities) const;
+    // Agents having at least one listed capability
+    std::vector<AtomHandle> agentsWithAny(const std::vector<CapabilityId>& capabilities) const;
+
+    size_t getAgentCount() const;
+    size_t getCapabilityCount() const;
+
+private:
+    using Bitset = std::vector<uint64_t>;
+
+    std::unordered_map<std::string, CapabilityId> ids_;
+    std::vector<std::string> names_;
+    std::vector<Bitset> agents_by_capability_;  // capability -> member bits
+    std::vector<Bitset> capabilities_of_;       // member -> capability bits
+    std::vector<AtomHandle> members_;           // member -> agent (invalid when free)
+    std::unordered_map<AtomHandle, uint32_t> member_of_;
+    std::vector<uint32_t> free_members_;
+    size_t member_words_ = 0;  // width of every agents_by_capability_ bitset
+    mutable std::shared_mutex mutex_;
+
+    // Callers hold mutex_
+    CapabilityId internLocked(const std::string& capability);
+    void removeLocked(uint32_t member);
+    // ANDs (or ORs) the capabilities' member bitsets; false if one is unknown
+    bool combine(const std::vector<CapabilityId>& capabilities, bool all, Bitset& result) const;
+    std::vector<AtomHandle> membersIn(const Bitset& bits) const;
+};
+
+} // namespace SwarmCog
\ No newline at end of file
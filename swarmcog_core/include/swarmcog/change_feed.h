@@ -0,0 +1,117 @@
+#pragma once
+
+#include "types.h"
+#include "metadata.h"
+#include <condition_variable>
+
+namespace SwarmCog {
+
+class AgentSpace;
+
+enum class ChangeKind : uint8_t {
+    ADDED,
+    REMOVED,
+    TRUTH_UPDATED,
+    ATTENTION_UPDATED,
+    METADATA_UPDATED,
+    CLEARED,  // the whole space was emptied; carries no atom
+};
+
+struct ChangeEvent {
+    ChangeKind kind = ChangeKind::ADDED;
+    AtomType type = AtomType::NODE;
+    AtomHandle handle;          // handle the atom had when the change happened
+    MetadataKeyId key = 0;      // METADATA_UPDATED only
+    AtomPtr atom;               // nullptr if an updated atom was removed before delivery
+};
+
+/**
+ * ChangeBatch - Events delivered to a handler in one call, oldest first
+ *
+ * `dropped` counts events lost to a full buffer since the previous batch.
+ * When it is non-zero the subscriber missed changes and should resync,
+ * e.g. from a snapshot, before trusting its view again.
+ */
+struct ChangeBatch {
+    std::vector<ChangeEvent> events;
+    uint64_t dropped = 0;
+};
+
+using ChangeHandler = std::function<void(const ChangeBatch&)>;
+using SubscriptionId = uint64_t;
+
+/**
+ * ChangeFilter - Which events a subscriber receives. Empty lists and an
+ * empty name match everything; CLEARED always passes the type and name tests.
+ */
+struct ChangeFilter {
+    std::vector<AtomType> types;
+    std::string name;
+    std::vector<ChangeKind> kinds;
+
+    bool matches(ChangeKind kind, AtomType type, const std::string& atom_name) const;
+};
+
+/**
+ * ChangeFeed - Push subscription to the mutations of one AgentSpace
+ *
+ * Each subscriber owns a bounded lock-free multi-producer ring. Mutating
+ * threads filter an event and push it with a single compare-and-swap; a full
+ * ring drops the event and counts it rather than waiting, so a slow
+ * consumer never stalls writers. A dispatcher thread, started with the first
+ * subscription, drains the rings and calls each handler with batches of up
+ * to max_batch events, never concurrently for the same subscriber. Update
+ * events are resolved to their atom at delivery, so handlers see current
+ * values. Handlers may call back into the space.
+ *
+ * Publishing costs one atomic load while nobody is subscribed.
+ */
+class ChangeFeed {
+private:
+    struct Subscriber;
+
+    AgentSpace& space_;
+    std::atomic<size_t> active_{0};
+    std::vector<std::shared_ptr<Subscriber>> subscribers_;
+    mutable std::shared_mutex subscribers_mutex_;
+    SubscriptionId next_id_ = 1;
+
+    std::thread dispatcher_;
+    bool stopping_ = false;
+    std::atomic<bool> wake_pending_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+
+    void push(ChangeEvent event, const std::string& name);
+    void dispatchLoop();
+    void deliver(Subscriber& subscriber);
+    std::vector<std::shared_ptr<Subscriber>> copySubscribers() const;
+
+public:
+    static constexpr std::chrono::milliseconds kMaxLatency{10};  // longest an event waits without a wake-up
+
+    explicit ChangeFeed(AgentSpace& space);
+    ~ChangeFeed();
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    SubscriptionId subscribe(const ChangeFilter& filter, ChangeHandler handler,
+                             const SubscriptionConfig& config = SubscriptionConfig());
+    // Once this returns the handler is not running and will not run again
+    // (unless called from inside the handler itself)
+    bool unsubscribe(SubscriptionId id);
+
+    // Delivers every event queued so far on the calling thread
+    void flush();
+    // Stops the dispatcher; queued events are left undelivered
+    void stop();
+
+    // Called by the AgentSpace and its atoms; `atom` may be null for updates
+    void publish(ChangeKind kind, const Atom& source, const AtomPtr& atom = nullptr, MetadataKeyId key = 0);
+    void publishClear();
+
+    size_t getSubscriberCount() const;
+    uint64_t getDroppedCount(SubscriptionId id) const;
+};
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -122,6 +122,7 @@ public:
     const std::string& getName() const { return name_; }
     const std::string& getModel() const { return model_; }
     const std::string& getInstructions() const { return instructions_; }
+    NodePtr getAgentNode() const { return agent_node_; }
     
     // Basic setters
     void setName(const std::string& name) { name_ = name; }
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "types.h"
+#include <random>
+#include <unordered_map>
+
+namespace SwarmCog {
+
+/**
+ * VectorKernels - Distance kernels over embedding rows
+ *
+ * Lengths are multiples of EmbeddingArena::kRowFloats, so the SIMD paths
+ * never need a scalar tail. The instruction set is chosen at compile time:
+ * AVX2/FMA when the target enables it (SWARMCOG_NATIVE_ARCH), else SSE2 or
+ * NEON, else plain C++.
+ */
+struct VectorKernels {
+    static float dot(const float* a, const float* b, size_t length);
+    static const char* getName();
+};
+
+/**
+ * EmbeddingArena - Fixed-dimension float vectors in contiguous aligned rows
+ *
+ * Each row is padded with zeros to a whole number of cache lines and starts
+ * on a cache-line boundary. Rows are carved from blocks that never move, so
+ * a row pointer stays valid as the arena grows; released rows are reused.
+ */
+class EmbeddingArena {
+public:
+    static constexpr size_t kAlignment = 64;
+    static constexpr size_t kRowFloats = kAlignment / sizeof(float);  // row stride granularity
+    static constexpr size_t kRowsPerBlock = 256;
+
+    explicit EmbeddingArena(size_t dimensions = 0);
+    ~EmbeddingArena();
+
+    EmbeddingArena(const EmbeddingArena&) = delete;
+    EmbeddingArena& operator=(const EmbeddingArena&) = delete;
+
+    // Frees every block and sets the row dimension for what follows
+    void reset(size_t dimensions);
+
+    uint32_t allocate();  // zero-filled row
+    void release(uint32_t row);
+
+    float* row(uint32_t id) { return blocks_[id / kRowsPerBlock] + (id % kRowsPerBlock) * stride_; }
+    const float* row(uint32_t id) const { return blocks_[id / kRowsPerBlock] + (id % kRowsPerBlock) * stride_; }
+
+    size_t getDimensions() const { return dimensions_; }
+    size_t getStride() const { return stride_; }
+    size_t getLiveRows() const { return next_row_ - free_rows_.size(); }
+    size_t getReservedBytes() const { return blocks_.size() * kRowsPerBlock * stride_ * sizeof(float); }
+
+private:
+    size_t dimensions_ = 0;
+    size_t stride_ = 0;
+    std::vector<float*> blocks_;
+    uint32_t next_row_ = 0;
+    std::vector<uint32_t> free_rows_;
+};
+
+/**
+ * EmbeddingIndex - Approximate nearest-neighbour index over atom embeddings
+ *
+ * A hierarchical navigable small world (HNSW) graph: every vector is a node
+ * on layer 0 and, with geometrically falling probability, on the layers
+ * above, each layer linking a node to its nearest neighbours as chosen by
+ * the diversity heuristic. A query descends greedily from the top layer and
+ * runs a best-first search of width ef on layer 0.
+ *
+ * Vectors are normalized on insert, so similarity is cosine similarity and
+ * a single dot product. Removal tombstones a node: it keeps routing searches
+ * but never appears in results. Once tombstones outnumber live nodes the
+ * graph is rebuilt from the live vectors and their rows are reclaimed.
+ *
+ * Searches share a reader lock; inserts and removals are exclusive.
+ */
+class EmbeddingIndex {
+public:
+    using Match = std::pair<float, AtomHandle>;  // (cosine similarity, atom)
+
+    explicit EmbeddingIndex(const EmbeddingConfig& config = EmbeddingConfig());
+
+    EmbeddingIndex(const EmbeddingIndex&) = delete;
+    EmbeddingIndex& operator=(const EmbeddingIndex&) = delete;
+
+    // Adds or replaces the atom's vector; false (and logged) on a dimension
+    // mismatch or a zero vector
+    bool insert(AtomHandle handle, const std::vector<float>& embedding);
+    bool remove(AtomHandle handle);
+    bool contains(AtomHandle handle) const;
+    // The stored (normalized) vector; empty when the atom has none
+    std::vector<float> get(AtomHandle handle) const;
+
+    // Up to k matches, most similar first; ef widens the layer-0 search
+    // beyond the configured ef_search for better recall
+    std::vector<Match> search(const std::vector<float>& query, size_t k, size_t ef = 0) const;
+    // Brute-force scan of every live vector, for checking recall
+    std::vector<Match> searchExact(const std::vector<float>& query, size_t k) const;
+
+    size_t size() const;
+    size_t getDimensions() const;
+    size_t getReservedBytes() const;
+    void clear();
+
+private:
+    static constexpr uint32_t kNoNode = UINT32_MAX;
+
+    struct GraphNode {
+        AtomHandle handle;
+        uint32_t row = 0;
+        bool deleted = false;
+        std::vector<std::vector<uint32_t>> links;  // per layer, 0 up to the node's level
+    };
+
+    using Candidate = std::pair<float, uint32_t>;  // (similarity, node)
+
+    EmbeddingConfig config_;
+    size_t dimensions_ = 0;  // 0 until fixed by the config or the first vector
+    double level_scale_;
+    EmbeddingArena arena_;
+    std::vector<GraphNode> nodes_;
+    std::unordered_map<AtomHandle, uint32_t> by_handle_;  // live nodes only
+    uint32_t entry_point_ = kNoNode;
+    size_t deleted_count_ = 0;
+    std::mt19937_64 rng_;
+    mutable std::shared_mutex mutex_;
+
+    // Normalized, zero-padded copy of `embedding`; false for a zero vector
+    bool normalize(const std::vector<float>& embedding, float* out) const;
+    float similarity(const float* query, uint32_t node) const {
+        return VectorKernels::dot(query, arena_.row(nodes_[node].row), arena_.getStride());
+    }
+    size_t maxLinks(size_t layer) const { return layer == 0 ? 2 * config_.max_neighbors : config_.max_neighbors; }
+
+    uint32_t greedyDescend(const float* query, uint32_t entry, size_t from_layer, size_t to_layer) const;
+    // Best-first search of one layer; returns up to ef nodes, most similar
+    // first. Tombstones are always walked through but only returned when
+    // linking, so the graph stays connected around them.
+    std::vector<Candidate> searchLayer(const float* query, uint32_t entry, size_t ef, size_t layer,
+                                       bool live_only) const;
+    // HNSW neighbour-selection heuristic: keeps a candidate only if it is
+    // nearer the base than to every neighbour already kept
+    std::vector<uint32_t> selectNeighbors(const std::vector<Candidate>& candidates, size_t limit) const;
+
+    // Draws the node's level and links it into every layer up to it
+    void addNode(AtomHandle handle, uint32_t row);
+    void eraseLocked(AtomHandle handle);
+    void compact();
+};
+
+} // namespace SwarmCog
\ No newline at end of file
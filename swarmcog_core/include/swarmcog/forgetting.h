@@ -0,0 +1,84 @@
+#pragma once
+
+#include "types.h"
+#include "agentspace.h"
+#include <condition_variable>
+
+namespace SwarmCog {
+
+struct ForgettingStats {
+    size_t forgotten = 0;        // atoms removed for low importance or over a quota
+    size_t merged = 0;           // duplicates folded into an equal atom
+    size_t links_removed = 0;    // links removed because they pointed at a forgotten atom
+    size_t links_repointed = 0;  // links rebuilt to point at a folded duplicate's survivor
+    size_t passes = 0;           // completed scans of the whole space
+};
+
+/**
+ * Forgetter - Bounds AgentSpace growth by forgetting unimportant atoms
+ *
+ * Only atoms of the configured types are considered. Each step scans the
+ * next batch of slots and forgets atoms whose LTI and VLTI both fell below
+ * their thresholds; with merging enabled, an atom equal in content and
+ * owner (MetaKey::OWNER) to one already seen in the pass is folded into
+ * it, reviving the survivor's truth value and keeping the higher attention.
+ * When a pass over the whole space completes, every type and owner over its
+ * quota loses its lowest-importance (LTI + VLTI) atoms. Links pointing at a
+ * forgotten atom are removed with it, so nothing is left dangling; links
+ * pointing at a folded duplicate are rebuilt against its survivor instead.
+ *
+ * start() runs steps on a background thread every config.interval; step()
+ * and runPass() drive it by hand.
+ */
+class Forgetter {
+private:
+    std::shared_ptr<AgentSpace> space_;
+    ForgettingConfig config_;
+    std::unordered_set<AtomType> types_;
+
+    // Pass state, guarded by step_mutex_
+    size_t cursor_ = 0;
+    std::unordered_map<std::string, AtomHandle> survivors_;  // merge key -> first atom seen
+    std::unordered_map<AtomType, std::vector<std::pair<double, AtomHandle>>> by_type_;
+    std::unordered_map<std::string, std::vector<std::pair<double, AtomHandle>>> by_owner_;
+    ForgettingStats stats_;
+    mutable std::mutex step_mutex_;
+
+    std::thread worker_;
+    bool stopping_ = false;
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+
+    void run();
+    // Removes the atom and, first, every link that points at it; returns
+    // false if it was already gone. Caller holds step_mutex_.
+    bool forget(AtomHandle handle);
+    // Rebuilds the links pointing at a duplicate against its survivor, then
+    // removes the duplicate. Caller holds step_mutex_.
+    bool fold(const AtomPtr& duplicate, const AtomPtr& survivor);
+    // Replaces `link` with a copy naming `to` where it named `from`, along
+    // with any links pointing at it; false if the link was left in place
+    bool repoint(const LinkPtr& link, const AtomPtr& from, const AtomPtr& to);
+    size_t enforceQuota(std::vector<std::pair<double, AtomHandle>>& atoms, size_t quota);
+
+public:
+    explicit Forgetter(std::shared_ptr<AgentSpace> space, const ForgettingConfig& config = ForgettingConfig());
+    ~Forgetter();
+    Forgetter(const Forgetter&) = delete;
+    Forgetter& operator=(const Forgetter&) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const { return worker_.joinable(); }
+
+    // Scans the next batch of slots, enforcing quotas when the pass ends;
+    // returns the atoms forgotten or merged
+    size_t step();
+    // Steps until the current pass completes
+    size_t runPass();
+
+    ForgettingStats getStats() const;
+    const ForgettingConfig& getConfig() const { return config_; }
+};
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "types.h"
+#include <unordered_set>
+
+namespace SwarmCog {
+
+class AgentSpace;
+class Link;
+
+/**
+ * GraphSpec - Which links make up a graph. Each link of a listed type
+ * contributes an edge from its first outgoing atom to each of the others;
+ * undirected graphs also get the reverse edges.
+ */
+struct GraphSpec {
+    std::vector<AtomType> link_types;
+    bool directed = false;
+
+    GraphSpec() = default;
+    GraphSpec(std::vector<AtomType> types, bool is_directed = false)
+        : link_types(std::move(types)), directed(is_directed) {}
+};
+
+/**
+ * AdjacencyGraph - Immutable compressed-sparse-row graph over link atoms
+ *
+ * Vertices are the atoms at the ends of the graph's links, numbered by the
+ * global slot of their handle, so a handle maps to its vertex without a
+ * lookup table; slots that are no vertex keep an empty row. Edges remember
+ * the link they came from. Traversals run level-synchronous and split large
+ * frontiers across worker threads; the graph is shared by every reader and
+ * never changes once built.
+ */
+class AdjacencyGraph {
+    friend class GraphIndex;
+
+public:
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+    static constexpr uint32_t kNoVertex = UINT32_MAX;
+
+    explicit AdjacencyGraph(const GraphConfig& config = GraphConfig(), bool directed = false)
+        : config_(config), directed_(directed), offsets_(1, 0) {}
+
+    // Slots covered, vertex or not, and edges (both directions of an undirected link count)
+    size_t getVertexCount() const { return generations_.size(); }
+    size_t getEdgeCount() const { return targets_.size(); }
+    bool isDirected() const { return directed_; }
+
+    bool contains(AtomHandle handle) const;
+    AtomHandle handleOf(uint32_t vertex) const;
+    size_t getDegree(uint32_t vertex) const {
+        return vertex < generations_.size() ? offsets_[vertex + 1] - offsets_[vertex] : 0;
+    }
+
+    // Calls visit(neighbor, link) for each edge leaving the atom
+    template<typename Visitor>
+    void forEachNeighbor(AtomHandle handle, Visitor&& visit) const {
+        if (!contains(handle)) return;
+        for (uint64_t e = offsets_[handle.slot()]; e < offsets_[handle.slot() + 1]; ++e) {
+            visit(handleOf(targets_[e]), links_[e]);
+        }
+    }
+
+    // Hop count from the nearest source to every vertex, indexed by vertex;
+    // kUnreachable past max_hops, for unreachable vertices and for non-vertices
+    std::vector<uint32_t> distances(const std::vector<AtomHandle>& sources, uint32_t max_hops = kUnreachable) const;
+    // Atoms within `hops` edges of the source, nearest first, without the source
+    std::vector<AtomHandle> neighborhood(AtomHandle source, uint32_t hops) const;
+    // Fewest-hop path including both ends; empty when `to` is unreachable
+    std::vector<AtomHandle> shortestPath(AtomHandle from, AtomHandle to) const;
+    // Label per vertex: the smallest vertex of its (weakly) connected
+    // component; kNoVertex for slots that are no vertex
+    std::vector<uint32_t> connectedComponents() const;
+    // Sparse matrix-vector product over the rows [begin, end): entry u - begin
+    // is the sum of values[v] over u's neighbours v, values indexed by vertex
+    std::vector<double> sumNeighbors(const std::vector<double>& values, uint32_t begin, uint32_t end) const;
+
+private:
+    struct Traversal {
+        std::vector<uint32_t> depth;    // per vertex
+        std::vector<uint32_t> visited;  // reached vertices in BFS order
+        std::vector<uint32_t> parent;   // per vertex, when requested
+    };
+
+    GraphConfig config_;
+    bool directed_;
+    std::vector<uint32_t> generations_;  // per slot; 0 where the slot is no vertex
+    std::vector<uint64_t> offsets_;      // row starts, one past the last slot too
+    std::vector<uint32_t> targets_;
+    std::vector<AtomHandle> links_;      // link behind each edge
+
+    Traversal traverse(const std::vector<AtomHandle>& sources, uint32_t max_hops,
+                       uint32_t stop_at, bool with_parents) const;
+    size_t workerCount(size_t items) const;
+};
+
+/**
+ * GraphIndex - Cache of adjacency graphs kept by an AgentSpace
+ *
+ * A graph is built from the space on first request and cached per spec.
+ * From then on the space reports link additions and removals, and removals
+ * of atoms at the ends of edges, which are journaled for each cached graph.
+ * The next request builds the new graph from the previous one and the
+ * journal without visiting the space; a journal grown past half the graph
+ * is dropped in favour of a fresh build.
+ *
+ * The space calls get() while holding its link-index lock exclusively, and
+ * the change hooks while holding it at least shared, which keeps the journal
+ * in step with what a fresh build would see. Hooks of concurrent link inserts
+ * are ordered by the index's own mutex. Hooks may run under shard locks,
+ * so fresh builds walk the space without holding that mutex.
+ */
+class GraphIndex {
+private:
+    struct Change {
+        enum Kind : uint8_t { LINK_ADDED, LINK_REMOVED, ATOM_REMOVED } kind;
+        AtomHandle handle;
+        std::vector<AtomHandle> endpoints;  // LINK_ADDED only; source first
+    };
+
+    struct Edge {
+        AtomHandle source;
+        AtomHandle target;
+        AtomHandle link;
+    };
+
+    struct Entry {
+        std::vector<AtomType> types;  // sorted
+        bool directed = false;
+        uint64_t type_mask = 0;
+        std::shared_ptr<const AdjacencyGraph> graph;
+        std::vector<Change> journal;
+    };
+
+    GraphConfig config_;
+    std::vector<Entry> entries_;
+    std::atomic<uint64_t> watched_types_{0};  // union of the entries' type masks
+    std::mutex mutex_;
+
+    static uint64_t typeBit(AtomType type) { return uint64_t(1) << static_cast<unsigned>(type); }
+    static std::vector<AtomHandle> endpointsOf(const Link& link);
+    static void appendEdges(const std::vector<AtomHandle>& endpoints, AtomHandle link, bool directed,
+                            std::vector<Edge>& edges);
+    Entry& entryFor(const std::vector<AtomType>& types, bool directed);
+    void record(Entry& entry, Change change);
+
+    // Fresh build from the space, and rebuild from the cached graph and journal
+    std::shared_ptr<const AdjacencyGraph> build(const std::vector<AtomType>& types, bool directed,
+                                                const AgentSpace& space) const;
+    std::shared_ptr<const AdjacencyGraph> rebuild(const Entry& entry) const;
+    // Lays out the rows: the edges of `previous` that survive the removals, then `added`
+    std::shared_ptr<const AdjacencyGraph> assemble(bool directed, const AdjacencyGraph* previous,
+                                                   const std::unordered_set<AtomHandle>& removed_atoms,
+                                                   const std::unordered_set<AtomHandle>& removed_links,
+                                                   const std::vector<Edge>& added) const;
+
+public:
+    explicit GraphIndex(const GraphConfig& config = GraphConfig()) : config_(config) {}
+    GraphIndex(const GraphIndex&) = delete;
+    GraphIndex& operator=(const GraphIndex&) = delete;
+
+    std::shared_ptr<const AdjacencyGraph> get(const GraphSpec& spec, const AgentSpace& space);
+
+    // Change hooks, called by the space
+    void linkAdded(const Link& link);
+    void linkRemoved(AtomHandle link, AtomType type);
+    void atomRemoved(AtomHandle atom);
+    void clear();
+};
+
+} // namespace SwarmCog
\ No newline at end of file
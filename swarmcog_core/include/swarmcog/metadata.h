@@ -0,0 +1,93 @@
+#pragma once
+
+#include "types.h"
+#include <variant>
+#include <optional>
+#include <deque>
+#include <unordered_map>
+
+namespace SwarmCog {
+
+using MetadataKeyId = uint32_t;
+
+// Typed metadata value; numbers and timestamps are stored unformatted
+using MetadataValue = std::variant<std::string, double, int64_t, Timestamp>;
+
+/**
+ * Keys used on hot paths, interned at fixed ids when the key table is built
+ */
+namespace MetaKey {
+    constexpr MetadataKeyId TYPE = 0;
+    constexpr MetadataKeyId CAPABILITIES = 1;
+    constexpr MetadataKeyId CREATION_TIME = 2;
+    constexpr MetadataKeyId CREATED_TIME = 3;
+    constexpr MetadataKeyId LAST_UPDATED = 4;
+    constexpr MetadataKeyId TRUST_LEVEL = 5;
+    constexpr MetadataKeyId MEMORY_TYPE = 6;
+    constexpr MetadataKeyId COLLABORATION_TYPE = 7;
+    constexpr MetadataKeyId RELATION = 8;
+    constexpr MetadataKeyId OWNER = 9;
+}
+
+/**
+ * MetadataKeys - Process-wide metadata key interning table
+ *
+ * Maps each distinct key string to a small integer id once, so atoms store
+ * and compare ids instead of strings. Interned names are never released.
+ */
+class MetadataKeys {
+private:
+    std::unordered_map<std::string, MetadataKeyId> ids_;
+    std::deque<std::string> names_;  // deque keeps references stable on growth
+    mutable std::shared_mutex mutex_;
+
+    MetadataKeys();
+    static MetadataKeys& instance();
+
+public:
+    static MetadataKeyId intern(const std::string& key);
+    // Returns false when the key has never been interned
+    static bool find(const std::string& key, MetadataKeyId& id);
+    static const std::string& name(MetadataKeyId id);
+};
+
+std::string metadataValueToString(const MetadataValue& value);
+
+/**
+ * AtomMetadata - Small flat map of (key id, value) pairs
+ *
+ * The first few entries live inline in the atom, which covers every atom the
+ * AgentSpace helpers create, and lookups are a short linear probe over
+ * integer keys. Further entries spill into a heap vector.
+ */
+class AtomMetadata {
+public:
+    static constexpr size_t kInlineCapacity = 3;
+
+    struct Entry {
+        MetadataKeyId key = 0;
+        MetadataValue value;
+    };
+
+    const MetadataValue* find(MetadataKeyId key) const;
+    void set(MetadataKeyId key, MetadataValue value);
+    size_t size() const { return inline_size_ + overflow_.size(); }
+    bool empty() const { return size() == 0; }
+
+    template<typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (size_t i = 0; i < inline_size_; ++i) {
+            visit(inline_[i].key, inline_[i].value);
+        }
+        for (const auto& entry : overflow_) {
+            visit(entry.key, entry.value);
+        }
+    }
+
+private:
+    Entry inline_[kInlineCapacity];
+    uint32_t inline_size_ = 0;
+    std::vector<Entry> overflow_;
+};
+
+} // namespace SwarmCog
\ No newline at end of file
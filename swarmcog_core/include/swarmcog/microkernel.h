@@ -2,6 +2,7 @@
 
 #include "types.h"
 #include "agentspace.h"
+#include "spreading.h"
 #include <queue>
 #include <condition_variable>
 #include <future>
@@ -91,6 +92,7 @@ class CognitiveMicrokernel {
 private:
     // Core components
     std::shared_ptr<AgentSpace> agentspace_;
+    std::shared_ptr<AttentionSpreader> spreader_;  // Set before processing starts
     ProcessingMode processing_mode_;
     double cycle_interval_; // seconds
     
@@ -172,6 +174,9 @@ public:
     ProcessingMode getProcessingMode() const { return processing_mode_; }
     void setCycleInterval(double seconds) { cycle_interval_ = seconds; }
     double getCycleInterval() const { return cycle_interval_; }
+    // Agents stimulate the memories they learn and take their focus from
+    // its active set; without one, focus is the space's top STI
+    void setAttentionSpreader(std::shared_ptr<AttentionSpreader> spreader) { spreader_ = std::move(spreader); }
 
 private:
     // Internal processing methods
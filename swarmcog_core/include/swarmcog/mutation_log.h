@@ -0,0 +1,119 @@
+#pragma once
+
+#include "types.h"
+#include "metadata.h"
+#include <condition_variable>
+#include <cstdio>
+
+namespace SwarmCog {
+
+class Atom;
+
+enum class MutationKind : uint8_t {
+    ADD_NODE = 1,
+    ADD_LINK = 2,
+    REMOVE = 3,
+    SET_TRUTH = 4,
+    SET_ATTENTION = 5,
+    SET_METADATA = 6,
+    CLEAR = 7,
+};
+
+// One decoded log record; fields a kind does not carry are left default
+struct MutationRecord {
+    MutationKind kind = MutationKind::CLEAR;
+    AtomId atom_id;
+    AtomType type = AtomType::NODE;
+    std::string name;
+    std::string value;              // node value
+    std::vector<AtomId> outgoing;   // link targets
+    TruthValue truth_value;
+    AttentionValue attention_value;
+    Timestamp timestamp;
+    std::vector<std::pair<std::string, MetadataValue>> metadata;  // by key name
+};
+
+/**
+ * MutationLog - Write-ahead log of AgentSpace mutations with group commit
+ *
+ * Mutating calls append a compact, checksummed binary record to an in-memory
+ * buffer and return immediately. A background flusher writes the buffer out
+ * and syncs it once per group, either when flush_interval elapses or when
+ * max_pending_bytes accumulate, so one fsync covers every record appended in
+ * the meantime. flush() waits for the records appended so far to be durable.
+ *
+ * Records name atoms by id and carry absolute values, so replaying a log
+ * over a snapshot taken while it was being written converges on the logged
+ * state. A torn record at the end of the file (a crash mid-write) ends replay;
+ * open() cuts such a tail off first, so records appended after a restart
+ * are not stranded behind it.
+ */
+class MutationLog {
+private:
+    std::string path_;
+    MutationLogConfig config_;
+    std::FILE* file_ = nullptr;
+
+    std::string pending_;  // encoded records not yet handed to the flusher
+    std::string writing_;  // flusher-owned buffer, swapped with pending_
+    uint64_t appended_ = 0;
+    uint64_t durable_ = 0;
+    uint64_t syncs_ = 0;
+    bool flush_requested_ = false;
+    bool stopping_ = false;
+    bool failed_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable flush_cv_;
+    std::condition_variable durable_cv_;
+
+    std::mutex file_mutex_;  // file_ and the files on disk
+    std::thread flusher_;
+
+    MutationLog(const std::string& path, const MutationLogConfig& config, std::FILE* file);
+    void flushLoop();
+    bool writeOut(const std::string& batch);
+
+    // Encoding straight into pending_; callers hold mutex_
+    size_t beginRecord(MutationKind kind, const AtomId& id);
+    void endRecord(size_t start);
+
+public:
+    ~MutationLog();
+    MutationLog(const MutationLog&) = delete;
+    MutationLog& operator=(const MutationLog&) = delete;
+
+    // Opens (or creates) the log for appending, truncating it to its last
+    // intact record; nullptr if the file cannot be opened or truncated
+    static std::shared_ptr<MutationLog> open(const std::string& path,
+                                             const MutationLogConfig& config = MutationLogConfig());
+
+    // Appends are buffered; none of them waits for I/O
+    void logAdd(const Atom& atom);
+    void logRemove(const AtomId& id);
+    void logTruthValue(const AtomId& id, const TruthValue& tv);
+    void logAttentionValue(const AtomId& id, const AttentionValue& av);
+    void logMetadata(const AtomId& id, MetadataKeyId key, const MetadataValue& value);
+    void logClear();
+
+    // Blocks until every record appended before the call is durable;
+    // returns false if any write or sync has failed
+    bool flush();
+
+    // Moves the records written so far to rotatedPath() and starts an empty
+    // log. The rotated file stays until discardRotated(), so a checkpoint can
+    // drop it once the snapshot covering it is on disk.
+    bool rotate();
+    void discardRotated();
+
+    const std::string& getPath() const { return path_; }
+    static std::string rotatedPath(const std::string& path) { return path + ".old"; }
+    uint64_t getAppendedCount() const;
+    uint64_t getDurableCount() const;
+    uint64_t getSyncCount() const;
+
+    // Decodes the records of one log file in order, stopping at the first
+    // torn or corrupt record; returns the number of records read
+    static size_t read(const std::string& path, const std::function<void(const MutationRecord&)>& visit);
+};
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "types.h"
+#include "metadata.h"
+
+namespace SwarmCog {
+
+class AgentSpaceSnapshot;
+
+/**
+ * PatternTerm - One outgoing position of a link pattern: either a named
+ * variable or a fixed atom
+ */
+struct PatternTerm {
+    std::string variable;  // empty for a fixed atom
+    AtomHandle atom;
+
+    PatternTerm(const char* name) : variable(name) {}
+    PatternTerm(const std::string& name) : variable(name) {}
+    PatternTerm(AtomHandle handle) : atom(handle) {}
+    template<typename T>
+    PatternTerm(const std::shared_ptr<T>& stored) : atom(handleOf(stored.get())) {}
+
+    bool isVariable() const { return !variable.empty(); }
+
+private:
+    static AtomHandle handleOf(const Atom* stored);
+};
+
+enum class LinkOrder {
+    ORDERED,    // outgoing positions must match in order
+    ANY_ORDER,  // binary links also match with their two ends swapped
+};
+
+/**
+ * PatternQuery - Declarative conjunctive query over atoms and links
+ *
+ * A query is a set of link clauses sharing variables, plus type, name,
+ * truth value and metadata constraints on those variables. For example,
+ * "agents trusted at 0.7 or more by X that collaborate with Y" is
+ *
+ *   PatternQuery()
+ *       .link(AtomType::TRUST_LINK, {x, "agent"}, "trust")
+ *       .link(AtomType::COLLABORATION_LINK, {"agent", y}, "", LinkOrder::ANY_ORDER)
+ *       .whereTruth("trust", 0.7);
+ *
+ * Execution runs over an AgentSpaceSnapshot. The planner orders the clauses
+ * greedily by estimated cost: expanding the incoming set of an atom that is
+ * already bound, scanning a variable's name or type index, or scanning all
+ * links of a type, whichever is the most selective at that point. When the
+ * first step yields many candidates they are split across threads.
+ * Predicates may therefore run concurrently and must be thread-safe.
+ */
+class PatternQuery {
+public:
+    using Predicate = std::function<bool(const Atom&)>;
+
+    // Constrains a variable to atoms of a type, and of a name when given
+    PatternQuery& node(const std::string& variable, AtomType type, const std::string& name = "");
+    // Requires a link of `type` whose outgoing set matches `outgoing`; the
+    // link itself is bound to link_variable when one is given
+    PatternQuery& link(AtomType type, std::vector<PatternTerm> outgoing,
+                       const std::string& link_variable = "", LinkOrder order = LinkOrder::ORDERED);
+    PatternQuery& where(const std::string& variable, Predicate predicate);
+    PatternQuery& whereTruth(const std::string& variable, double min_strength, double min_confidence = 0.0);
+    PatternQuery& whereMetadata(const std::string& variable, MetadataKeyId key,
+                                std::function<bool(const MetadataValue&)> predicate);
+    // First-step candidate count from which matching runs in parallel
+    PatternQuery& parallelThreshold(size_t candidates);
+
+    const std::vector<std::string>& getVariables() const { return variable_names_; }
+    // Describes the join order the planner picks against a snapshot
+    std::string explain(const AgentSpaceSnapshot& snapshot) const;
+
+private:
+    friend class PatternMatcher;
+
+    struct Variable {
+        bool typed = false;
+        AtomType type = AtomType::NODE;
+        std::string name;  // empty when unconstrained
+        std::vector<Predicate> predicates;
+    };
+
+    struct Term {
+        int variable = -1;  // -1 for a fixed atom
+        AtomHandle atom;
+    };
+
+    struct Clause {
+        AtomType type;
+        std::vector<Term> outgoing;
+        int link_variable = -1;
+        LinkOrder order = LinkOrder::ORDERED;
+    };
+
+    std::vector<std::string> variable_names_;
+    std::vector<Variable> variables_;
+    std::vector<Clause> clauses_;
+    size_t parallel_threshold_ = 4096;
+
+    int variableIndex(const std::string& variable);
+};
+
+/**
+ * QueryResult - Rows of variable bindings, one column per query variable
+ */
+class QueryResult {
+public:
+    QueryResult() = default;
+    QueryResult(std::vector<std::string> variables, std::vector<std::vector<AtomPtr>> rows)
+        : variables_(std::move(variables)), rows_(std::move(rows)) {}
+
+    size_t size() const { return rows_.size(); }
+    bool empty() const { return rows_.empty(); }
+    const std::vector<std::string>& getVariables() const { return variables_; }
+    const std::vector<AtomPtr>& row(size_t index) const { return rows_[index]; }
+
+    // nullptr for a variable the query does not have
+    AtomPtr get(size_t row, const std::string& variable) const;
+    // Every binding of one variable, in row order
+    std::vector<AtomPtr> column(const std::string& variable) const;
+
+private:
+    std::vector<std::string> variables_;
+    std::vector<std::vector<AtomPtr>> rows_;
+
+    int columnIndex(const std::string& variable) const;
+};
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "types.h"
+#include <cstring>
+#include <type_traits>
+
+namespace SwarmCog {
+
+/**
+ * SeqLock - Sequence-locked slot for a small trivially copyable value
+ *
+ * Readers never block and never write shared memory: they copy the value
+ * and retry if a writer was active meanwhile, which shows as an odd or
+ * changed sequence number. Writers claim the sequence with a
+ * compare-and-swap, which also orders them against each other. The value is
+ * held in relaxed atomic words, so a copy racing a write is well-defined and
+ * simply discarded.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values must be trivially copyable");
+
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> words_[kWords];
+
+    T loadWords() const {
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    void storeWords(const T& value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+public:
+    SeqLock() : SeqLock(T()) {}
+    explicit SeqLock(const T& value) { storeWords(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    T load() const {
+        uint64_t version;
+        return load(version);
+    }
+
+    // Also returns the version the copy is consistent with, for validate()
+    T load(uint64_t& version) const {
+        while (true) {
+            version = sequence_.load(std::memory_order_acquire);
+            if (version & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            T value = loadWords();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == version) return value;
+        }
+    }
+
+    // True while no write has started since load() returned `version`; lets a
+    // reader check that state it reached through the value is still current
+    bool validate(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence_.load(std::memory_order_relaxed) == version;
+    }
+
+    void store(const T& value) {
+        update([&value](T& current) { current = value; });
+    }
+
+    // Runs `modify` on the current value with other writers held off, then
+    // publishes the result and returns its version, for validate(). Readers
+    // spin until it returns, so keep it short.
+    template<typename Modify>
+    uint64_t update(Modify&& modify) {
+        uint64_t version = sequence_.load(std::memory_order_relaxed);
+        while ((version & 1) ||
+               !sequence_.compare_exchange_weak(version, version + 1, std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            if (version & 1) {
+                std::this_thread::yield();
+                version = sequence_.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        T value = loadWords();
+        modify(value);
+        storeWords(value);
+
+        sequence_.store(version + 2, std::memory_order_release);
+        return version + 2;
+    }
+};
+
+} // namespace SwarmCog
\ No newline at end of file
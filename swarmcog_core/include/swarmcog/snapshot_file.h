@@ -0,0 +1,146 @@
+#pragma once
+
+#include "types.h"
+#include "metadata.h"
+#include <string_view>
+
+namespace SwarmCog {
+
+class Atom;
+
+/**
+ * On-disk layout of an AgentSpace snapshot file (format version 1)
+ *
+ * The file is a header followed by 8-byte aligned sections. Every reference
+ * is a byte offset from the start of the file or an index into a table, so
+ * a mapping can be used in place at any address. Values are stored in host
+ * byte order, and the header records it so foreign files are rejected.
+ */
+namespace SnapshotFormat {
+
+constexpr char kMagic[8] = {'S', 'W', 'C', 'G', 'S', 'N', 'A', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kNoAtom = UINT32_MAX;
+constexpr size_t kTypeCount = static_cast<size_t>(AtomType::EVALUATION_LINK) + 1;
+
+struct StringRef {
+    uint64_t offset = 0;  // into the string pool
+    uint32_t length = 0;
+    uint32_t reserved = 0;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    StringRef space_name;
+    uint64_t atom_count;
+    uint64_t atoms_offset;           // AtomRecord[atom_count]
+    uint64_t outgoing_offset;        // uint32_t[outgoing_count], atom indices
+    uint64_t outgoing_count;
+    uint64_t incoming_begin_offset;  // uint32_t[atom_count + 1], CSR row starts
+    uint64_t incoming_offset;        // uint32_t[outgoing_count], link indices
+    uint64_t type_begin_offset;      // uint32_t[kTypeCount + 1], CSR row starts
+    uint64_t type_atoms_offset;      // uint32_t[atom_count], atoms grouped by type
+    uint64_t id_index_offset;        // uint32_t[id_index_capacity], open addressing
+    uint64_t id_index_capacity;      // power of two
+    uint64_t metadata_offset;        // MetadataRecord[metadata_count]
+    uint64_t metadata_count;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+
+enum RecordFlags : uint32_t {
+    kLinkRecord = 1u << 0,
+};
+
+// Atoms are written so that every link follows its targets
+struct AtomRecord {
+    uint32_t type;
+    uint32_t flags;
+    StringRef id;
+    StringRef name;
+    StringRef value;  // node value; empty for links
+    double strength;
+    double confidence;
+    double sti;
+    double lti;
+    double vlti;
+    int64_t timestamp;  // system_clock ticks since epoch
+    uint32_t outgoing_begin;
+    uint32_t outgoing_count;
+    uint32_t metadata_begin;
+    uint32_t metadata_count;
+};
+
+enum class MetadataKind : uint32_t {
+    STRING = 0,
+    NUMBER = 1,
+    INTEGER = 2,
+    TIMESTAMP = 3,
+};
+
+struct MetadataRecord {
+    StringRef key;
+    MetadataKind kind;
+    uint32_t reserved;
+    StringRef text;   // STRING values
+    int64_t scalar;   // INTEGER and TIMESTAMP values, or the bits of a NUMBER
+};
+
+// Stable across processes, unlike std::hash
+uint64_t hashString(std::string_view str);
+
+} // namespace SnapshotFormat
+
+// Writes `atoms` (targets before the links that use them) to `path`; true
+// only once the file and its directory entry have been synced to disk
+bool writeSnapshotFile(const std::string& path, const std::string& space_name,
+                       const std::vector<std::shared_ptr<Atom>>& atoms);
+
+/**
+ * MappedSnapshot - Read-only, zero-copy view of a snapshot file
+ *
+ * The file is mapped with mmap where available, so only the pages a query
+ * touches are ever read from disk. The id hash index, type index and link
+ * adjacency are used straight from the mapping without being rebuilt.
+ */
+class MappedSnapshot {
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;  // fallback when mmap is unavailable
+    const SnapshotFormat::Header* header_ = nullptr;
+
+    MappedSnapshot() = default;
+    bool validate(const std::string& path);
+
+    template<typename T>
+    const T* section(uint64_t offset) const { return reinterpret_cast<const T*>(data_ + offset); }
+
+public:
+    ~MappedSnapshot();
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    // Returns nullptr (and logs) if the file is missing, truncated or foreign
+    static std::shared_ptr<MappedSnapshot> open(const std::string& path);
+
+    std::string_view getSpaceName() const { return string(header_->space_name); }
+    size_t getAtomCount() const { return header_->atom_count; }
+    const SnapshotFormat::AtomRecord& atom(uint32_t index) const;
+    std::string_view string(const SnapshotFormat::StringRef& ref) const;
+
+    // Index lookups straight from the mapping
+    uint32_t findById(std::string_view id) const;  // kNoAtom when absent
+    std::pair<const uint32_t*, size_t> atomsOfType(AtomType type) const;
+    std::pair<const uint32_t*, size_t> outgoing(uint32_t index) const;
+    std::pair<const uint32_t*, size_t> incoming(uint32_t index) const;
+    std::pair<const SnapshotFormat::MetadataRecord*, size_t> metadata(uint32_t index) const;
+    MetadataValue metadataValue(const SnapshotFormat::MetadataRecord& record) const;
+};
+
+} // namespace SwarmCog
\ No newline at end of file
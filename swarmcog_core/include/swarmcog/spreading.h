@@ -0,0 +1,103 @@
+#pragma once
+
+#include "types.h"
+#include "agentspace.h"
+#include <condition_variable>
+
+namespace SwarmCog {
+
+struct SpreadingStats {
+    size_t stimuli = 0;  // stimulate() calls that reached a stored atom
+    size_t steps = 0;    // incremental steps run
+    size_t spread = 0;   // atoms that passed STI on, over all steps and sweeps
+    size_t sweeps = 0;   // completed sweeps over the whole graph
+};
+
+/**
+ * AttentionSpreader - ECAN-style spreading activation over AgentSpace links
+ *
+ * Stimulating an atom pays it a wage in STI. Atoms whose STI exceeds the
+ * diffusion threshold pass diffusion_rate of it on, split evenly over their
+ * neighbours in the (undirected) graph of the configured link types, and pay
+ * rent for doing so. Diffusion alone conserves STI; wages add it, rent and
+ * the space's decay take it away. Unlike full ECAN there is no central bank:
+ * wages and rent are fixed amounts rather than funds that must balance.
+ *
+ * Two ways to run it:
+ *  - step() spreads incrementally from the atoms stimulated or reached since
+ *    the last step, at most max_active of them (highest STI first). It reads
+ *    their neighbours from the space's incoming sets rather than the graph,
+ *    so its cost follows recent activity rather than the size of the space.
+ *  - sweepSlice() diffuses over every linked atom at once, as a sparse
+ *    matrix-vector product on the CSR adjacency graph split across worker
+ *    threads. STI is captured when a sweep starts, and each call applies
+ *    the product for the next slice_size atoms, bounding the time per call.
+ *
+ * start() runs a step, and a sweep slice when slice_size is set, on a
+ * background thread every config.interval.
+ */
+class AttentionSpreader {
+private:
+    std::shared_ptr<AgentSpace> space_;
+    SpreadingConfig config_;
+    GraphSpec spec_;
+
+    // Atoms due to spread in the next step, and those the last one took up,
+    // whether or not they had edges to spread along; guarded by pending_mutex_
+    std::unordered_set<AtomHandle> pending_;
+    std::vector<AtomHandle> recent_;
+    mutable std::mutex pending_mutex_;
+    std::atomic<size_t> stimuli_{0};
+
+    // Sweep state and statistics, guarded by step_mutex_
+    std::shared_ptr<const AdjacencyGraph> sweep_graph_;
+    std::vector<double> sweep_shares_;  // per vertex: STI sent along each edge
+    std::vector<double> sweep_sti_;     // per vertex, as captured
+    uint32_t sweep_cursor_ = 0;
+    SpreadingStats stats_;
+    mutable std::mutex step_mutex_;
+
+    std::thread worker_;
+    bool stopping_ = false;
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+
+    void run();
+    // STI an atom holding `sti` sends out in total, and the rent it then pays
+    double outflow(double sti, size_t degree) const;
+    double rentFor(double sti, double sent) const;
+    // Neighbours along the configured links, once per edge, read from the
+    // space's incoming sets
+    std::vector<AtomHandle> neighborsOf(AtomHandle handle) const;
+
+public:
+    explicit AttentionSpreader(std::shared_ptr<AgentSpace> space, const SpreadingConfig& config = SpreadingConfig());
+    ~AttentionSpreader();
+    AttentionSpreader(const AttentionSpreader&) = delete;
+    AttentionSpreader& operator=(const AttentionSpreader&) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const { return worker_.joinable(); }
+
+    // Pays wage * stimulus into the atom's STI and queues it to spread;
+    // false if the atom is not stored
+    bool stimulate(AtomHandle handle, double stimulus = 1.0);
+
+    // Spreads from the pending atoms; returns how many passed STI on
+    size_t step();
+    // Applies the sweep to its next slice of atoms, starting a new sweep
+    // when none is under way; true once the sweep is complete
+    bool sweepSlice();
+    // Finishes the sweep under way, or runs a whole new one
+    void runSweep();
+
+    // Up to `limit` stored atoms that are pending or were taken up by the
+    // last step, highest STI first
+    std::vector<AtomHandle> getActiveAtoms(size_t limit) const;
+
+    SpreadingStats getStats() const;
+    const SpreadingConfig& getConfig() const { return config_; }
+};
+
+} // namespace SwarmCog
\ No newline at end of file
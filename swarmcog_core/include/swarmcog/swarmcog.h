@@ -4,6 +4,8 @@
 #include "agentspace.h"
 #include "microkernel.h"
 #include "cognitive_agent.h"
+#include "forgetting.h"
+#include "spreading.h"
 
 namespace SwarmCog {
 
@@ -94,9 +96,12 @@ private:
     // Core components
     std::shared_ptr<AgentSpace> agentspace_;
     std::shared_ptr<CognitiveMicrokernel> microkernel_;
+    std::unique_ptr<Forgetter> forgetter_;  // Runs while autonomous processing is on
+    std::shared_ptr<AttentionSpreader> spreader_;  // Likewise; also drives the microkernel's focus
     
     // Agent management
     std::unordered_map<AgentId, std::shared_ptr<CognitiveAgent>> cognitive_agents_;
+    std::unordered_map<AtomHandle, AgentId> agents_by_node_;  // Agent node -> agent, for registry lookups
     mutable std::shared_mutex agents_mutex_;
     
     // Task management
@@ -168,6 +173,8 @@ public:
     
     std::vector<AgentId> findAgentsByCapability(const std::string& capability) const;
     std::vector<AgentId> getConnectedAgents(const AgentId& agent_id) const;
+    // Pays the atom attention and lets it spread to related atoms (see spreading.h)
+    bool stimulateAtom(const AtomId& atom_id, double stimulus = 1.0);
     double getSwarmCohesion() const;
     
     // System monitoring
@@ -11,6 +11,7 @@
 #include <thread>
 #include <shared_mutex>
 #include <algorithm>
+#include <cstdint>
 
 namespace SwarmCog {
 
@@ -26,6 +27,28 @@ using AtomId = std::string;
 using AgentId = std::string;
 using Timestamp = std::chrono::system_clock::time_point;
 
+/**
+ * AtomHandle - compact 64-bit key for atoms stored in an AgentSpace
+ * Low 32 bits hold the slot index, high 32 bits the slot generation.
+ * Generation 0 is never issued, so a default-constructed handle is invalid.
+ */
+struct AtomHandle {
+    uint64_t value = 0;
+    
+    constexpr AtomHandle() = default;
+    constexpr explicit AtomHandle(uint64_t raw) : value(raw) {}
+    constexpr AtomHandle(uint32_t slot, uint32_t generation)
+        : value((static_cast<uint64_t>(generation) << 32) | slot) {}
+    
+    constexpr uint32_t slot() const { return static_cast<uint32_t>(value); }
+    constexpr uint32_t generation() const { return static_cast<uint32_t>(value >> 32); }
+    constexpr bool isValid() const { return generation() != 0; }
+    
+    constexpr bool operator==(const AtomHandle& other) const { return value == other.value; }
+    constexpr bool operator!=(const AtomHandle& other) const { return value != other.value; }
+    constexpr bool operator<(const AtomHandle& other) const { return value < other.value; }
+};
+
 // Enumerations
 enum class AtomType {
     NODE,
@@ -69,6 +92,14 @@ struct TruthValue {
     bool operator==(const TruthValue& other) const {
         return std::abs(strength - other.strength) < 1e-6 && std::abs(confidence - other.confidence) < 1e-6;
     }
+    
+    // Confidence-weighted revision with an independent estimate of the same fact
+    TruthValue revise(const TruthValue& other) const {
+        double total = confidence + other.confidence;
+        if (total <= 0.0) return *this;
+        return TruthValue((strength * confidence + other.strength * other.confidence) / total,
+                          confidence + other.confidence - confidence * other.confidence);
+    }
 };
 
 struct AttentionValue {
@@ -106,6 +137,89 @@ struct CognitiveState {
 };
 
 // Configuration structures
+struct AtomArenaConfig {
+    size_t slab_size = 64 * 1024;  // bytes per slab
+    bool use_huge_pages = false;   // back slabs with 2MB pages where the OS supports it
+    size_t stripes = 0;            // independently locked pools; 0 uses the hardware concurrency
+    
+    AtomArenaConfig() = default;
+};
+
+struct GraphConfig {
+    size_t threads = 0;  // Workers for traversals; 0 uses the hardware concurrency
+    size_t parallel_threshold = 4096;  // Smallest frontier or vertex range split across workers
+    
+    GraphConfig() = default;
+};
+
+struct EmbeddingConfig {
+    size_t dimensions = 0;  // Vector length; 0 takes it from the first embedding stored
+    size_t max_neighbors = 16;  // HNSW links per node on each upper layer, twice that on layer 0
+    size_t ef_construction = 100;  // Search width when linking a new vector
+    size_t ef_search = 64;  // Default search width for queries
+    uint64_t seed = 42;  // Layer assignment; fixed so the same inserts build the same graph
+    
+    EmbeddingConfig() = default;
+};
+
+struct AgentSpaceConfig {
+    AtomArenaConfig arena;
+    GraphConfig graph;
+    EmbeddingConfig embedding;
+    size_t num_shards = 1;  // >1 enables lock-striped sharded mode
+    bool hash_consing = false;  // Deduplicate nodes by (type, name, value) and links by (type, outgoing)
+    size_t attention_sweep_interval = 0;  // Decay ticks between sweeps bringing slots current; 0 never sweeps
+    std::vector<std::string> metadata_indices = {"owner", "memory_type", "relation", "collaboration_type"};
+    
+    AgentSpaceConfig() = default;
+};
+
+struct ForgettingConfig {
+    bool enabled = true;  // Run alongside autonomous processing
+    std::vector<AtomType> types = {AtomType::MEMORY_NODE};  // Only these are ever forgotten
+    double min_lti = 0.05;   // Atoms with LTI and VLTI both below these are forgotten
+    double min_vlti = 0.05;
+    std::map<AtomType, size_t> type_quotas;  // Most atoms kept per type
+    size_t agent_quota = 256;  // Most atoms kept per owning agent; 0 for no limit
+    bool merge_duplicates = true;  // Collapse equal-content atoms of one owner
+    size_t batch_size = 1024;  // Slots scanned per shard in each step
+    std::chrono::milliseconds interval{100};  // Pause between background steps
+    
+    ForgettingConfig() = default;
+};
+
+struct SpreadingConfig {
+    bool enabled = true;  // Run alongside autonomous processing
+    std::vector<AtomType> link_types = {AtomType::COLLABORATION_LINK, AtomType::DELEGATION_LINK,
+                                        AtomType::TRUST_LINK, AtomType::KNOWLEDGE_LINK,
+                                        AtomType::EVALUATION_LINK};  // STI flows both ways along these
+    double diffusion_rate = 0.2;  // Share of a spreading atom's STI passed on per step, split over its neighbours
+    double diffusion_threshold = 0.1;  // Atoms at or below this STI do not spread
+    double rent = 0.01;  // STI each spreading atom pays per step
+    double wage = 0.5;  // STI paid per unit of stimulus
+    double min_activation = 0.01;  // Smallest gain that makes an atom spread in the next incremental step
+    size_t max_active = 4096;  // Most atoms spreading in one incremental step; the rest wait their turn
+    size_t slice_size = 0;  // Atoms per background sweep slice; 0 runs incremental steps only
+    std::chrono::milliseconds interval{100};  // Pause between background steps
+    
+    SpreadingConfig() = default;
+};
+
+struct SubscriptionConfig {
+    size_t capacity = 4096;  // Events buffered per subscriber, rounded up to a power of two
+    size_t max_batch = 256;  // Most events handed to the handler in one call
+    
+    SubscriptionConfig() = default;
+};
+
+struct MutationLogConfig {
+    std::chrono::milliseconds flush_interval{10};  // longest a record waits for its group commit
+    size_t max_pending_bytes = 1024 * 1024;       // pending bytes that trigger an early flush
+    bool sync = true;  // fsync each group; without it records survive a crash but not power loss
+    
+    MutationLogConfig() = default;
+};
+
 struct SwarmCogConfig {
     ProcessingMode processing_mode = ProcessingMode::ASYNCHRONOUS;
     double cognitive_cycle_interval = 1.0;  // seconds
@@ -113,6 +227,9 @@ struct SwarmCogConfig {
     bool enable_distributed_processing = false;
     std::string log_level = "INFO";
     std::string agentspace_name = "swarmcog_space";
+    AgentSpaceConfig agentspace_config;
+    ForgettingConfig forgetting;
+    SpreadingConfig spreading;
     
     SwarmCogConfig() = default;
 };
@@ -137,4 +254,14 @@ using NodePtr = std::shared_ptr<Node>;
 using LinkPtr = std::shared_ptr<Link>;
 using AgentPtr = std::shared_ptr<CognitiveAgent>;
 
-} // namespace SwarmCog
\ No newline at end of file
+} // namespace SwarmCog
+
+namespace std {
+template<>
+struct hash<SwarmCog::AtomHandle> {
+    size_t operator()(const SwarmCog::AtomHandle& handle) const noexcept {
+        // Fibonacci mix so sequential slots spread across buckets
+        return static_cast<size_t>(handle.value * 0x9E3779B97F4A7C15ULL);
+    }
+};
+} // namespace std
\ No newline at end of file
@@ -14,9 +14,9 @@ namespace Utils {
  */
 class UUIDGenerator {
 private:
-    static std::random_device rd_;
-    static std::mt19937 gen_;
-    static std::uniform_int_distribution<> dis_;
+    // One engine per thread, so atoms created concurrently in sharded spaces
+    // never wait on each other for an id
+    static std::mt19937& engine();
 
 public:
     static std::string generate();
@@ -150,6 +150,7 @@ public:
     static void setLogLevel(LogLevel level) { current_level_ = level; }
     static void enableConsoleOutput(bool enabled) { enable_console_output_ = enabled; }
     static void setLogFile(const std::string& file_path) { log_file_path_ = file_path; }
+    static bool isEnabled(LogLevel level) { return level >= current_level_; }
     
     static void debug(const std::string& message);
     static void info(const std::string& message);
@@ -1,79 +1,251 @@
 #include "swarmcog/agentspace.h"
 #include "swarmcog/utils.h"
+#include "swarmcog/snapshot_file.h"
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <thread>
+#include <fstream>
+#include <condition_variable>
 
 namespace SwarmCog {
 
 // Atom Implementation
 Atom::Atom(AtomType type, const std::string& name) 
-    : type_(type), timestamp_(std::chrono::system_clock::now()) {
-    id_ = generateId();
-    name_ = name.empty() ? ("atom_" + id_.substr(0, 8)) : name;
+    : type_(type), name_(name), timestamp_(std::chrono::system_clock::now()) {
+    // Named atoms defer their id until something asks for it
+    if (name_.empty()) {
+        name_ = "atom_" + getId().substr(0, 8);
+    }
+}
+
+Atom::~Atom() {
+    delete cold_.load();
 }
 
 std::string Atom::generateId() {
     return Utils::UUIDGenerator::generate();
 }
 
+const AtomId& Atom::getId() const {
+    std::call_once(id_once_, [this] { id_ = generateId(); });
+    return id_;
+}
+
+void Atom::assignId(const AtomId& id) {
+    std::call_once(id_once_, [] {});
+    id_ = id;
+}
+
 TruthValue Atom::getTruthValue() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return truth_value_;
+    return truth_value_.load();
 }
 
 void Atom::setTruthValue(const TruthValue& tv) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    truth_value_ = tv;
+    uint64_t version = truth_value_.update([&](TruthValue& current) { current = tv; });
+    announceTruthValue(tv, version);
+}
+
+void Atom::reviseTruthValue(const TruthValue& other) {
+    TruthValue revised;
+    uint64_t version = truth_value_.update([&](TruthValue& current) {
+        current = current.revise(other);
+        revised = current;
+    });
+    announceTruthValue(revised, version);
 }
 
 AttentionValue Atom::getAttentionValue() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return attention_value_;
+    uint64_t version;
+    return loadAttentionValue(version);
+}
+
+AttentionValue Atom::loadAttentionValue(uint64_t& version) const {
+    while (true) {
+        AttentionBinding binding = attention_.load(version);
+        if (!binding.columns) return binding.detached;
+        
+        // The slot may have been unbound and reused since the binding was read
+        AttentionValue av = binding.columns->load(binding.slot);
+        if (attention_.validate(version)) return av;
+    }
 }
 
 void Atom::setAttentionValue(const AttentionValue& av) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    attention_value_ = av;
+    uint64_t version = attention_.update([&](AttentionBinding& binding) {
+        if (binding.columns) {
+            binding.columns->store(binding.slot, av);
+        } else {
+            binding.detached = av;
+        }
+    });
+    announceAttentionValue(av, version);
+}
+
+// A racing setter can reach the log after this one with an older value, so
+// each setter re-logs until what it logged is still current: whichever
+// record lands last then holds the newest value.
+void Atom::announceTruthValue(TruthValue tv, uint64_t version) {
+    ++announcing_;
+    if (MutationLog* log = mutation_log_.load()) {
+        while (true) {
+            log->logTruthValue(getId(), tv);
+            if (truth_value_.validate(version)) break;
+            tv = truth_value_.load(version);
+        }
+    }
+    if (AgentSpace* space = space_.load()) space->change_feed_.publish(ChangeKind::TRUTH_UPDATED, *this);
+    --announcing_;
+}
+
+void Atom::announceAttentionValue(AttentionValue av, uint64_t version) {
+    ++announcing_;
+    if (MutationLog* log = mutation_log_.load()) {
+        while (true) {
+            log->logAttentionValue(getId(), av);
+            if (attention_.validate(version)) break;
+            av = loadAttentionValue(version);
+        }
+    }
+    if (AgentSpace* space = space_.load()) space->change_feed_.publish(ChangeKind::ATTENTION_UPDATED, *this);
+    --announcing_;
+}
+
+void Atom::attachToSpace(AttentionColumns& columns, uint32_t slot, MutationLog* log, AgentSpace* space) {
+    attention_.update([&](AttentionBinding& binding) {
+        columns.bind(slot, binding.detached);
+        binding.columns = &columns;
+        binding.slot = slot;
+    });
+    mutation_log_.store(log);
+    space_.store(space);
+}
+
+void Atom::detachFromSpace() {
+    mutation_log_.store(nullptr);
+    space_.store(nullptr);
+    
+    // Keep the latest value with the atom once it leaves the space
+    attention_.update([](AttentionBinding& binding) {
+        if (!binding.columns) return;
+        binding.detached = binding.columns->unbind(binding.slot);
+        binding.columns = nullptr;
+    });
+    drainWriters();
+    owner_.store(nullptr);
+}
+
+void Atom::setMutationLog(MutationLog* log) {
+    mutation_log_.store(log);
+    drainWriters();
+}
+
+void Atom::drainWriters() {
+    // Setters read the pointers only while counted in announcing_, so once
+    // it drops to zero after they were unset none can still hold an old one
+    while (announcing_.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (ColdState* cold = cold_.load()) {
+        std::lock_guard<std::mutex> lock(cold->mutex);
+    }
 }
 
-void Atom::setName(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    name_ = name;
+Atom::ColdState& Atom::cold() const {
+    ColdState* cold = cold_.load();
+    if (cold) return *cold;
+    
+    auto* fresh = new ColdState();
+    if (cold_.compare_exchange_strong(cold, fresh)) return *fresh;
+    delete fresh;  // another thread installed one first
+    return *cold;
 }
 
 void Atom::setMetadata(const std::string& key, const std::string& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    metadata_[key] = value;
+    setMetadata(MetadataKeys::intern(key), MetadataValue(value));
+}
+
+void Atom::setMetadata(MetadataKeyId key, MetadataValue value) {
+    AgentSpace* space;
+    {
+        ColdState& state = cold();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        space = space_.load();
+        if (!space) {
+            storeMetadataLocked(key, std::move(value));
+            return;
+        }
+    }
+    
+    // Stored atoms go through their space, which keeps its metadata indices current
+    space->setAtomMetadata(*this, key, std::move(value));
+}
+
+std::optional<MetadataValue> Atom::storeMetadataLocked(MetadataKeyId key, MetadataValue value) {
+    AtomMetadata& metadata = cold().metadata;
+    const MetadataValue* current = metadata.find(key);
+    std::optional<MetadataValue> previous = current ? std::optional<MetadataValue>(*current) : std::nullopt;
+    
+    if (MutationLog* log = mutation_log_.load()) log->logMetadata(getId(), key, value);
+    metadata.set(key, std::move(value));
+    if (AgentSpace* space = space_.load()) space->change_feed_.publish(ChangeKind::METADATA_UPDATED, *this, nullptr, key);
+    return previous;
 }
 
 std::string Atom::getMetadata(const std::string& key) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = metadata_.find(key);
-    return (it != metadata_.end()) ? it->second : "";
+    // Lookups never intern: a key nobody has set cannot be on any atom
+    MetadataKeyId id;
+    return MetadataKeys::find(key, id) ? getMetadata(id) : "";
+}
+
+std::string Atom::getMetadata(MetadataKeyId key) const {
+    auto value = getMetadataValue(key);
+    return value ? metadataValueToString(*value) : "";
+}
+
+std::optional<MetadataValue> Atom::getMetadataValue(MetadataKeyId key) const {
+    ColdState* cold = cold_.load();
+    if (!cold) return std::nullopt;
+    
+    std::lock_guard<std::mutex> lock(cold->mutex);
+    const MetadataValue* value = cold->metadata.find(key);
+    return value ? std::optional<MetadataValue>(*value) : std::nullopt;
+}
+
+std::vector<AtomMetadata::Entry> Atom::getMetadataEntries() const {
+    std::vector<AtomMetadata::Entry> entries;
+    ColdState* cold = cold_.load();
+    if (!cold) return entries;
+    
+    std::lock_guard<std::mutex> lock(cold->mutex);
+    entries.reserve(cold->metadata.size());
+    cold->metadata.forEach([&entries](MetadataKeyId key, const MetadataValue& value) {
+        entries.push_back({key, value});
+    });
+    return entries;
 }
 
 std::string Atom::toString() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return "Atom(" + id_ + ", " + name_ + ", " + std::to_string(static_cast<int>(type_)) + ")";
+    return "Atom(" + getId() + ", " + name_ + ", " + std::to_string(static_cast<int>(type_)) + ")";
 }
 
 std::map<std::string, std::string> Atom::toDict() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::map<std::string, std::string> result;
-    result["id"] = id_;
+    result["id"] = getId();
     result["type"] = std::to_string(static_cast<int>(type_));
     result["name"] = name_;
-    result["truth_strength"] = std::to_string(truth_value_.strength);
-    result["truth_confidence"] = std::to_string(truth_value_.confidence);
-    result["attention_sti"] = std::to_string(attention_value_.sti);
-    result["attention_lti"] = std::to_string(attention_value_.lti);
-    result["attention_vlti"] = std::to_string(attention_value_.vlti);
+    TruthValue tv = getTruthValue();
+    result["truth_strength"] = std::to_string(tv.strength);
+    result["truth_confidence"] = std::to_string(tv.confidence);
+    AttentionValue av = getAttentionValue();
+    result["attention_sti"] = std::to_string(av.sti);
+    result["attention_lti"] = std::to_string(av.lti);
+    result["attention_vlti"] = std::to_string(av.vlti);
     result["timestamp"] = Utils::TimeUtils::timestampToString(timestamp_);
     
     // Add metadata
-    for (const auto& pair : metadata_) {
-        result["meta_" + pair.first] = pair.second;
+    for (const auto& entry : getMetadataEntries()) {
+        result["meta_" + MetadataKeys::name(entry.key)] = metadataValueToString(entry.value);
     }
     
     return result;
@@ -84,8 +256,7 @@ Node::Node(AtomType type, const std::string& name, const std::string& value)
     : Atom(type, name), value_(value) {}
 
 std::string Node::toString() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return "Node(" + id_ + ", " + name_ + ", " + value_ + ")";
+    return "Node(" + getId() + ", " + name_ + ", " + value_ + ")";
 }
 
 std::map<std::string, std::string> Node::toDict() const {
@@ -112,9 +283,8 @@ void Link::removeOutgoing(const AtomPtr& atom) {
 }
 
 std::string Link::toString() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::ostringstream oss;
-    oss << "Link(" << id_ << ", " << name_ << ", [";
+    oss << "Link(" << getId() << ", " << name_ << ", [";
     for (size_t i = 0; i < outgoing_.size(); ++i) {
         if (i > 0) oss << ", ";
         oss << (outgoing_[i] ? outgoing_[i]->getName() : "null");
@@ -138,72 +308,234 @@ std::map<std::string, std::string> Link::toDict() const {
 }
 
 // AgentSpace Implementation
-AgentSpace::AgentSpace(const std::string& name) : name_(name) {
-    Utils::Logger::info("Created AgentSpace: " + name_);
+
+// Space whose addAtoms batch is running on this thread, holding every lock
+static thread_local const AgentSpace* t_batch_space = nullptr;
+
+// Atoms an opened snapshot inserts per batch, and so per hold of every lock
+static constexpr uint32_t kSnapshotChunk = 1024;
+
+struct AgentSpace::SnapshotLoad {
+    std::string path;
+    std::shared_ptr<MappedSnapshot> file;  // released once loaded
+    std::vector<AtomPtr> atoms;            // by file index, once created
+    bool failed = false;
+    std::mutex mutex;                      // guards the fields above
+    std::condition_variable done_cv;
+    std::atomic<size_t> remaining{0};      // file atoms not yet inserted
+    std::atomic<bool> done{false};
+    std::atomic<bool> stopping{false};
+    std::once_flag stop_once;
+    std::thread loader;
+};
+
+// Splits the comma-separated CAPABILITIES metadata, dropping empty entries
+static std::vector<std::string> parseCapabilities(const std::string& csv) {
+    std::vector<std::string> capabilities;
+    for (const auto& entry : Utils::StringUtils::split(csv, ',')) {
+        std::string capability = Utils::StringUtils::trim(entry);
+        if (!capability.empty()) capabilities.push_back(std::move(capability));
+    }
+    return capabilities;
+}
+
+AgentSpace::AgentSpace(const std::string& name, const AgentSpaceConfig& config)
+    : name_(name), config_(config), arena_(std::make_shared<AtomArena>(config.arena)),
+      graph_index_(config.graph), embedding_index_(config.embedding) {
+    if (config_.num_shards == 0) {
+        config_.num_shards = 1;
+    }
+    
+    shards_.reserve(config_.num_shards);
+    for (size_t i = 0; i < config_.num_shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    
+    for (const auto& key : config_.metadata_indices) {
+        createMetadataIndex(MetadataKeys::intern(key));
+    }
+    
+    Utils::Logger::info("Created AgentSpace: " + name_ + 
+                        (config_.num_shards > 1 ? " (" + std::to_string(config_.num_shards) + " shards)" : ""));
+}
+
+AgentSpace::~AgentSpace() {
+    stopSnapshotLoad();
+    change_feed_.stop();
+    
+    // Atoms may outlive the space; hand their attention values back first
+    for (auto& shard : shards_) {
+        for (auto& slot : shard->slots) {
+            if (slot.atom) {
+                slot.atom->detachFromSpace();
+                slot.atom->handle_.store(AtomHandle(), std::memory_order_release);
+            }
+        }
+    }
+}
+
+NodePtr AgentSpace::createNode(AtomType type, const std::string& name, const std::string& value) {
+    return allocateAtom<Node>(arena_, type, name, value);
+}
+
+LinkPtr AgentSpace::createLink(AtomType type, const std::vector<AtomPtr>& outgoing, const std::string& name) {
+    return allocateAtom<Link>(arena_, type, outgoing, name);
 }
 
 AtomPtr AgentSpace::addAtom(AtomPtr atom) {
     if (!atom) return nullptr;
     
-    std::unique_lock<std::shared_mutex> lock(atoms_mutex_);
+    auto link = std::dynamic_pointer_cast<Link>(atom);
+    
+    // Plain nodes only contend on their home shard; links also update the
+    // incoming sets of their targets, which may live in other shards, under
+    // those shards' locks. The shared link-index lock only keeps removals and
+    // whole-space reads from seeing the insert half done.
+    std::shared_lock<std::shared_mutex> link_lock(link_index_mutex_, std::defer_lock);
+    if (link) {
+        link_lock.lock();
+    }
+    
+    AtomPtr stored = insertAtom(atom, link, selectHomeShard());
+    
+    if (stored == atom && Utils::Logger::isEnabled(Utils::LogLevel::DEBUG)) {
+        Utils::Logger::debug("Added atom: " + atom->toString());
+    }
+    return stored;
+}
+
+std::vector<AtomPtr> AgentSpace::addAtoms(const std::vector<AtomPtr>& atoms) {
+    std::vector<AtomPtr> result;
+    result.reserve(atoms.size());
+    if (atoms.empty()) return result;
+    
+    // Lock order as in clear(): link index, then every shard in index order
+    std::unique_lock<std::shared_mutex> link_lock(link_index_mutex_);
+    std::vector<std::unique_lock<std::shared_mutex>> shard_locks;
+    shard_locks.reserve(shards_.size());
+    for (auto& shard : shards_) {
+        shard_locks.emplace_back(shard->mutex);
+    }
+    
+    // Size every shard's tables for its share of the batch up front
+    size_t per_shard = atoms.size() / shards_.size() + 1;
+    for (auto& shard : shards_) {
+        shard->slots.reserve(shard->slots.size() + per_shard);
+        shard->atom_aliases.reserve(shard->atom_aliases.size() + per_shard);
+        shard->atoms_by_name.reserve(shard->atoms_by_name.size() + per_shard);
+    }
+    
+    t_batch_space = this;
+    
+    size_t added = 0;
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        const auto& atom = atoms[i];
+        if (!atom) {
+            result.push_back(nullptr);
+            continue;
+        }
+        
+        // Round-robin placement keeps a large batch from piling onto one shard
+        AtomPtr stored = insertAtom(atom, std::dynamic_pointer_cast<Link>(atom), i % shards_.size());
+        if (stored == atom) ++added;
+        result.push_back(std::move(stored));
+    }
+    
+    t_batch_space = nullptr;
     
-    const AtomId& id = atom->getId();
-    atoms_[id] = atom;
+    if (Utils::Logger::isEnabled(Utils::LogLevel::DEBUG)) {
+        Utils::Logger::debug("Added batch of " + std::to_string(added) + " atoms to " + name_);
+    }
+    return result;
+}
+
+AtomPtr AgentSpace::insertAtom(const AtomPtr& atom, const LinkPtr& link, size_t preferred_shard) {
+    // An atom lives in one space at a time. Claiming it settles two spaces
+    // racing to insert it; re-adding an atom already here is a no-op.
+    const AgentSpace* owner = nullptr;
+    if (!atom->owner_.compare_exchange_strong(owner, this)) {
+        if (owner == this) return atom;
+        Utils::Logger::warning("Cannot add an atom stored in another space: " + atom->getId());
+        return nullptr;
+    }
+    
+    // Hash-consed atoms live in the shard their content key selects
+    uint64_t content_key = config_.hash_consing ? contentKey(atom) : 0;
+    size_t home_shard = content_key ? content_key % shards_.size() : preferred_shard;
+    
+    AtomPtr canonical = insertIntoShard(atom, home_shard, content_key);
+    if (canonical != atom) {
+        atom->owner_.store(nullptr);  // merged or refused, so never stored here
+        return canonical;
+    }
     addAtomToIndices(atom);
-    atom_counter_.increment();
     
-    Utils::Logger::debug("Added atom: " + atom->toString());
+    if (link) {
+        addToIncomingSets(link);
+        indexTrustLink(link);
+        graph_index_.linkAdded(*link);
+    }
+    
+    atom_counter_.increment();
     return atom;
 }
 
 bool AgentSpace::removeAtom(const AtomId& id) {
-    std::unique_lock<std::shared_mutex> lock(atoms_mutex_);
-    
-    auto it = atoms_.find(id);
-    if (it == atoms_.end()) {
+    if (!eraseAtom(resolveAlias(id))) {
         return false;
     }
     
-    AtomPtr atom = it->second;
-    removeAtomFromIndices(atom);
-    atoms_.erase(it);
-    
     Utils::Logger::debug("Removed atom: " + id);
     return true;
 }
 
+bool AgentSpace::removeAtom(AtomHandle handle) {
+    return eraseAtom(handle);
+}
+
 AtomPtr AgentSpace::getAtom(const AtomId& id) const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
-    
-    auto it = atoms_.find(id);
-    return (it != atoms_.end()) ? it->second : nullptr;
+    return lookupAtom(resolveAlias(id));
+}
+
+AtomPtr AgentSpace::getAtom(AtomHandle handle) const {
+    return lookupAtom(handle);
+}
+
+AtomHandle AgentSpace::getHandle(const AtomId& id) const {
+    return resolveAlias(id);
 }
 
 std::vector<AtomPtr> AgentSpace::getAtoms() const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
-    
+    waitForSnapshot();
     std::vector<AtomPtr> result;
-    result.reserve(atoms_.size());
+    result.reserve(getAtomCount());
     
-    for (const auto& pair : atoms_) {
-        result.push_back(pair.second);
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        for (const auto& slot : shard->slots) {
+            if (slot.atom) {
+                result.push_back(slot.atom);
+            }
+        }
     }
     
     return result;
 }
 
 std::vector<AtomPtr> AgentSpace::getAtomsByType(AtomType type) const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
-    
+    loadSnapshotType(type);
     std::vector<AtomPtr> result;
     
-    auto it = atoms_by_type_.find(type);
-    if (it != atoms_by_type_.end()) {
-        for (const AtomId& id : it->second) {
-            auto atom_it = atoms_.find(id);
-            if (atom_it != atoms_.end()) {
-                result.push_back(atom_it->second);
-            }
+    // Each shard indexes the atoms it owns; merge the per-shard results
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        
+        auto it = shard->atoms_by_type.find(type);
+        if (it == shard->atoms_by_type.end()) continue;
+        
+        result.reserve(result.size() + it->second.size());
+        for (AtomHandle handle : it->second) {
+            result.push_back(shard->slots[localSlot(handle)].atom);
         }
     }
     
@@ -211,226 +543,897 @@ std::vector<AtomPtr> AgentSpace::getAtomsByType(AtomType type) const {
 }
 
 std::vector<AtomPtr> AgentSpace::getAtomsByName(const std::string& name) const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
+    waitForSnapshot();
+    std::vector<AtomHandle> handles;
+    {
+        const Shard& shard = shardForKey(name);
+        auto lock = readLock(shard);
+        
+        auto it = shard.atoms_by_name.find(name);
+        if (it != shard.atoms_by_name.end()) {
+            handles.assign(it->second.begin(), it->second.end());
+        }
+    }
     
-    std::vector<AtomPtr> result;
+    return resolveHandles(handles);
+}
+
+AgentSpaceSnapshotPtr AgentSpace::snapshot() const {
+    waitForSnapshot();
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
     
-    auto it = atoms_by_name_.find(name);
-    if (it != atoms_by_name_.end()) {
-        for (const AtomId& id : it->second) {
-            auto atom_it = atoms_.find(id);
-            if (atom_it != atoms_.end()) {
-                result.push_back(atom_it->second);
-            }
+    // A consistent cut: no link change in flight and every shard held at once.
+    // Shared locks are taken in shard order, as clear() does for exclusive ones.
+    std::unique_lock<std::shared_mutex> link_lock(link_index_mutex_);
+    std::vector<std::shared_lock<std::shared_mutex>> shard_locks;
+    shard_locks.reserve(shards_.size());
+    for (const auto& shard : shards_) {
+        shard_locks.emplace_back(shard->mutex);
+    }
+    
+    auto result = std::make_shared<AgentSpaceSnapshot>();
+    result->shards_.reserve(shards_.size());
+    
+    for (const auto& shard : shards_) {
+        // Only shards changed since the last snapshot get a new view, and it
+        // copies only their changed chunks
+        if (!shard->view || shard->view->version != shard->version) {
+            shard->view = buildShardView(*shard);
         }
+        result->shards_.push_back(shard->view);
+        result->version_ += shard->version;
     }
     
     return result;
 }
 
-NodePtr AgentSpace::addAgentNode(const std::string& name, const std::vector<std::string>& capabilities) {
-    std::string agent_name = generateUniqueNodeName(name);
+bool AgentSpace::saveSnapshot(const std::string& path) const {
+    // A space still loading from a file would be saved in part
+    if (!waitForSnapshot()) {
+        return false;
+    }
     
-    auto agent_node = std::make_shared<Node>(AtomType::AGENT_NODE, agent_name);
+    auto view = snapshot();
+    auto atoms = view->getAtoms();
     
-    // Set agent metadata
-    agent_node->setMetadata("type", "cognitive_agent");
-    agent_node->setMetadata("creation_time", Utils::TimeUtils::timestampToString(Utils::TimeUtils::now()));
+    // The file lists every link after its targets. Links that point outside
+    // the space (at removed atoms) cannot be restored and are left out.
+    std::unordered_map<const Atom*, bool> placed;  // false while pending or dropped
+    placed.reserve(atoms.size());
+    for (const auto& atom : atoms) {
+        placed.emplace(atom.get(), false);
+    }
     
-    // Add capabilities as metadata
-    std::ostringstream cap_stream;
-    for (size_t i = 0; i < capabilities.size(); ++i) {
-        if (i > 0) cap_stream << ",";
-        cap_stream << capabilities[i];
+    std::vector<AtomPtr> ordered;
+    ordered.reserve(atoms.size());
+    std::unordered_set<const Atom*> visited;
+    visited.reserve(atoms.size());
+    
+    std::function<bool(const AtomPtr&)> place = [&](const AtomPtr& atom) {
+        auto it = placed.find(atom.get());
+        if (it == placed.end()) return false;
+        if (!visited.insert(atom.get()).second) return it->second;
+        
+        if (auto link = std::dynamic_pointer_cast<Link>(atom)) {
+            for (const auto& target : link->getOutgoing()) {
+                if (!target || !place(target)) {
+                    Utils::Logger::warning("Snapshot skips link with a target outside the space: " + atom->getId());
+                    return false;
+                }
+            }
+        }
+        it->second = true;
+        ordered.push_back(atom);
+        return true;
+    };
+    for (const auto& atom : atoms) {
+        place(atom);
     }
-    agent_node->setMetadata("capabilities", cap_stream.str());
     
-    addAtom(agent_node);
+    if (!writeSnapshotFile(path, name_, ordered)) {
+        return false;
+    }
     
-    Utils::Logger::info("Created agent node: " + agent_name);
-    return agent_node;
+    Utils::Logger::info("Saved " + std::to_string(ordered.size()) + " atoms of " + name_ + " to " + path);
+    return true;
 }
 
-NodePtr AgentSpace::addCapabilityNode(const std::string& name, const std::string& description) {
-    auto capability_node = std::make_shared<Node>(AtomType::CAPABILITY_NODE, name, description);
-    addAtom(capability_node);
-    return capability_node;
+std::shared_ptr<AgentSpace> AgentSpace::openSnapshot(const std::string& path, const AgentSpaceConfig& config) {
+    auto file = MappedSnapshot::open(path);
+    if (!file) {
+        return nullptr;
+    }
+    
+    // Only the header has been read; atoms are inserted in the background
+    auto space = std::make_shared<AgentSpace>(std::string(file->getSpaceName()), config);
+    auto load = std::make_unique<SnapshotLoad>();
+    load->path = path;
+    load->atoms.resize(file->getAtomCount());
+    load->remaining = file->getAtomCount();
+    load->file = std::move(file);
+    space->snapshot_load_ = std::move(load);
+    space->snapshot_load_->loader = std::thread(&AgentSpace::runSnapshotLoad, space.get());
+    
+    Utils::Logger::info("Opened snapshot " + path + " with " + std::to_string(space->snapshot_load_->remaining) + " atoms");
+    return space;
 }
 
-NodePtr AgentSpace::addGoalNode(const std::string& goal, double priority) {
-    auto goal_node = std::make_shared<Node>(AtomType::GOAL_NODE, goal);
-    goal_node->setTruthValue(TruthValue(priority, 0.8));
-    addAtom(goal_node);
-    return goal_node;
+bool AgentSpace::waitForSnapshot() const {
+    SnapshotLoad* load = snapshot_load_.get();
+    if (!load) return true;
+    
+    std::unique_lock<std::mutex> lock(load->mutex);
+    load->done_cv.wait(lock, [load] { return load->done.load(); });
+    return !load->failed;
 }
 
-NodePtr AgentSpace::addBeliefNode(const std::string& belief, const std::string& value) {
-    auto belief_node = std::make_shared<Node>(AtomType::BELIEF_NODE, belief, value);
-    belief_node->setTruthValue(TruthValue(0.8, 0.7));
-    addAtom(belief_node);
-    return belief_node;
+void AgentSpace::runSnapshotLoad() {
+    SnapshotLoad& load = *snapshot_load_;
+    uint32_t count = static_cast<uint32_t>(load.atoms.size());
+    
+    for (uint32_t begin = 0; begin < count && !load.stopping && !load.failed; begin += kSnapshotChunk) {
+        std::lock_guard<std::mutex> lock(load.mutex);
+        uint32_t end = std::min(count, begin + kSnapshotChunk);
+        
+        // Atoms looked up by id meanwhile are in already
+        std::vector<AtomPtr> batch;
+        std::vector<uint32_t> indices;
+        for (uint32_t i = begin; i < end; ++i) {
+            if (load.atoms[i]) continue;
+            AtomPtr atom = createSnapshotAtom(load, i);
+            if (!atom) break;
+            load.atoms[i] = atom;
+            batch.push_back(std::move(atom));
+            indices.push_back(i);
+        }
+        
+        std::vector<AtomPtr> stored = addAtoms(batch);
+        for (size_t k = 0; k < stored.size(); ++k) {
+            if (stored[k]) load.atoms[indices[k]] = std::move(stored[k]);
+        }
+        load.remaining -= batch.size();
+    }
+    
+    std::lock_guard<std::mutex> lock(load.mutex);
+    load.file.reset();
+    load.atoms = std::vector<AtomPtr>();
+    load.done = true;
+    load.done_cv.notify_all();
+    
+    if (!load.failed && !load.stopping) {
+        Utils::Logger::info("Loaded snapshot " + load.path + " into " + name_);
+    }
 }
 
-NodePtr AgentSpace::addMemoryNode(const std::string& content, const std::string& type) {
-    auto memory_node = std::make_shared<Node>(AtomType::MEMORY_NODE, "memory_" + Utils::UUIDGenerator::generateShort(), content);
-    memory_node->setMetadata("memory_type", type);
-    memory_node->setAttentionValue(AttentionValue(0.5, 0.0, 0.3));
-    addAtom(memory_node);
-    return memory_node;
+void AgentSpace::stopSnapshotLoad() {
+    SnapshotLoad* load = snapshot_load_.get();
+    if (!load) return;
+    
+    std::call_once(load->stop_once, [load] {
+        load->stopping = true;
+        load->loader.join();
+    });
 }
 
-LinkPtr AgentSpace::addCollaborationLink(const AgentId& agent1, const AgentId& agent2, const std::string& type) {
-    auto agent1_atom = getAtom(agent1);
-    auto agent2_atom = getAtom(agent2);
+AtomPtr AgentSpace::createSnapshotAtom(SnapshotLoad& load, uint32_t index) {
+    using namespace SnapshotFormat;
     
-    if (!agent1_atom || !agent2_atom) {
-        Utils::Logger::warning("Cannot create collaboration link: agent not found");
+    const MappedSnapshot& file = *load.file;
+    const AtomRecord& record = file.atom(index);
+    if (record.type >= kTypeCount) {
+        Utils::Logger::error("Snapshot has an unknown atom type: " + load.path);
+        load.failed = true;
         return nullptr;
     }
+    AtomType type = static_cast<AtomType>(record.type);
+    std::string name(file.string(record.name));
     
-    auto collaboration_link = std::make_shared<Link>(
-        AtomType::COLLABORATION_LINK,
-        std::vector<AtomPtr>{agent1_atom, agent2_atom}
-    );
+    AtomPtr atom;
+    if (record.flags & kLinkRecord) {
+        auto targets = file.outgoing(index);
+        std::vector<AtomPtr> outgoing;
+        outgoing.reserve(targets.second);
+        for (size_t k = 0; k < targets.second; ++k) {
+            // Targets always precede the link; anything else is corruption
+            if (targets.first[k] >= index) {
+                Utils::Logger::error("Snapshot link refers forward: " + load.path);
+                load.failed = true;
+                return nullptr;
+            }
+            outgoing.push_back(load.atoms[targets.first[k]]);
+        }
+        atom = createLink(type, outgoing, name);
+    } else {
+        atom = createNode(type, name, std::string(file.string(record.value)));
+    }
     
-    collaboration_link->setMetadata("collaboration_type", type);
-    collaboration_link->setMetadata("created_time", Utils::TimeUtils::timestampToString(Utils::TimeUtils::now()));
+    restoreAtomState(*atom, std::string(file.string(record.id)),
+                     Timestamp(Timestamp::duration(record.timestamp)),
+                     TruthValue(record.strength, record.confidence),
+                     AttentionValue(record.sti, record.lti, record.vlti));
     
-    addAtom(collaboration_link);
-    return collaboration_link;
+    auto metadata = file.metadata(index);
+    for (size_t k = 0; k < metadata.second; ++k) {
+        const MetadataRecord& entry = metadata.first[k];
+        atom->cold().metadata.set(MetadataKeys::intern(std::string(file.string(entry.key))),
+                                  file.metadataValue(entry));
+    }
+    return atom;
 }
 
-LinkPtr AgentSpace::addTrustRelationship(const AgentId& agent1, const AgentId& agent2, double trust_level) {
-    auto agent1_atom = getAtom(agent1);
-    auto agent2_atom = getAtom(agent2);
+AtomPtr AgentSpace::loadSnapshotAtom(SnapshotLoad& load, uint32_t index) {
+    if (load.atoms[index]) return load.atoms[index];
     
-    if (!agent1_atom || !agent2_atom) {
-        Utils::Logger::warning("Cannot create trust relationship: agent not found");
-        return nullptr;
+    if (load.file->atom(index).flags & SnapshotFormat::kLinkRecord) {
+        auto targets = load.file->outgoing(index);
+        for (size_t k = 0; k < targets.second; ++k) {
+            if (targets.first[k] < index && !loadSnapshotAtom(load, targets.first[k])) return nullptr;
+        }
     }
     
-    auto trust_link = std::make_shared<Link>(
-        AtomType::TRUST_LINK,
-        std::vector<AtomPtr>{agent1_atom, agent2_atom}
-    );
-    
-    trust_link->setTruthValue(TruthValue(trust_level, 0.5));
-    trust_link->setMetadata("trust_level", std::to_string(trust_level));
+    AtomPtr atom = createSnapshotAtom(load, index);
+    if (!atom) return nullptr;
     
-    addAtom(trust_link);
-    return trust_link;
+    AtomPtr stored = addAtom(atom);
+    load.atoms[index] = stored ? stored : atom;
+    --load.remaining;
+    return load.atoms[index];
 }
 
-LinkPtr AgentSpace::addKnowledgeLink(const AtomId& source, const AtomId& target, const std::string& relation) {
-    auto source_atom = getAtom(source);
-    auto target_atom = getAtom(target);
-    
-    if (!source_atom || !target_atom) {
-        Utils::Logger::warning("Cannot create knowledge link: atom not found");
-        return nullptr;
-    }
+AtomHandle AgentSpace::loadSnapshotAlias(const AtomId& id) const {
+    SnapshotLoad* load = snapshot_load_.get();
+    if (!load || load->done.load(std::memory_order_acquire)) return AtomHandle();
     
-    auto knowledge_link = std::make_shared<Link>(
-        AtomType::KNOWLEDGE_LINK,
-        std::vector<AtomPtr>{source_atom, target_atom}
-    );
+    std::lock_guard<std::mutex> lock(load->mutex);
+    if (!load->file || load->failed) return AtomHandle();
     
-    knowledge_link->setMetadata("relation", relation);
+    uint32_t index = load->file->findById(id);
+    if (index == SnapshotFormat::kNoAtom) return AtomHandle();
     
-    addAtom(knowledge_link);
-    return knowledge_link;
+    // Inserting is a side effect of the lookup, like filling a cache; spaces
+    // are never created const
+    AtomPtr atom = const_cast<AgentSpace*>(this)->loadSnapshotAtom(*load, index);
+    return atom ? atom->getHandle() : AtomHandle();
 }
 
-std::vector<AtomPtr> AgentSpace::findAtoms(AtomType type, const std::string& name) const {
-    if (name.empty()) {
-        return getAtomsByType(type);
-    } else {
-        auto atoms_by_name = getAtomsByName(name);
-        std::vector<AtomPtr> result;
-        
-        for (const auto& atom : atoms_by_name) {
-            if (atom->getType() == type) {
-                result.push_back(atom);
-            }
+void AgentSpace::loadSnapshotType(AtomType type) const {
+    SnapshotLoad* load = snapshot_load_.get();
+    if (!load || load->done.load(std::memory_order_acquire)) return;
+    
+    std::lock_guard<std::mutex> lock(load->mutex);
+    if (!load->file || load->failed) return;
+    
+    auto indices = load->file->atomsOfType(type);
+    for (size_t k = 0; k < indices.second && !load->failed; ++k) {
+        if (indices.first[k] < load->atoms.size()) {
+            const_cast<AgentSpace*>(this)->loadSnapshotAtom(*load, indices.first[k]);
         }
-        
-        return result;
     }
 }
 
-std::vector<AtomId> AgentSpace::getCollaborators(const AgentId& agent_id) const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
+void AgentSpace::loadSnapshotIncoming(AtomHandle handle) const {
+    SnapshotLoad* load = snapshot_load_.get();
+    if (!load || load->done.load(std::memory_order_acquire)) return;
     
-    std::vector<AtomId> collaborators;
-    auto agent_atom = getAtom(agent_id);
-    if (!agent_atom) return collaborators;
+    AtomPtr atom = lookupAtom(handle);
+    if (!atom) return;
     
-    // Find collaboration links involving this agent
-    auto collaboration_links = getAtomsByType(AtomType::COLLABORATION_LINK);
+    std::lock_guard<std::mutex> lock(load->mutex);
+    if (!load->file || load->failed) return;
     
-    for (const auto& link_atom : collaboration_links) {
-        auto link = std::dynamic_pointer_cast<Link>(link_atom);
-        if (!link || link->getArity() != 2) continue;
-        
-        const auto& outgoing = link->getOutgoing();
-        if (outgoing[0]->getId() == agent_id) {
-            collaborators.push_back(outgoing[1]->getId());
-        } else if (outgoing[1]->getId() == agent_id) {
-            collaborators.push_back(outgoing[0]->getId());
+    // Atoms created since the snapshot was opened are not in the file
+    uint32_t index = load->file->findById(atom->getId());
+    if (index == SnapshotFormat::kNoAtom) return;
+    
+    auto links = load->file->incoming(index);
+    for (size_t k = 0; k < links.second && !load->failed; ++k) {
+        if (links.first[k] < load->atoms.size()) {
+            const_cast<AgentSpace*>(this)->loadSnapshotAtom(*load, links.first[k]);
         }
     }
+}
+
+void AgentSpace::restoreAtomState(Atom& atom, const AtomId& id, Timestamp timestamp,
+                                  const TruthValue& tv, const AttentionValue& av) {
+    // Only for atoms not yet stored or shared, so no lock is needed
+    atom.assignId(id);
+    atom.timestamp_ = timestamp;
+    atom.truth_value_.store(tv);
+    atom.attention_.update([&av](auto& binding) { binding.detached = av; });
+}
+
+void AgentSpace::setMutationLog(std::shared_ptr<MutationLog> log) {
+    // Every lock, as in clear(), so no insert or removal straddles the switch
+    std::unique_lock<std::shared_mutex> link_lock(link_index_mutex_);
+    std::vector<std::unique_lock<std::shared_mutex>> shard_locks;
+    shard_locks.reserve(shards_.size());
+    for (auto& shard : shards_) {
+        shard_locks.emplace_back(shard->mutex);
+    }
     
-    return collaborators;
+    mutation_log_ = std::move(log);
+    for (auto& shard : shards_) {
+        for (auto& slot : shard->slots) {
+            if (slot.atom) {
+                slot.atom->setMutationLog(mutation_log_.get());
+            }
+        }
+    }
 }
 
-double AgentSpace::getTrustLevel(const AgentId& agent1, const AgentId& agent2) const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
+std::shared_ptr<MutationLog> AgentSpace::getMutationLog() const {
+    std::shared_lock<std::shared_mutex> lock(link_index_mutex_);
+    return mutation_log_;
+}
+
+size_t AgentSpace::replayMutationLog(const std::string& path) {
+    size_t applied = 0;
+    auto apply = [this, &applied](const MutationRecord& record) {
+        if (applyMutation(record)) ++applied;
+    };
     
-    auto trust_links = getAtomsByType(AtomType::TRUST_LINK);
+    size_t read = MutationLog::read(MutationLog::rotatedPath(path), apply);
+    read += MutationLog::read(path, apply);
     
-    for (const auto& link_atom : trust_links) {
-        auto link = std::dynamic_pointer_cast<Link>(link_atom);
-        if (!link || link->getArity() != 2) continue;
-        
-        const auto& outgoing = link->getOutgoing();
-        if ((outgoing[0]->getId() == agent1 && outgoing[1]->getId() == agent2) ||
-            (outgoing[0]->getId() == agent2 && outgoing[1]->getId() == agent1)) {
-            return link->getTruthValue().strength;
+    Utils::Logger::info("Replayed " + std::to_string(applied) + " of " + std::to_string(read) +
+                        " logged mutations into " + name_);
+    return applied;
+}
+
+bool AgentSpace::applyMutation(const MutationRecord& record) {
+    // Records carry absolute values and skip what is already in place, so
+    // replaying records the snapshot already covers is harmless
+    switch (record.kind) {
+        case MutationKind::ADD_NODE:
+        case MutationKind::ADD_LINK: {
+            if (resolveAlias(record.atom_id).isValid()) return false;
+            
+            AtomPtr atom;
+            if (record.kind == MutationKind::ADD_LINK) {
+                std::vector<AtomPtr> outgoing;
+                outgoing.reserve(record.outgoing.size());
+                for (const auto& target_id : record.outgoing) {
+                    AtomPtr target = getAtom(target_id);
+                    if (!target) {
+                        Utils::Logger::warning("Replay skips link with a missing target: " + record.atom_id);
+                        return false;
+                    }
+                    outgoing.push_back(std::move(target));
+                }
+                atom = createLink(record.type, outgoing, record.name);
+            } else {
+                atom = createNode(record.type, record.name, record.value);
+            }
+            
+            restoreAtomState(*atom, record.atom_id, record.timestamp, record.truth_value, record.attention_value);
+            for (const auto& entry : record.metadata) {
+                atom->cold().metadata.set(MetadataKeys::intern(entry.first), entry.second);
+            }
+            return addAtom(atom) == atom;
+        }
+        case MutationKind::REMOVE:
+            return removeAtom(record.atom_id);
+        case MutationKind::SET_TRUTH:
+        case MutationKind::SET_ATTENTION:
+        case MutationKind::SET_METADATA: {
+            AtomPtr atom = getAtom(record.atom_id);
+            if (!atom) return false;
+            
+            if (record.kind == MutationKind::SET_TRUTH) {
+                atom->setTruthValue(record.truth_value);
+            } else if (record.kind == MutationKind::SET_ATTENTION) {
+                atom->setAttentionValue(record.attention_value);
+            } else {
+                MetadataKeyId key = MetadataKeys::intern(record.metadata.front().first);
+                const MetadataValue& value = record.metadata.front().second;
+                const std::string* csv = std::get_if<std::string>(&value);
+                if (key == MetaKey::CAPABILITIES && csv && atom->getType() == AtomType::AGENT_NODE) {
+                    return setAgentCapabilities(atom->getHandle(), parseCapabilities(*csv));
+                }
+                atom->setMetadata(key, value);
+            }
+            return true;
         }
+        case MutationKind::CLEAR:
+            clear();
+            return true;
     }
-    
-    return 0.0; // No trust relationship found
+    return false;
 }
 
-std::vector<AtomPtr> AgentSpace::getMostImportantAtoms(size_t limit) const {
-    auto atoms = getAtoms();
-    
-    // Sort by combined attention values
-    std::sort(atoms.begin(), atoms.end(), [](const AtomPtr& a, const AtomPtr& b) {
-        auto av_a = a->getAttentionValue();
-        auto av_b = b->getAttentionValue();
-        double importance_a = av_a.sti + av_a.lti + av_a.vlti;
-        double importance_b = av_b.sti + av_b.lti + av_b.vlti;
-        return importance_a > importance_b;
-    });
+bool AgentSpace::checkpoint(const std::string& snapshot_path) {
+    // Records logged from the rotation on land in the fresh log; the snapshot
+    // is cut after the rotation, so together they cover every change
+    auto log = getMutationLog();
+    if (log && !log->rotate()) {
+        return false;
+    }
     
-    if (atoms.size() > limit) {
-        atoms.resize(limit);
+    // saveSnapshot returns once the file and its rename are synced; until
+    // then, and on failure, the rotated segment stays for recovery to replay
+    if (!saveSnapshot(snapshot_path)) {
+        return false;
     }
     
-    return atoms;
+    if (log) {
+        log->discardRotated();
+    }
+    return true;
+}
+
+std::shared_ptr<AgentSpace> AgentSpace::recover(const std::string& name,
+                                                const std::string& snapshot_path,
+                                                const std::string& log_path,
+                                                const AgentSpaceConfig& config,
+                                                const MutationLogConfig& log_config) {
+    std::shared_ptr<AgentSpace> space;
+    if (std::ifstream(snapshot_path).good()) {
+        space = openSnapshot(snapshot_path, config);
+        if (!space || !space->waitForSnapshot()) return nullptr;
+    } else {
+        space = std::make_shared<AgentSpace>(name, config);
+    }
+    
+    space->replayMutationLog(log_path);
+    
+    auto log = MutationLog::open(log_path, log_config);
+    if (!log) {
+        return nullptr;
+    }
+    space->setMutationLog(std::move(log));
+    return space;
+}
+
+SubscriptionId AgentSpace::subscribe(const ChangeFilter& filter, ChangeHandler handler,
+                                     const SubscriptionConfig& config) {
+    return change_feed_.subscribe(filter, std::move(handler), config);
+}
+
+bool AgentSpace::unsubscribe(SubscriptionId id) {
+    return change_feed_.unsubscribe(id);
+}
+
+NodePtr AgentSpace::addAgentNode(const std::string& name, const std::vector<std::string>& capabilities) {
+    std::string agent_name = generateUniqueNodeName(name);
+    
+    auto agent_node = createNode(AtomType::AGENT_NODE, agent_name);
+    
+    // Set agent metadata
+    agent_node->setMetadata(MetaKey::TYPE, "cognitive_agent");
+    agent_node->setMetadata(MetaKey::CREATION_TIME, Utils::TimeUtils::now());
+    
+    // Add capabilities as metadata
+    std::ostringstream cap_stream;
+    for (size_t i = 0; i < capabilities.size(); ++i) {
+        if (i > 0) cap_stream << ",";
+        cap_stream << capabilities[i];
+    }
+    agent_node->setMetadata(MetaKey::CAPABILITIES, cap_stream.str());
+    
+    AtomPtr stored = addAtom(agent_node);
+    releaseNodeName(agent_name);  // already gone if the node was indexed
+    if (!stored) return nullptr;
+    
+    Utils::Logger::info("Created agent node: " + agent_name);
+    return std::static_pointer_cast<Node>(stored);
+}
+
+bool AgentSpace::setAgentCapabilities(AtomHandle agent, const std::vector<std::string>& capabilities) {
+    if (!agent.isValid()) return false;
+    
+    // Held exclusively so the metadata and the registry change together, and
+    // the agent cannot be removed in between
+    Shard& shard = shardOf(agent);
+    auto lock = writeLock(shard);
+    
+    AtomPtr atom = lookupLocked(shard, agent);
+    if (!atom || atom->getType() != AtomType::AGENT_NODE) {
+        Utils::Logger::warning("Cannot set capabilities of a non-agent atom");
+        return false;
+    }
+    
+    // Stored through the held lock; Atom::setMetadata would take it again
+    storeIndexedMetadata(shard, *atom, agent, MetaKey::CAPABILITIES, Utils::StringUtils::join(capabilities, ","));
+    capabilities_.setCapabilities(agent, capabilities);
+    return true;
+}
+
+NodePtr AgentSpace::addCapabilityNode(const std::string& name, const std::string& description) {
+    auto capability_node = createNode(AtomType::CAPABILITY_NODE, name, description);
+    return std::static_pointer_cast<Node>(addAtom(capability_node));
+}
+
+NodePtr AgentSpace::addGoalNode(const std::string& goal, double priority) {
+    auto goal_node = createNode(AtomType::GOAL_NODE, goal);
+    goal_node->setTruthValue(TruthValue(priority, 0.8));
+    return std::static_pointer_cast<Node>(addAtom(goal_node));
+}
+
+NodePtr AgentSpace::addBeliefNode(const std::string& belief, const std::string& value) {
+    auto belief_node = createNode(AtomType::BELIEF_NODE, belief, value);
+    belief_node->setTruthValue(TruthValue(0.8, 0.7));
+    return std::static_pointer_cast<Node>(addAtom(belief_node));
+}
+
+NodePtr AgentSpace::addMemoryNode(const std::string& content, const std::string& type, const AgentId& owner,
+                                  const std::vector<float>& embedding) {
+    auto memory_node = createNode(AtomType::MEMORY_NODE, "memory_" + Utils::UUIDGenerator::generateShort(), content);
+    memory_node->setMetadata(MetaKey::MEMORY_TYPE, type);
+    if (!owner.empty()) {
+        memory_node->setMetadata(MetaKey::OWNER, owner);
+    }
+    memory_node->setAttentionValue(AttentionValue(0.5, 0.0, 0.3));
+    AtomPtr stored = addAtom(memory_node);
+    if (!stored) return nullptr;
+    if (!embedding.empty()) {
+        setEmbedding(stored->getHandle(), embedding);
+    }
+    return std::static_pointer_cast<Node>(stored);
+}
+
+std::vector<NodePtr> AgentSpace::getMemoryNodes(const AgentId& owner, const std::string& type) const {
+    std::vector<NodePtr> memories;
+    for (const auto& atom : findByMetadata(MetaKey::OWNER, owner)) {
+        if (atom->getType() != AtomType::MEMORY_NODE) continue;
+        if (!type.empty() && atom->getMetadata(MetaKey::MEMORY_TYPE) != type) continue;
+        memories.push_back(std::static_pointer_cast<Node>(atom));
+    }
+    return memories;
+}
+
+LinkPtr AgentSpace::addCollaborationLink(const AgentId& agent1, const AgentId& agent2, const std::string& type) {
+    auto agent1_atom = getAtom(agent1);
+    auto agent2_atom = getAtom(agent2);
+    
+    if (!agent1_atom || !agent2_atom) {
+        Utils::Logger::warning("Cannot create collaboration link: agent not found");
+        return nullptr;
+    }
+    
+    auto collaboration_link = createLink(AtomType::COLLABORATION_LINK, {agent1_atom, agent2_atom});
+    
+    collaboration_link->setMetadata(MetaKey::COLLABORATION_TYPE, type);
+    collaboration_link->setMetadata(MetaKey::CREATED_TIME, Utils::TimeUtils::now());
+    
+    return std::static_pointer_cast<Link>(addAtom(collaboration_link));
+}
+
+LinkPtr AgentSpace::addTrustRelationship(const AgentId& agent1, const AgentId& agent2, double trust_level) {
+    auto agent1_atom = getAtom(agent1);
+    auto agent2_atom = getAtom(agent2);
+    
+    if (!agent1_atom || !agent2_atom) {
+        Utils::Logger::warning("Cannot create trust relationship: agent not found");
+        return nullptr;
+    }
+    
+    auto trust_link = createLink(AtomType::TRUST_LINK, {agent1_atom, agent2_atom});
+    
+    trust_link->setTruthValue(TruthValue(trust_level, 0.5));
+    trust_link->setMetadata(MetaKey::TRUST_LEVEL, trust_level);
+    
+    // A repeated relationship revises the stored link; keep its recorded
+    // level in step with the revised strength
+    auto stored = addAtom(trust_link);
+    if (stored && stored != trust_link) {
+        stored->setMetadata(MetaKey::TRUST_LEVEL, stored->getTruthValue().strength);
+    }
+    return std::static_pointer_cast<Link>(stored);
+}
+
+LinkPtr AgentSpace::addKnowledgeLink(const AtomId& source, const AtomId& target, const std::string& relation) {
+    auto source_atom = getAtom(source);
+    auto target_atom = getAtom(target);
+    
+    if (!source_atom || !target_atom) {
+        Utils::Logger::warning("Cannot create knowledge link: atom not found");
+        return nullptr;
+    }
+    
+    auto knowledge_link = createLink(AtomType::KNOWLEDGE_LINK, {source_atom, target_atom});
+    
+    knowledge_link->setMetadata(MetaKey::RELATION, relation);
+    
+    return std::static_pointer_cast<Link>(addAtom(knowledge_link));
+}
+
+std::vector<AtomPtr> AgentSpace::findAtoms(AtomType type, const std::string& name) const {
+    if (name.empty()) {
+        return getAtomsByType(type);
+    } else {
+        std::vector<AtomPtr> result;
+        
+        forEachWithName(name, [&](const AtomPtr& atom) {
+            if (atom->getType() == type) {
+                result.push_back(atom);
+            }
+        });
+        
+        return result;
+    }
+}
+
+std::vector<AtomId> AgentSpace::getCollaborators(const AgentId& agent_id) const {
+    std::vector<AtomId> collaborators;
+    AtomHandle agent_handle = resolveAlias(agent_id);
+    loadSnapshotIncoming(agent_handle);
+    
+    // Only the collaboration links pointing at this agent need to be visited
+    for (const auto& link_atom : resolveHandles(copyIncoming(agent_handle))) {
+        if (link_atom->getType() != AtomType::COLLABORATION_LINK) continue;
+        
+        auto link = std::static_pointer_cast<Link>(link_atom);
+        if (link->getArity() != 2) continue;
+        
+        const auto& outgoing = link->getOutgoing();
+        if (outgoing[0]->getHandle() == agent_handle) {
+            collaborators.push_back(outgoing[1]->getId());
+        } else if (outgoing[1]->getHandle() == agent_handle) {
+            collaborators.push_back(outgoing[0]->getId());
+        }
+    }
+    
+    return collaborators;
+}
+
+double AgentSpace::getTrustLevel(const AgentId& agent1, const AgentId& agent2) const {
+    // No trust relationship found yields 0.0
+    auto link = lookupTrustLink(resolveAlias(agent1), resolveAlias(agent2));
+    return link ? link->getTruthValue().strength : 0.0;
+}
+
+double AgentSpace::getTrustLevel(AtomHandle agent1, AtomHandle agent2) const {
+    auto link = lookupTrustLink(agent1, agent2);
+    return link ? link->getTruthValue().strength : 0.0;
+}
+
+LinkPtr AgentSpace::getTrustLink(AtomHandle agent1, AtomHandle agent2) const {
+    return lookupTrustLink(agent1, agent2);
+}
+
+std::vector<AtomPtr> AgentSpace::getMostImportantAtoms(size_t limit) const {
+    waitForSnapshot();
+    std::vector<std::pair<double, AtomPtr>> ranked;
+    
+    // Each shard's importance index yields its own top entries; merge them
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        for (const auto& entry : shard->attention.top(limit)) {
+            ranked.emplace_back(entry.first, shard->slots[entry.second].atom);
+        }
+    }
+    
+    size_t count = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+    
+    std::vector<AtomPtr> atoms;
+    atoms.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        atoms.push_back(std::move(ranked[i].second));
+    }
+    
+    return atoms;
+}
+
+bool AgentSpace::createMetadataIndex(MetadataKeyId key) {
+    // Declared under every shard lock, so each shard sees the key at once
+    std::vector<std::unique_lock<std::shared_mutex>> shard_locks;
+    shard_locks.reserve(shards_.size());
+    for (auto& shard : shards_) {
+        shard_locks.emplace_back(shard->mutex);
+    }
+    
+    if (shards_.front()->metadata_indices.count(key)) {
+        return false;
+    }
+    
+    size_t shard_count = shards_.size();
+    for (size_t shard_index = 0; shard_index < shard_count; ++shard_index) {
+        Shard& shard = *shards_[shard_index];
+        MetadataIndex& index = shard.metadata_indices[key];
+        
+        for (size_t i = 0; i < shard.slots.size(); ++i) {
+            const AtomSlot& slot = shard.slots[i];
+            if (!slot.atom) continue;
+            
+            if (auto value = slot.atom->getMetadataValue(key)) {
+                AtomHandle handle(static_cast<uint32_t>(i * shard_count + shard_index), slot.generation);
+                index[std::move(*value)].insert(handle);
+            }
+        }
+    }
+    
+    Utils::Logger::debug("Created metadata index on '" + MetadataKeys::name(key) + "' in AgentSpace: " + name_);
+    return true;
+}
+
+bool AgentSpace::hasMetadataIndex(MetadataKeyId key) const {
+    const Shard& shard = *shards_.front();
+    auto lock = readLock(shard);
+    return shard.metadata_indices.count(key) > 0;
+}
+
+std::vector<AtomPtr> AgentSpace::findByMetadata(MetadataKeyId key, const MetadataValue& value) const {
+    waitForSnapshot();
+    std::vector<AtomPtr> atoms;
+    
+    if (!hasMetadataIndex(key)) {
+        forEachAtom([&](const AtomPtr& atom) {
+            auto current = atom->getMetadataValue(key);
+            if (current && *current == value) atoms.push_back(atom);
+        });
+        return atoms;
+    }
+    
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        
+        const MetadataIndex& index = shard->metadata_indices.at(key);
+        auto it = index.find(value);
+        if (it == index.end()) continue;
+        
+        for (AtomHandle handle : it->second) {
+            atoms.push_back(shard->slots[localSlot(handle)].atom);
+        }
+    }
+    
+    return atoms;
+}
+
+std::vector<AtomPtr> AgentSpace::findByMetadataRange(MetadataKeyId key, const MetadataValue& low,
+                                                     const MetadataValue& high) const {
+    waitForSnapshot();
+    std::vector<std::pair<MetadataValue, AtomPtr>> matches;
+    
+    if (!hasMetadataIndex(key)) {
+        forEachAtom([&](const AtomPtr& atom) {
+            auto current = atom->getMetadataValue(key);
+            if (current && !(*current < low) && !(high < *current)) {
+                matches.emplace_back(std::move(*current), atom);
+            }
+        });
+    } else if (!(high < low)) {
+        // Each shard's index is already ordered; merge the runs below
+        for (const auto& shard : shards_) {
+            auto lock = readLock(*shard);
+            
+            const MetadataIndex& index = shard->metadata_indices.at(key);
+            for (auto it = index.lower_bound(low); it != index.end() && !(high < it->first); ++it) {
+                for (AtomHandle handle : it->second) {
+                    matches.emplace_back(it->first, shard->slots[localSlot(handle)].atom);
+                }
+            }
+        }
+    }
+    
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    std::vector<AtomPtr> atoms;
+    atoms.reserve(matches.size());
+    for (auto& match : matches) {
+        atoms.push_back(std::move(match.second));
+    }
+    
+    return atoms;
+}
+
+std::vector<LinkPtr> AgentSpace::getIncoming(AtomHandle handle) const {
+    loadSnapshotIncoming(handle);
+    std::vector<LinkPtr> result;
+    
+    for (const auto& link_atom : resolveHandles(copyIncoming(handle))) {
+        result.push_back(std::static_pointer_cast<Link>(link_atom));
+    }
+    
+    return result;
+}
+
+std::vector<LinkPtr> AgentSpace::getIncoming(AtomHandle handle, AtomType link_type) const {
+    loadSnapshotIncoming(handle);
+    std::vector<LinkPtr> result;
+    
+    for (const auto& link_atom : resolveHandles(copyIncoming(handle))) {
+        if (link_atom->getType() == link_type) {
+            result.push_back(std::static_pointer_cast<Link>(link_atom));
+        }
+    }
+    
+    return result;
+}
+
+size_t AgentSpace::getIncomingCount(AtomHandle handle) const {
+    if (!handle.isValid()) return 0;
+    loadSnapshotIncoming(handle);
+    
+    const Shard& shard = shardOf(handle);
+    auto lock = readLock(shard);
+    return lookupLocked(shard, handle) ? shard.slots[localSlot(handle)].incoming.size() : 0;
+}
+
+std::shared_ptr<const AdjacencyGraph> AgentSpace::getGraph(const GraphSpec& spec) const {
+    waitForSnapshot();
+    
+    // Excludes every link insert and removal, so the journal cannot move
+    // while the graph is brought up to date
+    std::unique_lock<std::shared_mutex> link_lock(link_index_mutex_);
+    return graph_index_.get(spec, *this);
+}
+
+bool AgentSpace::setEmbedding(AtomHandle handle, const std::vector<float>& embedding) {
+    if (!lookupAtom(handle)) {
+        Utils::Logger::warning("Cannot set embedding: atom not in " + name_);
+        return false;
+    }
+    if (!embedding_index_.insert(handle, embedding)) return false;
+    
+    // Removal drops the embedding after the atom, so an atom removed since
+    // the check is seen here and its embedding is not left behind
+    if (!lookupAtom(handle)) {
+        embedding_index_.remove(handle);
+        return false;
+    }
+    return true;
+}
+
+std::vector<float> AgentSpace::getEmbedding(AtomHandle handle) const {
+    return embedding_index_.get(handle);
+}
+
+std::vector<std::pair<AtomPtr, double>> AgentSpace::findSimilar(const std::vector<float>& query, size_t k) const {
+    std::vector<std::pair<AtomPtr, double>> result;
+    result.reserve(k);
+    
+    for (const auto& match : embedding_index_.search(query, k)) {
+        // Matches are resolved after the index lock is released; skip any
+        // atom removed in between
+        if (AtomPtr atom = lookupAtom(match.second)) {
+            result.emplace_back(std::move(atom), match.first);
+        }
+    }
+    
+    return result;
+}
+
+std::vector<std::pair<NodePtr, double>> AgentSpace::findSimilarMemories(const std::vector<float>& query, size_t k,
+                                                                        const AgentId& owner) const {
+    std::vector<std::pair<NodePtr, double>> result;
+    if (k == 0) return result;
+    
+    // Other atoms share the index, so widen the search until k memories
+    // match or the index has nothing more to give
+    for (size_t wanted = k;; wanted *= 4) {
+        result.clear();
+        auto matches = embedding_index_.search(query, wanted);
+        for (const auto& match : matches) {
+            AtomPtr atom = lookupAtom(match.second);
+            if (!atom || atom->getType() != AtomType::MEMORY_NODE) continue;
+            if (!owner.empty() && atom->getMetadata(MetaKey::OWNER) != owner) continue;
+            
+            result.emplace_back(std::static_pointer_cast<Node>(atom), match.first);
+            if (result.size() == k) return result;
+        }
+        if (matches.size() < wanted) return result;
+    }
 }
 
 void AgentSpace::addToAttentionalFocus(const AtomId& atom_id) {
+    addToAttentionalFocus(getHandle(atom_id));
+}
+
+void AgentSpace::addToAttentionalFocus(AtomHandle handle) {
+    if (!handle.isValid()) return;
+    
     std::lock_guard<std::mutex> lock(focus_mutex_);
     
     // Remove if already exists to avoid duplicates
     attentional_focus_.erase(
-        std::remove(attentional_focus_.begin(), attentional_focus_.end(), atom_id),
+        std::remove(attentional_focus_.begin(), attentional_focus_.end(), handle),
         attentional_focus_.end()
     );
     
-    attentional_focus_.push_back(atom_id);
+    attentional_focus_.push_back(handle);
     
     // Limit focus size
     const size_t max_focus_size = 20;
@@ -440,115 +1443,1015 @@ void AgentSpace::addToAttentionalFocus(const AtomId& atom_id) {
 }
 
 void AgentSpace::removeFromAttentionalFocus(const AtomId& atom_id) {
+    AtomHandle handle = getHandle(atom_id);
     std::lock_guard<std::mutex> lock(focus_mutex_);
     
     attentional_focus_.erase(
-        std::remove(attentional_focus_.begin(), attentional_focus_.end(), atom_id),
+        std::remove(attentional_focus_.begin(), attentional_focus_.end(), handle),
         attentional_focus_.end()
     );
 }
 
 std::vector<AtomId> AgentSpace::getAttentionalFocus() const {
-    std::lock_guard<std::mutex> lock(focus_mutex_);
-    return attentional_focus_;
-}
-
-void AgentSpace::updateAttentionValues() {
-    auto atoms = getAtoms();
-    
-    for (auto& atom : atoms) {
-        auto av = atom->getAttentionValue();
-        
-        // Decay attention values
-        av.sti *= 0.99;
-        av.lti = av.lti * 0.999 + av.sti * 0.001;
-        av.vlti = av.vlti * 0.9999 + av.lti * 0.0001;
-        
-        atom->setAttentionValue(av);
+    std::vector<AtomHandle> focus;
+    {
+        std::lock_guard<std::mutex> lock(focus_mutex_);
+        focus = attentional_focus_;
     }
-}
-
-size_t AgentSpace::getAtomCount() const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
-    return atoms_.size();
-}
-
-void AgentSpace::clear() {
-    std::unique_lock<std::shared_mutex> atoms_lock(atoms_mutex_);
-    std::lock_guard<std::mutex> focus_lock(focus_mutex_);
     
-    atoms_.clear();
-    atoms_by_type_.clear();
-    atoms_by_name_.clear();
-    attentional_focus_.clear();
-    atom_counter_.reset();
+    std::vector<AtomId> result;
+    result.reserve(focus.size());
+    for (AtomHandle handle : focus) {
+        if (auto atom = lookupAtom(handle)) {
+            result.push_back(atom->getId());
+        }
+    }
     
-    Utils::Logger::info("Cleared AgentSpace: " + name_);
+    return result;
 }
 
-std::map<std::string, size_t> AgentSpace::getStatistics() const {
-    std::shared_lock<std::shared_mutex> lock(atoms_mutex_);
-    
-    std::map<std::string, size_t> stats;
-    stats["total_atoms"] = atoms_.size();
-    stats["attentional_focus_size"] = attentional_focus_.size();
+void AgentSpace::updateAttentionValues() {
+    // Decay is lazy: a tick only advances each shard's clock, and slots are
+    // decayed when next read or written, or by the optional periodic sweep
+    uint64_t tick = ++attention_ticks_;
+    bool sweep = config_.attention_sweep_interval && tick % config_.attention_sweep_interval == 0;
     
-    for (const auto& pair : atoms_by_type_) {
-        std::string type_name = "type_" + std::to_string(static_cast<int>(pair.first));
-        stats[type_name] = pair.second.size();
+    for (auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        shard->attention.advance();
+        if (sweep) {
+            shard->attention.sweep(shard->slots.size());
+        }
     }
-    
-    return stats;
 }
 
-std::string AgentSpace::generateUniqueNodeName(const std::string& base) const {
-    std::string candidate = base;
-    int counter = 1;
+std::vector<double> AgentSpace::loadSti(const std::vector<AtomHandle>& handles) const {
+    std::vector<double> values(handles.size(), 0.0);
     
-    while (!getAtomsByName(candidate).empty()) {
-        candidate = base + "_" + std::to_string(counter++);
+    std::vector<std::vector<size_t>> by_shard(shards_.size());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        if (handles[i].isValid()) {
+            by_shard[handles[i].slot() % shards_.size()].push_back(i);
+        }
     }
     
-    return candidate;
-}
+    std::vector<size_t> positions;
+    std::vector<uint32_t> slots;
+    std::vector<double> sti;
+    for (size_t s = 0; s < shards_.size(); ++s) {
+        if (by_shard[s].empty()) continue;
+        
+        const Shard& shard = *shards_[s];
+        auto lock = readLock(shard);
+        positions.clear();
+        slots.clear();
+        for (size_t i : by_shard[s]) {
+            if (isStoredLocked(shard, handles[i])) {
+                positions.push_back(i);
+                slots.push_back(localSlot(handles[i]));
+            }
+        }
+        
+        shard.attention.loadSti(slots, sti);
+        for (size_t k = 0; k < positions.size(); ++k) {
+            values[positions[k]] = sti[k];
+        }
+    }
+    
+    return values;
+}
+
+void AgentSpace::addSti(const std::vector<std::pair<AtomHandle, double>>& deltas) {
+    std::vector<std::vector<std::pair<AtomHandle, double>>> by_shard(shards_.size());
+    for (const auto& delta : deltas) {
+        if (delta.first.isValid()) {
+            by_shard[delta.first.slot() % shards_.size()].push_back(delta);
+        }
+    }
+    
+    struct Update {
+        AtomPtr atom;
+        AttentionValue av;
+        uint64_t version;
+    };
+    std::vector<std::pair<uint32_t, double>> local;
+    std::vector<Update> updates;
+    for (size_t s = 0; s < shards_.size(); ++s) {
+        if (by_shard[s].empty()) continue;
+        
+        Shard& shard = *shards_[s];
+        size_t first = updates.size();
+        {
+            // Shared suffices: bindings only change under the exclusive lock, and
+            // the columns serialize their own writers
+            auto lock = readLock(shard);
+            local.clear();
+            for (const auto& delta : by_shard[s]) {
+                if (isStoredLocked(shard, delta.first)) {
+                    local.emplace_back(localSlot(delta.first), delta.second);
+                    updates.push_back({shard.slots[localSlot(delta.first)].atom, AttentionValue(), 0});
+                }
+            }
+            shard.attention.addSti(local);
+            
+            // Each result is read inside the atom's own write section, as its
+            // setter would, so the announcement orders with racing setters
+            for (size_t k = first; k < updates.size(); ++k) {
+                Update& update = updates[k];
+                update.version = update.atom->attention_.update([&update](Atom::AttentionBinding& binding) {
+                    update.av = binding.columns->load(binding.slot);
+                });
+            }
+        }
+    }
+    
+    for (auto& update : updates) {
+        update.atom->announceAttentionValue(update.av, update.version);
+    }
+}
+
+size_t AgentSpace::getAtomCount() const {
+    // While a snapshot loads, atoms it has yet to insert count too; its lock
+    // keeps an insert from being counted on both sides
+    SnapshotLoad* load = snapshot_load_.get();
+    std::unique_lock<std::mutex> load_lock;
+    size_t count = 0;
+    if (load && !load->done) {
+        load_lock = std::unique_lock<std::mutex>(load->mutex);
+        count = load->done ? 0 : load->remaining.load();
+    }
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        count += shard->live_atoms;
+    }
+    return count;
+}
+
+void AgentSpace::clear() {
+    // A snapshot still loading is abandoned rather than loaded into the cleared space
+    stopSnapshotLoad();
+    
+    // Lock order: link index, then every shard in index order
+    std::unique_lock<std::shared_mutex> link_lock(link_index_mutex_);
+    std::vector<std::unique_lock<std::shared_mutex>> shard_locks;
+    shard_locks.reserve(shards_.size());
+    for (auto& shard : shards_) {
+        shard_locks.emplace_back(shard->mutex);
+    }
+    std::lock_guard<std::mutex> focus_lock(focus_mutex_);
+    
+    if (mutation_log_) mutation_log_->logClear();
+    change_feed_.publishClear();
+    
+    for (auto& shard : shards_) {
+        for (auto& slot : shard->slots) {
+            if (slot.atom) {
+                slot.atom->detachFromSpace();
+                slot.atom->handle_.store(AtomHandle(), std::memory_order_release);
+            }
+        }
+        
+        shard->slots.clear();
+        shard->chunk_versions.clear();
+        shard->free_slots.clear();
+        shard->live_atoms = 0;
+        shard->atoms_by_type.clear();
+        shard->atom_aliases.clear();
+        shard->atoms_by_name.clear();
+        shard->content_index.clear();
+        shard->name_counters.clear();
+        shard->reserved_names.clear();
+        shard->trust_links.clear();
+        for (auto& entry : shard->metadata_indices) {
+            entry.second.clear();  // the index itself stays declared
+        }
+        shard->attention.clear();
+        ++shard->version;
+    }
+    
+    capabilities_.clear();
+    graph_index_.clear();
+    embedding_index_.clear();
+    attentional_focus_.clear();
+    atom_counter_.reset();
+    
+    // Swap in a fresh arena; the old one is released with its last atom
+    arena_ = std::make_shared<AtomArena>(config_.arena);
+    
+    Utils::Logger::info("Cleared AgentSpace: " + name_);
+}
+
+std::map<std::string, size_t> AgentSpace::getStatistics() const {
+    std::map<std::string, size_t> stats;
+    stats["total_atoms"] = 0;
+    stats["slot_capacity"] = 0;
+    stats["shard_count"] = shards_.size();
+    stats["attention_blocks"] = 0;
+    stats["name_counters"] = 0;
+    
+    for (const auto& shard : shards_) {
+        auto lock = readLock(*shard);
+        
+        stats["total_atoms"] += shard->live_atoms;
+        stats["slot_capacity"] += shard->slots.size();
+        stats["attention_blocks"] += shard->attention.getBlockCount();
+        stats["name_counters"] += shard->name_counters.size();
+        
+        for (const auto& pair : shard->atoms_by_type) {
+            std::string type_name = "type_" + std::to_string(static_cast<int>(pair.first));
+            stats[type_name] += pair.second.size();
+        }
+    }
+    
+    stats["arena_reserved_bytes"] = arena_->getReservedBytes();
+    stats["arena_live_blocks"] = arena_->getLiveBlocks();
+    stats["embeddings"] = embedding_index_.size();
+    stats["embedding_reserved_bytes"] = embedding_index_.getReservedBytes();
+    
+    {
+        std::lock_guard<std::mutex> focus_lock(focus_mutex_);
+        stats["attentional_focus_size"] = attentional_focus_.size();
+    }
+    
+    return stats;
+}
+
+std::string AgentSpace::generateUniqueNodeName(const std::string& base) {
+    // The counter only skips suffixes already handed out; uniqueness comes
+    // from reserving the candidate under its name shard's lock, where both
+    // indexed names and other callers' reservations are visible
+    Shard& counter_shard = shardForKey(base);
+    
+    while (true) {
+        uint32_t suffix;
+        {
+            auto lock = writeLock(counter_shard);
+            suffix = counter_shard.name_counters[base]++;
+        }
+        
+        std::string candidate = suffix == 0 ? base : base + "_" + std::to_string(suffix);
+        Shard& name_shard = shardForKey(candidate);
+        auto lock = writeLock(name_shard);
+        if (name_shard.atoms_by_name.find(candidate) == name_shard.atoms_by_name.end() &&
+            name_shard.reserved_names.insert(candidate).second) {
+            return candidate;
+        }
+    }
+}
+
+void AgentSpace::releaseNodeName(const std::string& name) {
+    Shard& shard = shardForKey(name);
+    auto lock = writeLock(shard);
+    shard.reserved_names.erase(name);
+    if (shard.atoms_by_name.find(name) == shard.atoms_by_name.end()) {
+        shard.name_counters.erase(name);
+    }
+}
+
+AgentSpace::Shard& AgentSpace::shardForKey(const std::string& key) const {
+    if (shards_.size() == 1) return *shards_[0];
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+std::shared_lock<std::shared_mutex> AgentSpace::readLock(const Shard& shard) const {
+    if (t_batch_space == this) return std::shared_lock<std::shared_mutex>(shard.mutex, std::defer_lock);
+    return std::shared_lock<std::shared_mutex>(shard.mutex);
+}
+
+std::unique_lock<std::shared_mutex> AgentSpace::writeLock(Shard& shard) const {
+    if (t_batch_space == this) return std::unique_lock<std::shared_mutex>(shard.mutex, std::defer_lock);
+    return std::unique_lock<std::shared_mutex>(shard.mutex);
+}
+
+size_t AgentSpace::selectHomeShard() const {
+    if (shards_.size() == 1) return 0;
+    
+    // Keep each thread on its own shard so concurrent writers rarely collide
+    thread_local const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return thread_hash % shards_.size();
+}
+
+AtomPtr AgentSpace::insertIntoShard(const AtomPtr& atom, size_t shard_index, uint64_t content_key) {
+    Shard& shard = *shards_[shard_index];
+    auto lock = writeLock(shard);
+    
+    if (content_key) {
+        auto range = shard.content_index.equal_range(content_key);
+        for (auto it = range.first; it != range.second; ++it) {
+            AtomPtr existing = lookupLocked(shard, it->second);
+            if (existing && sameContent(*existing, *atom)) {
+                // Merged under the shard lock so concurrent duplicates revise in turn
+                existing->reviseTruthValue(atom->getTruthValue());
+                if (Utils::Logger::isEnabled(Utils::LogLevel::DEBUG)) {
+                    Utils::Logger::debug("Merged duplicate atom into: " + existing->getId());
+                }
+                return existing;
+            }
+        }
+    }
+    
+    uint32_t local_index;
+    if (!shard.free_slots.empty()) {
+        local_index = shard.free_slots.back();
+        shard.free_slots.pop_back();
+    } else {
+        // Global slot indices must still fit the 32-bit handle field
+        uint64_t next_global = static_cast<uint64_t>(shard.slots.size()) * shards_.size() + shard_index;
+        if (next_global > UINT32_MAX) {
+            Utils::Logger::error("AgentSpace " + name_ + " is out of atom slots");
+            return nullptr;
+        }
+        local_index = static_cast<uint32_t>(shard.slots.size());
+        shard.slots.emplace_back();
+    }
+    
+    AtomSlot& slot = shard.slots[local_index];
+    slot.atom = atom;
+    slot.content_key = content_key;
+    
+    uint32_t global_slot = static_cast<uint32_t>(local_index * shards_.size() + shard_index);
+    AtomHandle handle(global_slot, slot.generation);
+    atom->handle_.store(handle, std::memory_order_release);
+    // Logged before the atom is reachable, so its later changes follow the add
+    if (mutation_log_) mutation_log_->logAdd(*atom);
+    atom->attachToSpace(shard.attention, local_index, mutation_log_.get(), this);
+    change_feed_.publish(ChangeKind::ADDED, *atom, atom);
+    indexMetadata(shard, *atom, handle);
+    
+    shard.atoms_by_type[atom->getType()].insert(handle);
+    if (atom->getType() == AtomType::AGENT_NODE) {
+        capabilities_.setCapabilities(handle, parseCapabilities(atom->getMetadata(MetaKey::CAPABILITIES)));
+    }
+    if (content_key) {
+        shard.content_index.emplace(content_key, handle);
+    }
+    ++shard.live_atoms;
+    touchSlot(shard, local_index);
+    
+    return atom;
+}
 
 void AgentSpace::addAtomToIndices(const AtomPtr& atom) {
-    atoms_by_type_[atom->getType()].insert(atom->getId());
-    atoms_by_name_[atom->getName()].insert(atom->getId());
+    AtomHandle handle = atom->getHandle();
+    
+    {
+        Shard& shard = shardForKey(atom->getId());
+        auto lock = writeLock(shard);
+        shard.atom_aliases[atom->getId()] = handle;
+    }
+    
+    {
+        Shard& shard = shardForKey(atom->getName());
+        auto lock = writeLock(shard);
+        shard.atoms_by_name[atom->getName()].insert(handle);
+        shard.reserved_names.erase(atom->getName());
+    }
 }
 
 void AgentSpace::removeAtomFromIndices(const AtomPtr& atom) {
-    atoms_by_type_[atom->getType()].erase(atom->getId());
-    atoms_by_name_[atom->getName()].erase(atom->getId());
+    AtomHandle handle = atom->getHandle();
+    
+    {
+        Shard& shard = shardForKey(atom->getId());
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.atom_aliases.find(atom->getId());
+        if (it != shard.atom_aliases.end() && it->second == handle) {
+            shard.atom_aliases.erase(it);
+        }
+    }
+    
+    {
+        Shard& shard = shardForKey(atom->getName());
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.atoms_by_name.find(atom->getName());
+        if (it != shard.atoms_by_name.end()) {
+            it->second.erase(handle);
+            if (it->second.empty()) {
+                shard.atoms_by_name.erase(it);
+                // Names are probed again from the base once it is gone
+                shard.name_counters.erase(atom->getName());
+            }
+        }
+    }
+}
+
+bool AgentSpace::eraseAtom(AtomHandle handle) {
+    if (!handle.isValid()) return false;
+    
+    // A node nothing points at touches no link-derived index of another
+    // shard, so link inserts may go on meanwhile. Removing a link, or an atom
+    // links point at, takes the link-index lock exclusively.
+    std::shared_lock<std::shared_mutex> shared_link_lock(link_index_mutex_);
+    std::unique_lock<std::shared_mutex> link_lock;
+    
+    AtomPtr atom;
+    std::vector<AtomHandle> incoming;
+    {
+        Shard& shard = shardOf(handle);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        
+        atom = lookupLocked(shard, handle);
+        if (!atom) return false;
+        
+        if (dynamic_cast<const Link*>(atom.get()) || !shard.slots[localSlot(handle)].incoming.empty()) {
+            // Retaken in lock order: link index, then shard
+            lock.unlock();
+            shared_link_lock.unlock();
+            link_lock = std::unique_lock<std::shared_mutex>(link_index_mutex_);
+            lock.lock();
+            
+            atom = lookupLocked(shard, handle);
+            if (!atom) return false;
+        }
+        
+        AtomSlot& slot = shard.slots[localSlot(handle)];
+        incoming.swap(slot.incoming);
+        
+        auto type_it = shard.atoms_by_type.find(atom->getType());
+        if (type_it != shard.atoms_by_type.end()) {
+            type_it->second.erase(handle);
+        }
+        
+        if (slot.content_key) {
+            auto range = shard.content_index.equal_range(slot.content_key);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == handle) {
+                    shard.content_index.erase(it);
+                    break;
+                }
+            }
+            slot.content_key = 0;
+        }
+        
+        if (atom->getType() == AtomType::AGENT_NODE) {
+            capabilities_.removeAgent(handle);
+        }
+        unindexMetadata(shard, *atom, handle);
+        
+        if (mutation_log_) mutation_log_->logRemove(atom->getId());
+        change_feed_.publish(ChangeKind::REMOVED, *atom, atom);
+        atom->detachFromSpace();
+        slot.atom.reset();
+        // Skip generation 0 on wrap-around so stale handles never become valid
+        if (++slot.generation == 0) slot.generation = 1;
+        shard.free_slots.push_back(localSlot(handle));
+        --shard.live_atoms;
+        touchSlot(shard, localSlot(handle));
+    }
+    
+    removeAtomFromIndices(atom);
+    
+    if (auto link = std::dynamic_pointer_cast<Link>(atom)) {
+        removeFromIncomingSets(link);
+        unindexTrustLink(link);
+        graph_index_.linkRemoved(handle, link->getType());
+    }
+    unindexTrustLinksOf(incoming);
+    
+    // Cleared before the graph journal records the removal, so a link
+    // inserted meanwhile cannot journal an edge to this atom after it
+    atom->handle_.store(AtomHandle(), std::memory_order_release);
+    graph_index_.atomRemoved(handle);
+    embedding_index_.remove(handle);
+    return true;
+}
+
+void AgentSpace::setAtomMetadata(Atom& atom, MetadataKeyId key, MetadataValue value) {
+    AtomHandle handle = atom.getHandle();
+    if (handle.isValid()) {
+        Shard& shard = shardOf(handle);
+        // An agent's capabilities are mirrored in the registry, as in setAgentCapabilities
+        bool capabilities = key == MetaKey::CAPABILITIES && atom.getType() == AtomType::AGENT_NODE;
+        if (!capabilities) {
+            // Unindexed keys only need the atom to stay put
+            auto lock = readLock(shard);
+            if (lookupLocked(shard, handle).get() == &atom && !shard.metadata_indices.count(key)) {
+                std::lock_guard<std::mutex> atom_lock(atom.cold().mutex);
+                atom.storeMetadataLocked(key, std::move(value));
+                return;
+            }
+        }
+        
+        auto lock = writeLock(shard);
+        if (lookupLocked(shard, handle).get() == &atom) {
+            if (capabilities) {
+                const std::string* csv = std::get_if<std::string>(&value);
+                capabilities_.setCapabilities(handle, csv ? parseCapabilities(*csv) : std::vector<std::string>());
+            }
+            storeIndexedMetadata(shard, atom, handle, key, std::move(value));
+            return;
+        }
+    }
+    
+    // Removed since Atom::setMetadata looked, so it is detached by now
+    atom.setMetadata(key, std::move(value));
+}
+
+void AgentSpace::storeIndexedMetadata(Shard& shard, Atom& atom, AtomHandle handle,
+                                      MetadataKeyId key, MetadataValue value) {
+    auto index = shard.metadata_indices.find(key);
+    if (index == shard.metadata_indices.end()) {
+        std::lock_guard<std::mutex> lock(atom.cold().mutex);
+        atom.storeMetadataLocked(key, std::move(value));
+        return;
+    }
+    
+    std::optional<MetadataValue> previous;
+    {
+        std::lock_guard<std::mutex> lock(atom.cold().mutex);
+        previous = atom.storeMetadataLocked(key, value);
+    }
+    if (previous) {
+        unindexValue(index->second, *previous, handle);
+    }
+    index->second[std::move(value)].insert(handle);
+}
+
+void AgentSpace::indexMetadata(Shard& shard, const Atom& atom, AtomHandle handle) {
+    if (shard.metadata_indices.empty()) return;
+    
+    for (auto& entry : atom.getMetadataEntries()) {
+        auto index = shard.metadata_indices.find(entry.key);
+        if (index != shard.metadata_indices.end()) {
+            index->second[std::move(entry.value)].insert(handle);
+        }
+    }
+}
+
+void AgentSpace::unindexMetadata(Shard& shard, const Atom& atom, AtomHandle handle) {
+    if (shard.metadata_indices.empty()) return;
+    
+    for (const auto& entry : atom.getMetadataEntries()) {
+        auto index = shard.metadata_indices.find(entry.key);
+        if (index != shard.metadata_indices.end()) {
+            unindexValue(index->second, entry.value, handle);
+        }
+    }
+}
+
+void AgentSpace::unindexValue(MetadataIndex& index, const MetadataValue& value, AtomHandle handle) {
+    auto it = index.find(value);
+    if (it == index.end()) return;
+    
+    it->second.erase(handle);
+    if (it->second.empty()) {
+        index.erase(it);
+    }
+}
+
+uint64_t AgentSpace::contentKey(const AtomPtr& atom) const {
+    auto mix = [](uint64_t seed, uint64_t value) {
+        return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    };
+    
+    uint64_t key = mix(0, static_cast<uint64_t>(atom->getType()));
+    
+    if (auto link = std::dynamic_pointer_cast<Link>(atom)) {
+        // Links are only deduplicated when every target is stored here
+        for (const auto& target : link->getOutgoing()) {
+            if (!target || lookupAtom(target->getHandle()) != target) return 0;
+            key = mix(key, target->getHandle().value);
+        }
+    } else if (auto node = std::dynamic_pointer_cast<Node>(atom)) {
+        key = mix(key, std::hash<std::string>{}(node->getName()));
+        key = mix(key, std::hash<std::string>{}(node->getValue()));
+    } else {
+        return 0;
+    }
+    
+    return key ? key : 1;
+}
+
+bool AgentSpace::sameContent(const Atom& a, const Atom& b) {
+    if (a.getType() != b.getType()) return false;
+    
+    auto* link_a = dynamic_cast<const Link*>(&a);
+    auto* link_b = dynamic_cast<const Link*>(&b);
+    if (link_a && link_b) {
+        const auto& out_a = link_a->getOutgoing();
+        const auto& out_b = link_b->getOutgoing();
+        if (out_a.size() != out_b.size()) return false;
+        
+        for (size_t i = 0; i < out_a.size(); ++i) {
+            if (out_a[i]->getHandle() != out_b[i]->getHandle()) return false;
+        }
+        return true;
+    }
+    
+    auto* node_a = dynamic_cast<const Node*>(&a);
+    auto* node_b = dynamic_cast<const Node*>(&b);
+    return node_a && node_b && node_a->getName() == node_b->getName() &&
+           node_a->getValue() == node_b->getValue();
+}
+
+void AgentSpace::addToIncomingSets(const LinkPtr& link) {
+    AtomHandle link_handle = link->getHandle();
+    
+    for (const auto& target : link->getOutgoing()) {
+        if (!target) continue;
+        
+        AtomHandle target_handle = target->getHandle();
+        if (!target_handle.isValid()) continue;
+        
+        // Targets that are not (yet) stored in this space are not indexed
+        Shard& shard = shardOf(target_handle);
+        auto lock = writeLock(shard);
+        if (lookupLocked(shard, target_handle) == target) {
+            shard.slots[localSlot(target_handle)].incoming.push_back(link_handle);
+            touchSlot(shard, localSlot(target_handle));
+        }
+    }
+}
+
+void AgentSpace::removeFromIncomingSets(const LinkPtr& link) {
+    AtomHandle link_handle = link->getHandle();
+    
+    for (const auto& target : link->getOutgoing()) {
+        if (!target) continue;
+        
+        AtomHandle target_handle = target->getHandle();
+        if (!target_handle.isValid()) continue;
+        
+        Shard& shard = shardOf(target_handle);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (lookupLocked(shard, target_handle) != target) continue;
+        
+        auto& incoming = shard.slots[localSlot(target_handle)].incoming;
+        auto it = std::find(incoming.begin(), incoming.end(), link_handle);
+        if (it != incoming.end()) {
+            *it = incoming.back();
+            incoming.pop_back();
+            touchSlot(shard, localSlot(target_handle));
+        }
+    }
+}
+
+void AgentSpace::indexTrustLink(const LinkPtr& link) {
+    if (link->getType() != AtomType::TRUST_LINK || link->getArity() != 2) return;
+    
+    const auto& outgoing = link->getOutgoing();
+    AtomHandle first = outgoing[0] ? outgoing[0]->getHandle() : AtomHandle();
+    AtomHandle second = outgoing[1] ? outgoing[1]->getHandle() : AtomHandle();
+    if (!lookupAtom(first) || !lookupAtom(second)) return;
+    
+    // The most recently added link for a pair wins. Inserts run concurrently
+    // and only removals are excluded, so the pair's shard lock orders them.
+    uint64_t key = trustKey(first, second);
+    Shard& shard = shardForTrustKey(key);
+    auto lock = writeLock(shard);
+    shard.trust_links[key] = link->getHandle();
+}
+
+void AgentSpace::unindexTrustLink(const LinkPtr& link) {
+    if (link->getType() != AtomType::TRUST_LINK || link->getArity() != 2) return;
+    
+    const auto& outgoing = link->getOutgoing();
+    AtomHandle first = outgoing[0] ? outgoing[0]->getHandle() : AtomHandle();
+    AtomHandle second = outgoing[1] ? outgoing[1]->getHandle() : AtomHandle();
+    if (!lookupAtom(first) || !lookupAtom(second)) return;
+    
+    uint64_t key = trustKey(first, second);
+    Shard& shard = shardForTrustKey(key);
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.trust_links.find(key);
+        if (it == shard.trust_links.end() || it->second != link->getHandle()) return;
+        shard.trust_links.erase(it);
+    }
+    
+    // Fall back to another trust link between the same pair, if any
+    for (const auto& candidate : resolveHandles(copyIncoming(first))) {
+        if (candidate->getType() != AtomType::TRUST_LINK) continue;
+        
+        const auto& ends = std::static_pointer_cast<Link>(candidate)->getOutgoing();
+        if (ends.size() == 2 && ends[0] && ends[1] &&
+            trustKey(ends[0]->getHandle(), ends[1]->getHandle()) == key) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.trust_links[key] = candidate->getHandle();
+            break;
+        }
+    }
+}
+
+void AgentSpace::unindexTrustLinksOf(const std::vector<AtomHandle>& incoming) {
+    // Removing an agent drops every pair entry that refers to its slot
+    for (const auto& link_atom : resolveHandles(incoming)) {
+        if (link_atom->getType() != AtomType::TRUST_LINK) continue;
+        
+        const auto& ends = std::static_pointer_cast<Link>(link_atom)->getOutgoing();
+        if (ends.size() != 2 || !ends[0] || !ends[1]) continue;
+        
+        uint64_t key = trustKey(ends[0]->getHandle(), ends[1]->getHandle());
+        Shard& shard = shardForTrustKey(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.trust_links.find(key);
+        if (it != shard.trust_links.end() && it->second == link_atom->getHandle()) {
+            shard.trust_links.erase(it);
+        }
+    }
+}
+
+uint64_t AgentSpace::trustKey(AtomHandle agent1, AtomHandle agent2) {
+    uint32_t low = std::min(agent1.slot(), agent2.slot());
+    uint32_t high = std::max(agent1.slot(), agent2.slot());
+    return (static_cast<uint64_t>(high) << 32) | low;
+}
+
+AtomPtr AgentSpace::lookupAtom(AtomHandle handle) const {
+    if (!handle.isValid()) return nullptr;
+    
+    const Shard& shard = shardOf(handle);
+    auto lock = readLock(shard);
+    return lookupLocked(shard, handle);
+}
+
+AtomPtr AgentSpace::lookupLocked(const Shard& shard, AtomHandle handle) const {
+    if (!handle.isValid()) return nullptr;
+    
+    uint32_t local_index = localSlot(handle);
+    if (local_index >= shard.slots.size()) return nullptr;
+    
+    const AtomSlot& slot = shard.slots[local_index];
+    return (slot.generation == handle.generation()) ? slot.atom : nullptr;
+}
+
+bool AgentSpace::isStoredLocked(const Shard& shard, AtomHandle handle) const {
+    uint32_t local_index = localSlot(handle);
+    if (!handle.isValid() || local_index >= shard.slots.size()) return false;
+    
+    const AtomSlot& slot = shard.slots[local_index];
+    return slot.atom && slot.generation == handle.generation();
+}
+
+AtomHandle AgentSpace::resolveAlias(const AtomId& id) const {
+    {
+        const Shard& shard = shardForKey(id);
+        auto lock = readLock(shard);
+        
+        auto it = shard.atom_aliases.find(id);
+        if (it != shard.atom_aliases.end()) return it->second;
+    }
+    
+    // An opened snapshot may not have reached the atom yet
+    return loadSnapshotAlias(id);
+}
+
+std::vector<AtomHandle> AgentSpace::copyIncoming(AtomHandle handle) const {
+    if (!handle.isValid()) return {};
+    
+    const Shard& shard = shardOf(handle);
+    auto lock = readLock(shard);
+    return lookupLocked(shard, handle) ? shard.slots[localSlot(handle)].incoming : std::vector<AtomHandle>();
+}
+
+std::vector<AtomPtr> AgentSpace::resolveHandles(const std::vector<AtomHandle>& handles) const {
+    std::vector<AtomPtr> result;
+    result.reserve(handles.size());
+    
+    if (shards_.size() == 1) {
+        auto lock = readLock(*shards_[0]);
+        for (AtomHandle handle : handles) {
+            if (auto atom = lookupLocked(*shards_[0], handle)) {
+                result.push_back(std::move(atom));
+            }
+        }
+        return result;
+    }
+    
+    // Group by shard so each shard lock is taken once
+    std::vector<AtomHandle> sorted = handles;
+    std::sort(sorted.begin(), sorted.end(), [this](AtomHandle a, AtomHandle b) {
+        return a.slot() % shards_.size() < b.slot() % shards_.size();
+    });
+    
+    size_t i = 0;
+    while (i < sorted.size()) {
+        const Shard& shard = shardOf(sorted[i]);
+        auto lock = readLock(shard);
+        
+        for (; i < sorted.size() && &shardOf(sorted[i]) == &shard; ++i) {
+            if (auto atom = lookupLocked(shard, sorted[i])) {
+                result.push_back(std::move(atom));
+            }
+        }
+    }
+    
+    return result;
+}
+
+LinkPtr AgentSpace::lookupTrustLink(AtomHandle agent1, AtomHandle agent2) const {
+    if (!lookupAtom(agent1) || !lookupAtom(agent2)) return nullptr;
+    loadSnapshotIncoming(agent1);
+    
+    AtomHandle link_handle;
+    {
+        uint64_t key = trustKey(agent1, agent2);
+        const Shard& shard = shardForTrustKey(key);
+        auto lock = readLock(shard);
+        auto it = shard.trust_links.find(key);
+        if (it == shard.trust_links.end()) return nullptr;
+        link_handle = it->second;
+    }
+    
+    auto link_atom = lookupAtom(link_handle);
+    return link_atom ? std::static_pointer_cast<Link>(link_atom) : nullptr;
+}
+
+std::shared_ptr<const AgentSpace::ShardView> AgentSpace::buildShardView(const Shard& shard) {
+    constexpr uint32_t kChunkSlots = ShardView::kChunkSlots;
+    const ShardView* previous = shard.view.get();
+    
+    auto view = std::make_shared<ShardView>();
+    view->version = shard.version;
+    view->slot_count = static_cast<uint32_t>(shard.slots.size());
+    view->live_atoms = shard.live_atoms;
+    
+    size_t chunk_count = (shard.slots.size() + kChunkSlots - 1) / kChunkSlots;
+    view->chunks.reserve(chunk_count);
+    view->chunk_versions.reserve(chunk_count);
+    for (size_t c = 0; c < chunk_count; ++c) {
+        uint64_t chunk_version = shard.chunk_versions[c];
+        view->chunk_versions.push_back(chunk_version);
+        
+        // Every write to a slot stamps its chunk, so an equal stamp means
+        // the previous copy still matches slot for slot
+        if (previous && c < previous->chunks.size() && previous->chunk_versions[c] == chunk_version) {
+            view->chunks.push_back(previous->chunks[c]);
+            continue;
+        }
+        
+        auto first = shard.slots.begin() + c * kChunkSlots;
+        auto last = shard.slots.begin() + std::min<size_t>((c + 1) * kChunkSlots, shard.slots.size());
+        view->chunks.push_back(std::make_shared<const ShardView::Chunk>(first, last));
+    }
+    
+    return view;
+}
+
+void AgentSpace::touchSlot(Shard& shard, uint32_t local_slot) {
+    ++shard.version;
+    
+    size_t chunk = local_slot / ShardView::kChunkSlots;
+    if (shard.chunk_versions.size() <= chunk) {
+        shard.chunk_versions.resize(chunk + 1, 0);
+    }
+    shard.chunk_versions[chunk] = shard.version;
+}
+
+const AgentSpace::ShardView::Index& AgentSpace::ShardView::index() const {
+    std::call_once(index_once_, [this] {
+        for (uint32_t i = 0; i < slot_count; ++i) {
+            const auto& atom = slot(i).atom;
+            if (!atom) continue;
+            
+            index_.atoms_by_type[atom->getType()].push_back(i);
+            index_.atoms_by_name[atom->getName()].push_back(i);
+            index_.atoms_by_id[atom->getId()] = i;
+        }
+    });
+    return index_;
+}
+
+// LinkBatch Implementation
+LinkPtr LinkBatch::add(AtomType type, const std::vector<AtomPtr>& outgoing, const std::string& name) {
+    auto link = agentspace_.createLink(type, outgoing, name);
+    links_.push_back(link);
+    return link;
+}
+
+std::vector<AtomPtr> LinkBatch::commit() {
+    auto stored = agentspace_.addAtoms(links_);
+    links_.clear();
+    return stored;
+}
+
+// AgentSpaceSnapshot Implementation
+size_t AgentSpaceSnapshot::getAtomCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+        count += shard->live_atoms;
+    }
+    return count;
+}
+
+AtomPtr AgentSpaceSnapshot::getAtom(const AtomId& id) const {
+    for (const auto& shard : shards_) {
+        const auto& index = shard->index().atoms_by_id;
+        auto it = index.find(id);
+        if (it != index.end()) {
+            return shard->slot(it->second).atom;
+        }
+    }
+    return nullptr;
+}
+
+AtomPtr AgentSpaceSnapshot::getAtom(AtomHandle handle) const {
+    const AgentSpace::AtomSlot* slot = slotOf(handle);
+    return slot ? slot->atom : nullptr;
+}
+
+std::vector<AtomPtr> AgentSpaceSnapshot::getAtoms() const {
+    std::vector<AtomPtr> result;
+    result.reserve(getAtomCount());
+    
+    for (const auto& shard : shards_) {
+        for (const auto& chunk : shard->chunks) {
+            for (const auto& slot : *chunk) {
+                if (slot.atom) {
+                    result.push_back(slot.atom);
+                }
+            }
+        }
+    }
+    
+    return result;
+}
+
+std::vector<AtomPtr> AgentSpaceSnapshot::getAtomsByType(AtomType type) const {
+    std::vector<AtomPtr> result;
+    
+    for (const auto& shard : shards_) {
+        const auto& index = shard->index().atoms_by_type;
+        auto it = index.find(type);
+        if (it == index.end()) continue;
+        
+        for (uint32_t local_slot : it->second) {
+            result.push_back(shard->slot(local_slot).atom);
+        }
+    }
+    
+    return result;
+}
+
+std::vector<AtomPtr> AgentSpaceSnapshot::getAtomsByName(const std::string& name) const {
+    std::vector<AtomPtr> result;
+    
+    for (const auto& shard : shards_) {
+        const auto& index = shard->index().atoms_by_name;
+        auto it = index.find(name);
+        if (it == index.end()) continue;
+        
+        for (uint32_t local_slot : it->second) {
+            result.push_back(shard->slot(local_slot).atom);
+        }
+    }
+    
+    return result;
+}
+
+std::vector<LinkPtr> AgentSpaceSnapshot::getIncoming(AtomHandle handle) const {
+    std::vector<LinkPtr> result;
+    
+    const AgentSpace::AtomSlot* slot = slotOf(handle);
+    if (!slot) return result;
+    
+    for (AtomHandle link_handle : slot->incoming) {
+        if (auto link_atom = getAtom(link_handle)) {
+            result.push_back(std::static_pointer_cast<Link>(link_atom));
+        }
+    }
+    
+    return result;
+}
+
+const AgentSpace::AtomSlot* AgentSpaceSnapshot::slotOf(AtomHandle handle) const {
+    if (!handle.isValid() || shards_.empty()) return nullptr;
+    
+    const auto& shard = *shards_[handle.slot() % shards_.size()];
+    uint32_t local_slot = static_cast<uint32_t>(handle.slot() / shards_.size());
+    if (local_slot >= shard.slot_count) return nullptr;
+    
+    const auto& slot = shard.slot(local_slot);
+    return (slot.atom && slot.generation == handle.generation()) ? &slot : nullptr;
 }
 
 // Factory functions
 NodePtr createAgentNode(const std::string& name, const std::vector<std::string>& capabilities) {
-    auto node = std::make_shared<Node>(AtomType::AGENT_NODE, name);
+    auto node = allocateAtom<Node>(AtomArena::defaultArena(), AtomType::AGENT_NODE, name);
     
     std::ostringstream cap_stream;
     for (size_t i = 0; i < capabilities.size(); ++i) {
         if (i > 0) cap_stream << ",";
         cap_stream << capabilities[i];
     }
-    node->setMetadata("capabilities", cap_stream.str());
+    node->setMetadata(MetaKey::CAPABILITIES, cap_stream.str());
     
     return node;
 }
 
 NodePtr createCapabilityNode(const std::string& name, const std::string& description) {
-    return std::make_shared<Node>(AtomType::CAPABILITY_NODE, name, description);
+    return allocateAtom<Node>(AtomArena::defaultArena(), AtomType::CAPABILITY_NODE, name, description);
 }
 
 LinkPtr createTrustLink(const AtomPtr& agent1, const AtomPtr& agent2, double trust_level) {
-    auto link = std::make_shared<Link>(AtomType::TRUST_LINK, std::vector<AtomPtr>{agent1, agent2});
+    auto link = allocateAtom<Link>(AtomArena::defaultArena(), AtomType::TRUST_LINK, std::vector<AtomPtr>{agent1, agent2});
     link->setTruthValue(TruthValue(trust_level, 0.5));
     return link;
 }
 
 LinkPtr createCollaborationLink(const AtomPtr& agent1, const AtomPtr& agent2, const std::string& type) {
-    auto link = std::make_shared<Link>(AtomType::COLLABORATION_LINK, std::vector<AtomPtr>{agent1, agent2});
-    link->setMetadata("collaboration_type", type);
+    auto link = allocateAtom<Link>(AtomArena::defaultArena(), AtomType::COLLABORATION_LINK, std::vector<AtomPtr>{agent1, agent2});
+    link->setMetadata(MetaKey::COLLABORATION_TYPE, type);
     return link;
 }
 
@@ -0,0 +1,222 @@
+#include "swarmcog/atom_arena.h"
+#include "swarmcog/utils.h"
+#include <algorithm>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace SwarmCog {
+
+// AtomArena Implementation
+AtomArena::AtomArena(const AtomArenaConfig& config) : config_(config) {
+    if (config_.slab_size < 4096) {
+        config_.slab_size = 4096;
+    }
+
+    // Huge pages only pay off when a slab covers at least one of them
+    if (config_.use_huge_pages && config_.slab_size % kHugePageSize != 0) {
+        config_.slab_size = ((config_.slab_size + kHugePageSize - 1) / kHugePageSize) * kHugePageSize;
+    }
+
+    stripe_count_ = config_.stripes ? config_.stripes : Utils::ThreadUtils::getOptimalThreadCount();
+    stripe_count_ = std::max<size_t>(stripe_count_, 1);
+    stripes_ = std::make_unique<Stripe[]>(stripe_count_);
+}
+
+AtomArena::~AtomArena() {
+    for (const auto& slab : slabs_) {
+        releaseSlab(slab);
+    }
+}
+
+void* AtomArena::allocate(size_t size, size_t alignment) {
+    if (!isPooled(size, alignment)) {
+        return ::operator new(size);
+    }
+
+    size_t block_size = ((size + kBlockAlignment - 1) / kBlockAlignment) * kBlockAlignment;
+
+    Stripe& stripe = stripeForThread();
+    std::unique_lock<std::mutex> lock(stripe.mutex);
+
+    Pool* pool = &poolFor(stripe, block_size);
+    if (!pool->free_list && pool->cursor == pool->end) {
+        // Before taking a new slab, collect blocks other threads freed into
+        // their own stripes. Only one stripe lock is ever held at a time.
+        lock.unlock();
+        FreeBlock* reclaimed = reclaim(stripe, block_size);
+        lock.lock();
+
+        pool = &poolFor(stripe, block_size);
+        if (reclaimed) {
+            FreeBlock* tail = reclaimed;
+            while (tail->next) tail = tail->next;
+            tail->next = pool->free_list;
+            pool->free_list = reclaimed;
+        }
+    }
+
+    void* block;
+    if (pool->free_list) {
+        block = pool->free_list;
+        pool->free_list = pool->free_list->next;
+    } else {
+        if (pool->cursor == pool->end) {
+            refill(*pool);
+        }
+        block = pool->cursor;
+        pool->cursor += block_size;
+    }
+
+    ++stripe.live_blocks;
+    return block;
+}
+
+void AtomArena::deallocate(void* ptr, size_t size, size_t alignment) {
+    if (!ptr) return;
+
+    if (!isPooled(size, alignment)) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    size_t block_size = ((size + kBlockAlignment - 1) / kBlockAlignment) * kBlockAlignment;
+
+    Stripe& stripe = stripeForThread();
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+
+    Pool& pool = poolFor(stripe, block_size);
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = pool.free_list;
+    pool.free_list = block;
+
+    --stripe.live_blocks;
+}
+
+size_t AtomArena::getReservedBytes() const {
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    return reserved_bytes_;
+}
+
+size_t AtomArena::getLiveBlocks() const {
+    std::ptrdiff_t live = 0;
+    for (size_t i = 0; i < stripe_count_; ++i) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        live += stripes_[i].live_blocks;
+    }
+    return live > 0 ? static_cast<size_t>(live) : 0;
+}
+
+size_t AtomArena::getSlabCount() const {
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    return slabs_.size();
+}
+
+std::shared_ptr<AtomArena> AtomArena::defaultArena() {
+    static std::shared_ptr<AtomArena> arena = std::make_shared<AtomArena>();
+    return arena;
+}
+
+bool AtomArena::isPooled(size_t size, size_t alignment) const {
+    // Oversized or over-aligned requests bypass the slabs
+    return alignment <= kBlockAlignment && size <= config_.slab_size / 16;
+}
+
+AtomArena::Stripe& AtomArena::stripeForThread() const {
+    // Threads take stripes round-robin in the order they first allocate
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed);
+    return stripes_[stripe % stripe_count_];
+}
+
+AtomArena::FreeBlock* AtomArena::reclaim(const Stripe& self, size_t block_size) {
+    for (size_t i = 0; i < stripe_count_; ++i) {
+        Stripe& other = stripes_[i];
+        if (&other == &self) continue;
+
+        std::lock_guard<std::mutex> lock(other.mutex);
+        for (auto& pool : other.pools) {
+            if (pool.block_size == block_size && pool.free_list) {
+                FreeBlock* blocks = pool.free_list;
+                pool.free_list = nullptr;
+                return blocks;
+            }
+        }
+    }
+    return nullptr;
+}
+
+AtomArena::Pool& AtomArena::poolFor(Stripe& stripe, size_t block_size) {
+    // Only a handful of atom types exist, so a linear probe beats a map here
+    for (auto& pool : stripe.pools) {
+        if (pool.block_size == block_size) {
+            return pool;
+        }
+    }
+
+    stripe.pools.emplace_back();
+    stripe.pools.back().block_size = block_size;
+    return stripe.pools.back();
+}
+
+void AtomArena::refill(Pool& pool) {
+    Slab slab = acquireSlab(config_.slab_size);
+    {
+        std::lock_guard<std::mutex> lock(slab_mutex_);
+        slabs_.push_back(slab);
+        reserved_bytes_ += slab.size;
+    }
+
+    pool.cursor = static_cast<char*>(slab.memory);
+    pool.end = pool.cursor + (slab.size / pool.block_size) * pool.block_size;
+}
+
+AtomArena::Slab AtomArena::acquireSlab(size_t size) {
+    Slab slab;
+    slab.size = size;
+
+#ifdef __linux__
+    if (config_.use_huge_pages) {
+#ifdef MAP_HUGETLB
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            slab.memory = memory;
+            slab.mapped = true;
+            return slab;
+        }
+#endif
+        // No reserved huge pages; fall back to transparent huge pages
+        void* memory_thp = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory_thp != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(memory_thp, size, MADV_HUGEPAGE);
+#endif
+            slab.memory = memory_thp;
+            slab.mapped = true;
+            return slab;
+        }
+
+        Utils::Logger::warning("AtomArena: huge page allocation failed, using regular pages");
+    }
+#endif
+
+    slab.memory = ::operator new(size);
+    slab.mapped = false;
+    return slab;
+}
+
+void AtomArena::releaseSlab(const Slab& slab) {
+#ifdef __linux__
+    if (slab.mapped) {
+        munmap(slab.memory, slab.size);
+        return;
+    }
+#endif
+    ::operator delete(slab.memory);
+}
+
+} // namespace SwarmCog
@@ -0,0 +1,304 @@
+#include "swarmcog/attention_columns.h"
+#include <cmath>
+#include <queue>
+#include <unordered_set>
+
+namespace SwarmCog {
+
+// Per-tick retention and carry-over of the STI -> LTI -> VLTI recurrence
+static constexpr double kStiRetention = 0.99;
+static constexpr double kLtiRetention = 0.999;
+static constexpr double kLtiGain = 0.001;
+static constexpr double kVltiRetention = 0.9999;
+static constexpr double kVltiGain = 0.0001;
+
+// AttentionBlock Implementation
+void AttentionBlock::decay(double& sti, double& lti, double& vlti, uint64_t ticks) {
+    if (ticks == 0) return;
+
+    // One step is s' = a*s, l' = b*l + c*s', v' = d*v + e*l'. Unrolling n
+    // steps gives geometric sums, so any number of missed ticks costs the
+    // same three powers.
+    const double a = kStiRetention, b = kLtiRetention, c = kLtiGain;
+    const double d = kVltiRetention, e = kVltiGain;
+    const double n = static_cast<double>(ticks);
+    const double an = std::pow(a, n), bn = std::pow(b, n), dn = std::pow(d, n);
+
+    // l_n = b^n*l + k*(b^n - a^n), with k the STI share feeding into LTI
+    const double k = c * a * sti / (b - a);
+    const double s_n = an * sti;
+    const double l_n = bn * lti + k * (bn - an);
+
+    // v_n = d^n*v + e * sum_{j=1..n} d^(n-j) * l_j
+    const double sum_b = b * (dn - bn) / (d - b);
+    const double sum_a = a * (dn - an) / (d - a);
+    const double v_n = dn * vlti + e * (lti * sum_b + k * (sum_b - sum_a));
+
+    sti = s_n;
+    lti = l_n;
+    vlti = v_n;
+}
+
+const double AttentionBlock::kRates[AttentionBlock::kTerms] = {kStiRetention, kLtiRetention, kVltiRetention};
+
+void AttentionBlock::split(double sti, double lti, double vlti, double terms[kTerms]) {
+    // Regrouping decay()'s result by power: with k as there, importance n
+    // ticks on is A*a^n + B*b^n + D*d^n
+    const double a = kStiRetention, b = kLtiRetention, c = kLtiGain;
+    const double d = kVltiRetention, e = kVltiGain;
+    const double k = c * a * sti / (b - a);
+    const double from_a = e * k * a / (d - a);
+    const double from_b = e * (lti + k) * b / (d - b);
+
+    terms[0] = sti - k + from_a;
+    terms[1] = lti + k - from_b;
+    terms[2] = vlti + from_b - from_a;
+}
+
+// AttentionColumns Implementation
+void AttentionColumns::bind(uint32_t slot, const AttentionValue& av) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t block_index = slot / AttentionBlock::kCapacity;
+    if (blocks_.size() <= block_index) {
+        while (blocks_.size() <= block_index) {
+            blocks_.push_back(std::make_unique<AttentionBlock>());
+        }
+
+        // Lock-free readers may still hold the old directory, so it is kept
+        auto directory = std::make_unique<Directory>();
+        for (const auto& block : blocks_) {
+            directory->push_back(block.get());
+        }
+        directory_.store(directory.get(), std::memory_order_release);
+        directories_.push_back(std::move(directory));
+    }
+
+    write(slot, av);
+    link(slot);
+}
+
+AttentionValue AttentionColumns::unbind(uint32_t slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    unlink(slot);
+
+    AttentionValue av;
+    read(slot, av);
+    return av;
+}
+
+AttentionValue AttentionColumns::load(uint32_t slot) const {
+    AttentionValue av;
+    read(slot, av);
+    return av;
+}
+
+void AttentionColumns::store(uint32_t slot, const AttentionValue& av) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write(slot, av);
+}
+
+void AttentionColumns::loadSti(const std::vector<uint32_t>& slots, std::vector<double>& sti) const {
+    sti.resize(slots.size());
+    AttentionValue av;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        read(slots[i], av);
+        sti[i] = av.sti;
+    }
+}
+
+void AttentionColumns::addSti(const std::vector<std::pair<uint32_t, double>>& deltas) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    AttentionValue av;
+    for (const auto& delta : deltas) {
+        read(delta.first, av);
+        av.sti = std::clamp(av.sti + delta.second, -1.0, 1.0);
+        write(delta.first, av);
+    }
+}
+
+void AttentionColumns::advance() {
+    // Under the lock so writers stamp against a clock top() agrees with
+    std::lock_guard<std::mutex> lock(mutex_);
+    tick_.fetch_add(1, std::memory_order_release);
+}
+
+void AttentionColumns::sweep(size_t slot_count) {
+    size_t used_blocks = (slot_count + AttentionBlock::kCapacity - 1) / AttentionBlock::kCapacity;
+
+    for (size_t b = 0; ; ++b) {
+        // Re-locked per block so setters are never stalled for a whole shard
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (b >= blocks_.size() || b >= used_blocks) break;
+
+        AttentionBlock& block = *blocks_[b];
+        AttentionValue av;
+        for (uint32_t i = 0; i < AttentionBlock::kCapacity; ++i) {
+            if (!block.indexed[i] || block.stamp[i].load(std::memory_order_relaxed) == tick_.load(std::memory_order_relaxed)) continue;
+
+            uint32_t slot = static_cast<uint32_t>(b * AttentionBlock::kCapacity + i);
+            read(slot, av);
+            write(slot, av);
+        }
+    }
+}
+
+uint64_t AttentionColumns::getTick() const {
+    return tick_.load(std::memory_order_acquire);
+}
+
+void AttentionColumns::read(uint32_t slot, AttentionValue& av) const {
+    const AttentionBlock& block = blockOf(slot);
+    uint32_t i = indexInBlock(slot);
+
+    uint64_t stamp;
+    while (true) {
+        uint64_t version = block.sequence.load(std::memory_order_acquire);
+        if (version & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        av.sti = block.sti[i].load(std::memory_order_relaxed);
+        av.lti = block.lti[i].load(std::memory_order_relaxed);
+        av.vlti = block.vlti[i].load(std::memory_order_relaxed);
+        stamp = block.stamp[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block.sequence.load(std::memory_order_relaxed) == version) break;
+    }
+
+    // A write stamped after this reader saw the clock is simply current
+    uint64_t tick = tick_.load(std::memory_order_acquire);
+    AttentionBlock::decay(av.sti, av.lti, av.vlti, tick > stamp ? tick - stamp : 0);
+}
+
+void AttentionColumns::write(uint32_t slot, const AttentionValue& av) {
+    AttentionBlock& block = blockOf(slot);
+    uint32_t i = indexInBlock(slot);
+
+    bool indexed = block.indexed[i];
+    if (indexed) unlink(slot);
+
+    // Writers are serialized by mutex_, so the sequence needs no CAS
+    uint64_t version = block.sequence.load(std::memory_order_relaxed);
+    block.sequence.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    block.sti[i].store(av.sti, std::memory_order_relaxed);
+    block.lti[i].store(av.lti, std::memory_order_relaxed);
+    block.vlti[i].store(av.vlti, std::memory_order_relaxed);
+    block.stamp[i].store(tick_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    block.sequence.store(version + 2, std::memory_order_release);
+
+    if (indexed) link(slot);
+}
+
+double AttentionColumns::termAt(uint32_t slot, size_t j) const {
+    const AttentionBlock& block = blockOf(slot);
+    uint32_t i = indexInBlock(slot);
+
+    double value = block.term[j][i];
+    uint64_t ticks = tick_.load(std::memory_order_relaxed) - block.stamp[i].load(std::memory_order_relaxed);
+    return ticks ? value * std::pow(AttentionBlock::kRates[j], static_cast<double>(ticks)) : value;
+}
+
+double AttentionColumns::score(uint32_t slot) const {
+    double sum = 0.0;
+    for (size_t j = 0; j < AttentionBlock::kTerms; ++j) {
+        sum += termAt(slot, j);
+    }
+    return sum;
+}
+
+std::vector<std::pair<double, uint32_t>> AttentionColumns::top(size_t limit) const {
+    std::vector<std::pair<double, uint32_t>> result;
+    if (limit == 0) return result;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Threshold algorithm over the three term indices: after each round of
+    // reads, no unread slot can score above the terms under the cursors
+    using Scored = std::pair<double, uint32_t>;
+    std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored>> best;
+    std::unordered_set<uint32_t> seen;
+    TermIndex::const_iterator cursor[AttentionBlock::kTerms];
+    for (size_t j = 0; j < AttentionBlock::kTerms; ++j) {
+        cursor[j] = terms_[j].begin();
+    }
+
+    while (cursor[0] != terms_[0].end()) {
+        double threshold = 0.0;
+        for (size_t j = 0; j < AttentionBlock::kTerms; ++j) {
+            uint32_t slot = std::get<2>(*cursor[j]++);
+            threshold += termAt(slot, j);
+            if (!seen.insert(slot).second) continue;
+
+            best.emplace(score(slot), slot);
+            if (best.size() > limit) best.pop();
+        }
+        if (best.size() == limit && best.top().first >= threshold) break;
+    }
+
+    // Reported values are the slots' decayed state, as load() returns it
+    result.reserve(best.size());
+    AttentionValue av;
+    for (; !best.empty(); best.pop()) {
+        uint32_t slot = best.top().second;
+        read(slot, av);
+        result.emplace_back(importance(av.sti, av.lti, av.vlti), slot);
+    }
+    std::sort(result.begin(), result.end(), std::greater<std::pair<double, uint32_t>>());
+
+    return result;
+}
+
+size_t AttentionColumns::getBlockCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.size();
+}
+
+void AttentionColumns::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& index : terms_) {
+        index.clear();
+    }
+    for (auto& block : blocks_) {
+        std::fill(std::begin(block->indexed), std::end(block->indexed), false);
+    }
+}
+
+void AttentionColumns::link(uint32_t slot) {
+    AttentionBlock& block = blockOf(slot);
+    uint32_t i = indexInBlock(slot);
+
+    double terms[AttentionBlock::kTerms];
+    AttentionBlock::split(block.sti[i].load(std::memory_order_relaxed), block.lti[i].load(std::memory_order_relaxed),
+                          block.vlti[i].load(std::memory_order_relaxed), terms);
+
+    for (size_t j = 0; j < AttentionBlock::kTerms; ++j) {
+        // Keyed by the term scaled back to tick 0, which orders the same at
+        // every tick; NaN ranks with zero so it cannot break the ordering
+        double value = std::isnan(terms[j]) ? 0.0 : terms[j];
+        int sign = (value > 0.0) - (value < 0.0);
+        double key = sign ? std::log(std::abs(value)) -
+                                static_cast<double>(block.stamp[i].load(std::memory_order_relaxed)) * std::log(AttentionBlock::kRates[j])
+                          : 0.0;
+
+        block.term[j][i] = value;
+        block.rank[j][i] = terms_[j].emplace(sign, sign * key, slot).first;
+    }
+    block.indexed[i] = true;
+}
+
+void AttentionColumns::unlink(uint32_t slot) {
+    AttentionBlock& block = blockOf(slot);
+    uint32_t i = indexInBlock(slot);
+    if (!block.indexed[i]) return;
+
+    for (size_t j = 0; j < AttentionBlock::kTerms; ++j) {
+        terms_[j].erase(block.rank[j][i]);
+    }
+    block.indexed[i] = false;
+}
+
+} // namespace SwarmCog
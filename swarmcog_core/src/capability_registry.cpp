@@ -0,0 +1,232 @@
+#include "swarmcog/capability_registry.h"
+
+namespace SwarmCog {
+
+static size_t roundToBlocks(size_t words) {
+    constexpr size_t block = CapabilityRegistry::kBlockWords;
+    return (words + block - 1) / block * block;
+}
+
+static void setBit(std::vector<uint64_t>& bits, size_t index) {
+    size_t word = index / 64;
+    if (word >= bits.size()) bits.resize(roundToBlocks(word + 1), 0);
+    bits[word] |= uint64_t(1) << (index % 64);
+}
+
+static void clearBit(std::vector<uint64_t>& bits, size_t index) {
+    size_t word = index / 64;
+    if (word < bits.size()) bits[word] &= ~(uint64_t(1) << (index % 64));
+}
+
+static bool testBit(const std::vector<uint64_t>& bits, size_t index) {
+    size_t word = index / 64;
+    return word < bits.size() && (bits[word] >> (index % 64)) & 1;
+}
+
+// CapabilityRegistry Implementation
+void CapabilityRegistry::setCapabilities(AtomHandle agent, const std::vector<std::string>& capabilities) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = member_of_.find(agent);
+    if (it != member_of_.end()) {
+        removeLocked(it->second);
+    }
+    if (capabilities.empty()) return;
+
+    uint32_t member;
+    if (!free_members_.empty()) {
+        member = free_members_.back();
+        free_members_.pop_back();
+        members_[member] = agent;
+    } else {
+        member = static_cast<uint32_t>(members_.size());
+        members_.push_back(agent);
+        capabilities_of_.emplace_back();
+
+        // Widen every member bitset together so they stay the same length
+        size_t words = roundToBlocks(members_.size() / 64 + 1);
+        if (words != member_words_) {
+            member_words_ = words;
+            for (auto& bits : agents_by_capability_) {
+                bits.resize(member_words_, 0);
+            }
+        }
+    }
+    member_of_[agent] = member;
+
+    for (const auto& capability : capabilities) {
+        CapabilityId id = internLocked(capability);
+        setBit(capabilities_of_[member], id);
+        setBit(agents_by_capability_[id], member);
+    }
+}
+
+void CapabilityRegistry::removeAgent(AtomHandle agent) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = member_of_.find(agent);
+    if (it != member_of_.end()) {
+        removeLocked(it->second);
+    }
+}
+
+void CapabilityRegistry::removeLocked(uint32_t member) {
+    Bitset& caps = capabilities_of_[member];
+    for (size_t word = 0; word < caps.size(); ++word) {
+        for (uint64_t bits = caps[word]; bits; bits &= bits - 1) {
+            clearBit(agents_by_capability_[word * 64 + __builtin_ctzll(bits)], member);
+        }
+    }
+    caps.clear();
+
+    member_of_.erase(members_[member]);
+    members_[member] = AtomHandle();
+    free_members_.push_back(member);
+}
+
+void CapabilityRegistry::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // Capability ids stay interned; only the memberships go
+    for (auto& bits : agents_by_capability_) {
+        std::fill(bits.begin(), bits.end(), 0);
+    }
+    capabilities_of_.clear();
+    members_.clear();
+    member_of_.clear();
+    free_members_.clear();
+}
+
+CapabilityId CapabilityRegistry::intern(const std::string& capability) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return internLocked(capability);
+}
+
+CapabilityId CapabilityRegistry::internLocked(const std::string& capability) {
+    auto result = ids_.emplace(capability, static_cast<CapabilityId>(names_.size()));
+    if (result.second) {
+        names_.push_back(capability);
+        agents_by_capability_.emplace_back(member_words_, 0);
+    }
+    return result.first->second;
+}
+
+bool CapabilityRegistry::find(const std::string& capability, CapabilityId& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = ids_.find(capability);
+    if (it == ids_.end()) return false;
+
+    id = it->second;
+    return true;
+}
+
+bool CapabilityRegistry::hasCapability(AtomHandle agent, const std::string& capability) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto member = member_of_.find(agent);
+    auto id = ids_.find(capability);
+    return member != member_of_.end() && id != ids_.end() &&
+           testBit(capabilities_of_[member->second], id->second);
+}
+
+std::vector<std::string> CapabilityRegistry::getCapabilities(AtomHandle agent) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    std::vector<std::string> result;
+    auto it = member_of_.find(agent);
+    if (it == member_of_.end()) return result;
+
+    const Bitset& caps = capabilities_of_[it->second];
+    for (size_t word = 0; word < caps.size(); ++word) {
+        for (uint64_t bits = caps[word]; bits; bits &= bits - 1) {
+            result.push_back(names_[word * 64 + __builtin_ctzll(bits)]);
+        }
+    }
+    return result;
+}
+
+std::vector<AtomHandle> CapabilityRegistry::agentsWithAll(const std::vector<std::string>& capabilities) const {
+    std::vector<CapabilityId> ids;
+    ids.reserve(capabilities.size());
+    for (const auto& capability : capabilities) {
+        CapabilityId id;
+        if (!find(capability, id)) return {};
+        ids.push_back(id);
+    }
+    return agentsWithAll(ids);
+}
+
+std::vector<AtomHandle> CapabilityRegistry::agentsWithAll(const std::vector<CapabilityId>& capabilities) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    Bitset bits;
+    if (!combine(capabilities, true, bits)) return {};
+    return membersIn(bits);
+}
+
+size_t CapabilityRegistry::countWithAll(const std::vector<CapabilityId>& capabilities) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    Bitset bits;
+    if (!combine(capabilities, true, bits)) return 0;
+
+    size_t count = 0;
+    for (uint64_t word : bits) {
+        count += __builtin_popcountll(word);
+    }
+    return count;
+}
+
+std::vector<AtomHandle> CapabilityRegistry::agentsWithAny(const std::vector<CapabilityId>& capabilities) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    Bitset bits;
+    if (!combine(capabilities, false, bits)) return {};
+    return membersIn(bits);
+}
+
+bool CapabilityRegistry::combine(const std::vector<CapabilityId>& capabilities, bool all, Bitset& result) const {
+    if (capabilities.empty()) return false;
+    for (CapabilityId id : capabilities) {
+        if (id >= agents_by_capability_.size()) return false;
+    }
+
+    result = agents_by_capability_[capabilities[0]];
+    uint64_t* out = result.data();
+
+    // Whole blocks only: the fixed inner trip count lets the loop vectorize
+    for (size_t c = 1; c < capabilities.size(); ++c) {
+        const uint64_t* in = agents_by_capability_[capabilities[c]].data();
+        for (size_t block = 0; block < member_words_; block += kBlockWords) {
+            if (all) {
+                for (size_t k = 0; k < kBlockWords; ++k) out[block + k] &= in[block + k];
+            } else {
+                for (size_t k = 0; k < kBlockWords; ++k) out[block + k] |= in[block + k];
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<AtomHandle> CapabilityRegistry::membersIn(const Bitset& bits) const {
+    std::vector<AtomHandle> result;
+    for (size_t word = 0; word < bits.size(); ++word) {
+        for (uint64_t set = bits[word]; set; set &= set - 1) {
+            result.push_back(members_[word * 64 + __builtin_ctzll(set)]);
+        }
+    }
+    return result;
+}
+
+size_t CapabilityRegistry::getAgentCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return member_of_.size();
+}
+
+size_t CapabilityRegistry::getCapabilityCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
+
+} // namespace SwarmCog
\ No newline at end of file
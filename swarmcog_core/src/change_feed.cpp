@@ -0,0 +1,257 @@
+#include "swarmcog/change_feed.h"
+#include "swarmcog/agentspace.h"
+#include "swarmcog/utils.h"
+
+namespace SwarmCog {
+
+// Subscriber being delivered to on this thread, so its handler can unsubscribe
+static thread_local const void* t_delivering = nullptr;
+
+/**
+ * Bounded multi-producer, single-consumer ring. Each cell carries a sequence
+ * number that tells producers whether it is free for their ticket and the
+ * consumer whether it has been filled, so neither side takes a lock.
+ */
+class ChangeRing {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        ChangeEvent event;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0;  // consumer only
+
+public:
+    explicit ChangeRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        mask_ = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(ChangeEvent&& event) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.event = std::move(event);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full: the consumer has not freed this cell yet
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(ChangeEvent& event) {
+        Cell& cell = cells_[dequeue_pos_ & mask_];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<std::ptrdiff_t>(sequence - (dequeue_pos_ + 1)) < 0) return false;
+
+        event = std::move(cell.event);
+        cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+};
+
+struct ChangeFeed::Subscriber {
+    SubscriptionId id;
+    ChangeFilter filter;
+    ChangeHandler handler;
+    size_t max_batch;
+    ChangeRing ring;
+    std::atomic<uint64_t> pending_dropped{0};
+    std::atomic<uint64_t> total_dropped{0};
+    std::atomic<bool> active{true};
+    std::mutex consumer_mutex;  // one delivery at a time
+
+    Subscriber(SubscriptionId id, const ChangeFilter& filter, ChangeHandler handler, const SubscriptionConfig& config)
+        : id(id), filter(filter), handler(std::move(handler)),
+          max_batch(std::max<size_t>(config.max_batch, 1)), ring(config.capacity) {}
+};
+
+// ChangeFilter Implementation
+bool ChangeFilter::matches(ChangeKind kind, AtomType type, const std::string& atom_name) const {
+    if (!kinds.empty() && std::find(kinds.begin(), kinds.end(), kind) == kinds.end()) return false;
+    if (kind == ChangeKind::CLEARED) return true;
+    if (!types.empty() && std::find(types.begin(), types.end(), type) == types.end()) return false;
+    return name.empty() || name == atom_name;
+}
+
+// ChangeFeed Implementation
+ChangeFeed::ChangeFeed(AgentSpace& space) : space_(space) {}
+
+ChangeFeed::~ChangeFeed() {
+    stop();
+}
+
+SubscriptionId ChangeFeed::subscribe(const ChangeFilter& filter, ChangeHandler handler,
+                                     const SubscriptionConfig& config) {
+    SubscriptionId id;
+    {
+        std::unique_lock<std::shared_mutex> lock(subscribers_mutex_);
+        id = next_id_++;
+        subscribers_.push_back(std::make_shared<Subscriber>(id, filter, std::move(handler), config));
+        active_.store(subscribers_.size(), std::memory_order_release);
+    }
+
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    if (!dispatcher_.joinable() && !stopping_) {
+        dispatcher_ = std::thread(&ChangeFeed::dispatchLoop, this);
+    }
+    return id;
+}
+
+bool ChangeFeed::unsubscribe(SubscriptionId id) {
+    std::shared_ptr<Subscriber> subscriber;
+    {
+        std::unique_lock<std::shared_mutex> lock(subscribers_mutex_);
+        auto it = std::find_if(subscribers_.begin(), subscribers_.end(),
+                               [id](const auto& entry) { return entry->id == id; });
+        if (it == subscribers_.end()) return false;
+
+        subscriber = *it;
+        subscribers_.erase(it);
+        active_.store(subscribers_.size(), std::memory_order_release);
+    }
+
+    subscriber->active.store(false, std::memory_order_release);
+    if (t_delivering != subscriber.get()) {
+        // Wait out a delivery in progress on another thread
+        std::lock_guard<std::mutex> lock(subscriber->consumer_mutex);
+    }
+    return true;
+}
+
+void ChangeFeed::flush() {
+    for (const auto& subscriber : copySubscribers()) {
+        deliver(*subscriber);
+    }
+}
+
+void ChangeFeed::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_one();
+    if (dispatcher_.joinable()) {
+        dispatcher_.join();
+    }
+}
+
+void ChangeFeed::publish(ChangeKind kind, const Atom& source, const AtomPtr& atom, MetadataKeyId key) {
+    if (active_.load(std::memory_order_acquire) == 0) return;
+
+    ChangeEvent event;
+    event.kind = kind;
+    event.type = source.getType();
+    event.handle = source.getHandle();
+    event.key = key;
+    event.atom = atom;
+    push(std::move(event), source.getName());
+}
+
+void ChangeFeed::publishClear() {
+    if (active_.load(std::memory_order_acquire) == 0) return;
+
+    ChangeEvent event;
+    event.kind = ChangeKind::CLEARED;
+    push(std::move(event), "");
+}
+
+void ChangeFeed::push(ChangeEvent event, const std::string& name) {
+    bool queued = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(subscribers_mutex_);
+        for (const auto& subscriber : subscribers_) {
+            if (!subscriber->filter.matches(event.kind, event.type, name)) continue;
+
+            if (subscriber->ring.tryPush(ChangeEvent(event))) {
+                queued = true;
+            } else {
+                subscriber->pending_dropped.fetch_add(1, std::memory_order_relaxed);
+                subscriber->total_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only the first event since the dispatcher last woke pays for a notify
+    if (queued && !wake_pending_.load(std::memory_order_relaxed) &&
+        !wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        wake_cv_.notify_one();
+    }
+}
+
+void ChangeFeed::dispatchLoop() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+
+    while (!stopping_) {
+        // A notify racing with the wait is caught by the timeout
+        wake_cv_.wait_for(lock, kMaxLatency, [this] {
+            return stopping_ || wake_pending_.load(std::memory_order_acquire);
+        });
+        if (stopping_) break;
+        wake_pending_.store(false, std::memory_order_release);
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void ChangeFeed::deliver(Subscriber& subscriber) {
+    std::lock_guard<std::mutex> lock(subscriber.consumer_mutex);
+    t_delivering = &subscriber;
+
+    while (subscriber.active.load(std::memory_order_acquire)) {
+        ChangeBatch batch;
+        ChangeEvent event;
+        while (batch.events.size() < subscriber.max_batch && subscriber.ring.tryPop(event)) {
+            if (!event.atom && event.kind != ChangeKind::CLEARED) {
+                event.atom = space_.getAtom(event.handle);
+            }
+            batch.events.push_back(std::move(event));
+        }
+        batch.dropped = subscriber.pending_dropped.exchange(0, std::memory_order_acq_rel);
+
+        if (batch.events.empty() && batch.dropped == 0) break;
+        subscriber.handler(batch);
+    }
+
+    t_delivering = nullptr;
+}
+
+std::vector<std::shared_ptr<ChangeFeed::Subscriber>> ChangeFeed::copySubscribers() const {
+    std::shared_lock<std::shared_mutex> lock(subscribers_mutex_);
+    return subscribers_;
+}
+
+size_t ChangeFeed::getSubscriberCount() const {
+    std::shared_lock<std::shared_mutex> lock(subscribers_mutex_);
+    return subscribers_.size();
+}
+
+uint64_t ChangeFeed::getDroppedCount(SubscriptionId id) const {
+    std::shared_lock<std::shared_mutex> lock(subscribers_mutex_);
+    for (const auto& subscriber : subscribers_) {
+        if (subscriber->id == id) return subscriber->total_dropped.load(std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -147,8 +147,8 @@ void CognitiveAgent::establishTrust(const AgentId& target_agent, double trust_le
     if (Utils::ValidationUtils::isValidTrustLevel(trust_level)) {
         trust_relationships_[target_agent] = TrustRelationship(target_agent, trust_level);
         
-        // Add trust link to AgentSpace
-        agentspace_->addTrustRelationship(id_, target_agent, trust_level);
+        // Add trust link to AgentSpace; peers are known by their agent node ids
+        agentspace_->addTrustRelationship(agent_node_ ? agent_node_->getId() : id_, target_agent, trust_level);
         
         Utils::Logger::info("Established trust with " + target_agent + " at level " + 
                            std::to_string(trust_level));
@@ -166,41 +166,31 @@ std::vector<AgentId> CognitiveAgent::findCollaborators(const std::string& capabi
                                                       double min_trust) const {
     std::vector<AgentId> collaborators;
     
-    // Get agents from AgentSpace
-    auto agent_atoms = agentspace_->getAtomsByType(AtomType::AGENT_NODE);
-    
-    for (const auto& atom : agent_atoms) {
-        auto node = std::dynamic_pointer_cast<Node>(atom);
-        if (!node || node->getId() == id_) continue;
-        
-        // Check if agent has required capability
-        std::string caps = node->getMetadata("capabilities");
-        auto cap_list = Utils::StringUtils::split(caps, ',');
+    // The capability registry yields the capable agent nodes directly
+    AtomHandle own_node = agent_node_ ? agent_node_->getHandle() : AtomHandle();
+    for (AtomHandle handle : agentspace_->getCapabilityRegistry().agentsWithAll({capability_needed})) {
+        if (handle == own_node) continue;
         
-        bool has_capability = false;
-        for (const auto& cap : cap_list) {
-            if (Utils::StringUtils::trim(cap) == capability_needed) {
-                has_capability = true;
-                break;
-            }
-        }
-        
-        if (has_capability) {
-            // Check trust level
-            double trust = getTrustLevel(node->getId());
-            if (trust >= min_trust) {
-                collaborators.push_back(node->getId());
-            }
+        if (AtomPtr node = agentspace_->getAtom(handle)) {
+            collaborators.push_back(node->getId());
         }
     }
     
+    // Trust is checked outside the walk: establishTrust holds trust_mutex_
+    // while writing to the AgentSpace, so the reverse order could deadlock
+    collaborators.erase(
+        std::remove_if(collaborators.begin(), collaborators.end(),
+                       [&](const AgentId& agent) { return getTrustLevel(agent) < min_trust; }),
+        collaborators.end()
+    );
+    
     return collaborators;
 }
 
 void CognitiveAgent::shareKnowledge(const std::string& knowledge_type, const std::string& content, 
                                    const AgentId& target_agent) {
     // Add knowledge to AgentSpace
-    auto memory_node = agentspace_->addMemoryNode(content, knowledge_type);
+    auto memory_node = agentspace_->addMemoryNode(content, knowledge_type, id_);
     
     if (!target_agent.empty()) {
         // Create knowledge link to specific agent
@@ -292,8 +282,8 @@ void CognitiveAgent::updateAgentSpaceRepresentation() {
             cap_names.push_back(pair.first);
         }
         
-        agent_node_->setMetadata("capabilities", Utils::StringUtils::join(cap_names, ","));
-        agent_node_->setMetadata("last_updated", Utils::TimeUtils::timestampToString(Utils::TimeUtils::now()));
+        agentspace_->setAgentCapabilities(agent_node_->getHandle(), cap_names);
+        agent_node_->setMetadata(MetaKey::LAST_UPDATED, Utils::TimeUtils::now());
     }
 }
 
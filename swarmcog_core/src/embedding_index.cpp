@@ -0,0 +1,480 @@
+#include "swarmcog/embedding_index.h"
+#include "swarmcog/utils.h"
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <queue>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace SwarmCog {
+
+// Highest layer a node is drawn onto; reached with probability M^-31
+static constexpr size_t kMaxLevel = 31;
+
+// VectorKernels Implementation
+float VectorKernels::dot(const float* a, const float* b, size_t length) {
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (size_t i = 0; i < length; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+    }
+    __m256 sum = _mm256_add_ps(sum0, sum1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+#elif defined(__SSE2__)
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    __m128 sum3 = _mm_setzero_ps();
+    for (size_t i = 0; i < length; i += 16) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+    __m128 sum = _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    float32x4_t sum2 = vdupq_n_f32(0.0f);
+    float32x4_t sum3 = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < length; i += 16) {
+        sum0 = vfmaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vfmaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        sum2 = vfmaq_f32(sum2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        sum3 = vfmaq_f32(sum3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    return vaddvq_f32(vaddq_f32(vaddq_f32(sum0, sum1), vaddq_f32(sum2, sum3)));
+#else
+    float sum[4] = {};
+    for (size_t i = 0; i < length; i += 4) {
+        sum[0] += a[i] * b[i];
+        sum[1] += a[i + 1] * b[i + 1];
+        sum[2] += a[i + 2] * b[i + 2];
+        sum[3] += a[i + 3] * b[i + 3];
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#endif
+}
+
+const char* VectorKernels::getName() {
+#if defined(__AVX2__) && defined(__FMA__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// EmbeddingArena Implementation
+EmbeddingArena::EmbeddingArena(size_t dimensions) {
+    reset(dimensions);
+}
+
+EmbeddingArena::~EmbeddingArena() {
+    reset(0);
+}
+
+void EmbeddingArena::reset(size_t dimensions) {
+    for (float* block : blocks_) {
+        ::operator delete(block, std::align_val_t(kAlignment));
+    }
+    blocks_.clear();
+    free_rows_.clear();
+    next_row_ = 0;
+
+    dimensions_ = dimensions;
+    stride_ = (dimensions + kRowFloats - 1) / kRowFloats * kRowFloats;
+}
+
+uint32_t EmbeddingArena::allocate() {
+    uint32_t id;
+    if (!free_rows_.empty()) {
+        id = free_rows_.back();
+        free_rows_.pop_back();
+    } else {
+        if (next_row_ == blocks_.size() * kRowsPerBlock) {
+            void* block = ::operator new(kRowsPerBlock * stride_ * sizeof(float), std::align_val_t(kAlignment));
+            blocks_.push_back(static_cast<float*>(block));
+        }
+        id = next_row_++;
+    }
+
+    std::memset(row(id), 0, stride_ * sizeof(float));
+    return id;
+}
+
+void EmbeddingArena::release(uint32_t row) {
+    free_rows_.push_back(row);
+}
+
+/**
+ * VisitedMarks - Per-thread visited set for layer searches, reset in O(1)
+ * by moving to a new epoch instead of clearing the marks
+ */
+struct VisitedMarks {
+    std::vector<uint32_t> marks;
+    uint32_t epoch = 0;
+
+    // True the first time a node is marked in the current epoch
+    bool mark(uint32_t node) {
+        if (marks[node] == epoch) return false;
+        marks[node] = epoch;
+        return true;
+    }
+};
+
+static VisitedMarks& freshVisitedMarks(size_t node_count) {
+    thread_local VisitedMarks visited;
+    if (visited.marks.size() < node_count) {
+        visited.marks.resize(node_count, 0);
+    }
+    if (++visited.epoch == 0) {
+        std::fill(visited.marks.begin(), visited.marks.end(), 0);
+        visited.epoch = 1;
+    }
+    return visited;
+}
+
+// EmbeddingIndex Implementation
+EmbeddingIndex::EmbeddingIndex(const EmbeddingConfig& config)
+    : config_(config), dimensions_(config.dimensions),
+      level_scale_(1.0 / std::log(static_cast<double>(std::max<size_t>(config.max_neighbors, 2)))),
+      arena_(config.dimensions), rng_(config.seed) {
+    config_.max_neighbors = std::max<size_t>(config_.max_neighbors, 2);
+    config_.ef_construction = std::max(config_.ef_construction, config_.max_neighbors);
+}
+
+bool EmbeddingIndex::insert(AtomHandle handle, const std::vector<float>& embedding) {
+    if (!handle.isValid() || embedding.empty()) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (dimensions_ == 0) {
+        dimensions_ = embedding.size();
+        arena_.reset(dimensions_);
+    }
+    if (embedding.size() != dimensions_) {
+        Utils::Logger::error("Embedding has " + std::to_string(embedding.size()) + " dimensions, index expects " +
+                             std::to_string(dimensions_));
+        return false;
+    }
+
+    uint32_t row = arena_.allocate();
+    if (!normalize(embedding, arena_.row(row))) {
+        arena_.release(row);
+        Utils::Logger::error("Cannot index a zero or non-finite embedding");
+        return false;
+    }
+
+    // A replaced vector becomes a tombstone like a removed one
+    eraseLocked(handle);
+    addNode(handle, row);
+
+    if (deleted_count_ > by_handle_.size()) {
+        compact();
+    }
+    return true;
+}
+
+bool EmbeddingIndex::remove(AtomHandle handle) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (!by_handle_.count(handle)) return false;
+    eraseLocked(handle);
+
+    if (deleted_count_ > by_handle_.size()) {
+        compact();
+    }
+    return true;
+}
+
+bool EmbeddingIndex::contains(AtomHandle handle) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return by_handle_.count(handle) > 0;
+}
+
+std::vector<float> EmbeddingIndex::get(AtomHandle handle) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = by_handle_.find(handle);
+    if (it == by_handle_.end()) return {};
+
+    const float* row = arena_.row(nodes_[it->second].row);
+    return std::vector<float>(row, row + dimensions_);
+}
+
+std::vector<EmbeddingIndex::Match> EmbeddingIndex::search(const std::vector<float>& query, size_t k,
+                                                          size_t ef) const {
+    std::vector<Match> matches;
+    if (k == 0) return matches;
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (by_handle_.empty()) return matches;
+    if (query.size() != dimensions_) {
+        Utils::Logger::warning("Embedding query has " + std::to_string(query.size()) + " dimensions, index has " +
+                               std::to_string(dimensions_));
+        return matches;
+    }
+
+    std::vector<float> normalized(arena_.getStride());
+    if (!normalize(query, normalized.data())) return matches;
+
+    size_t top_layer = nodes_[entry_point_].links.size() - 1;
+    uint32_t entry = greedyDescend(normalized.data(), entry_point_, top_layer, 1);
+    auto found = searchLayer(normalized.data(), entry, std::max(k, ef ? ef : config_.ef_search), 0, true);
+
+    matches.reserve(std::min(k, found.size()));
+    for (size_t i = 0; i < found.size() && i < k; ++i) {
+        matches.emplace_back(found[i].first, nodes_[found[i].second].handle);
+    }
+    return matches;
+}
+
+std::vector<EmbeddingIndex::Match> EmbeddingIndex::searchExact(const std::vector<float>& query, size_t k) const {
+    std::vector<Match> matches;
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (k == 0 || by_handle_.empty() || query.size() != dimensions_) return matches;
+
+    std::vector<float> normalized(arena_.getStride());
+    if (!normalize(query, normalized.data())) return matches;
+
+    matches.reserve(by_handle_.size());
+    for (uint32_t node = 0; node < nodes_.size(); ++node) {
+        if (!nodes_[node].deleted) {
+            matches.emplace_back(similarity(normalized.data(), node), nodes_[node].handle);
+        }
+    }
+
+    size_t limit = std::min(k, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(),
+                      [](const Match& a, const Match& b) { return a.first > b.first; });
+    matches.resize(limit);
+    return matches;
+}
+
+size_t EmbeddingIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return by_handle_.size();
+}
+
+size_t EmbeddingIndex::getDimensions() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return dimensions_;
+}
+
+size_t EmbeddingIndex::getReservedBytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return arena_.getReservedBytes();
+}
+
+void EmbeddingIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // The dimension stays fixed once set
+    arena_.reset(dimensions_);
+    nodes_.clear();
+    by_handle_.clear();
+    entry_point_ = kNoNode;
+    deleted_count_ = 0;
+}
+
+bool EmbeddingIndex::normalize(const std::vector<float>& embedding, float* out) const {
+    double norm = 0.0;
+    for (float value : embedding) {
+        norm += static_cast<double>(value) * value;
+    }
+    if (!(norm > 0.0) || !std::isfinite(norm)) return false;
+
+    float scale = static_cast<float>(1.0 / std::sqrt(norm));
+    for (size_t i = 0; i < embedding.size(); ++i) {
+        out[i] = embedding[i] * scale;
+    }
+    std::fill(out + embedding.size(), out + arena_.getStride(), 0.0f);
+    return true;
+}
+
+uint32_t EmbeddingIndex::greedyDescend(const float* query, uint32_t entry, size_t from_layer, size_t to_layer) const {
+    float best = similarity(query, entry);
+    for (size_t layer = from_layer + 1; layer-- > to_layer;) {
+        bool improved = true;
+        while (improved) {
+            improved = false;
+            for (uint32_t neighbor : nodes_[entry].links[layer]) {
+                float s = similarity(query, neighbor);
+                if (s > best) {
+                    best = s;
+                    entry = neighbor;
+                    improved = true;
+                }
+            }
+        }
+    }
+    return entry;
+}
+
+std::vector<EmbeddingIndex::Candidate> EmbeddingIndex::searchLayer(const float* query, uint32_t entry, size_t ef,
+                                                                   size_t layer, bool live_only) const {
+    VisitedMarks& visited = freshVisitedMarks(nodes_.size());
+
+    // Frontier pops the most similar candidate; results keep the least
+    // similar of the best ef on top, to be displaced
+    std::priority_queue<Candidate> frontier;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> results;
+
+    float s = similarity(query, entry);
+    visited.mark(entry);
+    frontier.emplace(s, entry);
+    if (!live_only || !nodes_[entry].deleted) {
+        results.emplace(s, entry);
+    }
+
+    while (!frontier.empty()) {
+        Candidate current = frontier.top();
+        if (results.size() >= ef && current.first < results.top().first) break;
+        frontier.pop();
+
+        for (uint32_t neighbor : nodes_[current.second].links[layer]) {
+            if (!visited.mark(neighbor)) continue;
+
+            float sim = similarity(query, neighbor);
+            if (results.size() < ef || sim > results.top().first) {
+                frontier.emplace(sim, neighbor);
+                if (!live_only || !nodes_[neighbor].deleted) {
+                    results.emplace(sim, neighbor);
+                    if (results.size() > ef) results.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<Candidate> found(results.size());
+    for (size_t i = found.size(); i-- > 0;) {
+        found[i] = results.top();
+        results.pop();
+    }
+    return found;
+}
+
+std::vector<uint32_t> EmbeddingIndex::selectNeighbors(const std::vector<Candidate>& candidates, size_t limit) const {
+    std::vector<uint32_t> kept;
+    kept.reserve(limit);
+
+    for (const auto& candidate : candidates) {
+        if (kept.size() >= limit) break;
+
+        const float* row = arena_.row(nodes_[candidate.second].row);
+        bool diverse = std::none_of(kept.begin(), kept.end(), [&](uint32_t other) {
+            return similarity(row, other) > candidate.first;
+        });
+        if (diverse) kept.push_back(candidate.second);
+    }
+
+    return kept;
+}
+
+void EmbeddingIndex::addNode(AtomHandle handle, uint32_t row) {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    size_t level = std::min(kMaxLevel, static_cast<size_t>(-std::log(1.0 - uniform(rng_)) * level_scale_));
+
+    uint32_t node = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[node].handle = handle;
+    nodes_[node].row = row;
+    nodes_[node].links.resize(level + 1);
+    by_handle_[handle] = node;
+
+    if (entry_point_ == kNoNode) {
+        entry_point_ = node;
+        return;
+    }
+
+    const float* query = arena_.row(row);
+    size_t top_layer = nodes_[entry_point_].links.size() - 1;
+    uint32_t entry = greedyDescend(query, entry_point_, top_layer, level + 1);
+
+    for (size_t layer = std::min(level, top_layer) + 1; layer-- > 0;) {
+        auto candidates = searchLayer(query, entry, config_.ef_construction, layer, false);
+        nodes_[node].links[layer] = selectNeighbors(candidates, config_.max_neighbors);
+
+        // Link back, pruning neighbours that overflow with the same heuristic
+        for (uint32_t neighbor : nodes_[node].links[layer]) {
+            auto& links = nodes_[neighbor].links[layer];
+            links.push_back(node);
+            if (links.size() <= maxLinks(layer)) continue;
+
+            const float* base = arena_.row(nodes_[neighbor].row);
+            std::vector<Candidate> pool;
+            pool.reserve(links.size());
+            for (uint32_t other : links) {
+                pool.emplace_back(similarity(base, other), other);
+            }
+            std::sort(pool.begin(), pool.end(), std::greater<Candidate>());
+            links = selectNeighbors(pool, maxLinks(layer));
+        }
+
+        if (!candidates.empty()) {
+            entry = candidates.front().second;
+        }
+    }
+
+    if (level > top_layer) {
+        entry_point_ = node;
+    }
+}
+
+void EmbeddingIndex::eraseLocked(AtomHandle handle) {
+    auto it = by_handle_.find(handle);
+    if (it == by_handle_.end()) return;
+
+    nodes_[it->second].deleted = true;
+    by_handle_.erase(it);
+    ++deleted_count_;
+}
+
+void EmbeddingIndex::compact() {
+    // Copy the live vectors out, since resetting the arena frees their rows
+    std::vector<std::pair<AtomHandle, std::vector<float>>> live;
+    live.reserve(by_handle_.size());
+    for (const auto& node : nodes_) {
+        if (node.deleted) continue;
+        const float* row = arena_.row(node.row);
+        live.emplace_back(node.handle, std::vector<float>(row, row + arena_.getStride()));
+    }
+
+    size_t dropped = deleted_count_;
+    arena_.reset(dimensions_);
+    nodes_.clear();
+    by_handle_.clear();
+    entry_point_ = kNoNode;
+    deleted_count_ = 0;
+
+    for (const auto& entry : live) {
+        uint32_t row = arena_.allocate();
+        std::memcpy(arena_.row(row), entry.second.data(), entry.second.size() * sizeof(float));
+        addNode(entry.first, row);
+    }
+
+    Utils::Logger::debug("Compacted embedding index: dropped " + std::to_string(dropped) + " tombstones, kept " +
+                         std::to_string(live.size()));
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "swarmcog/forgetting.h"
+#include "swarmcog/utils.h"
+
+namespace SwarmCog {
+
+// Forgetter Implementation
+Forgetter::Forgetter(std::shared_ptr<AgentSpace> space, const ForgettingConfig& config)
+    : space_(std::move(space)), config_(config), types_(config.types.begin(), config.types.end()) {
+    if (config_.batch_size == 0) {
+        config_.batch_size = 1;
+    }
+}
+
+Forgetter::~Forgetter() {
+    stop();
+}
+
+void Forgetter::start() {
+    if (worker_.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread(&Forgetter::run, this);
+
+    Utils::Logger::info("Started forgetting for AgentSpace: " + space_->getName());
+}
+
+void Forgetter::stop() {
+    if (!worker_.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stopping_ = true;
+    }
+    worker_cv_.notify_one();
+    worker_.join();
+}
+
+void Forgetter::run() {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+
+    while (!worker_cv_.wait_for(lock, config_.interval, [this] { return stopping_; })) {
+        lock.unlock();
+        step();
+        lock.lock();
+    }
+}
+
+size_t Forgetter::step() {
+    std::lock_guard<std::mutex> lock(step_mutex_);
+
+    struct Duplicate {
+        AtomPtr atom;
+        AtomHandle survivor;
+    };
+    std::vector<AtomHandle> expired;
+    std::vector<Duplicate> duplicates;
+
+    // Only classify under the shard locks; removals happen after the visit
+    size_t next = space_->forEachInSlotRange(cursor_, config_.batch_size, [&](const AtomPtr& atom) {
+        if (types_.count(atom->getType()) == 0) return;
+
+        AtomHandle handle = atom->getHandle();
+        AttentionValue av = atom->getAttentionValue();
+        if (av.lti < config_.min_lti && av.vlti < config_.min_vlti) {
+            expired.push_back(handle);
+            return;
+        }
+
+        std::string owner = atom->getMetadata(MetaKey::OWNER);
+        auto node = config_.merge_duplicates ? std::dynamic_pointer_cast<Node>(atom) : nullptr;
+        if (node && !node->getValue().empty()) {
+            std::string key = std::to_string(static_cast<int>(atom->getType())) + '\x1f' + owner + '\x1f' +
+                              node->getValue();
+            auto result = survivors_.emplace(std::move(key), handle);
+            if (!result.second && result.first->second != handle) {
+                duplicates.push_back({atom, result.first->second});
+                return;
+            }
+        }
+
+        double importance = av.lti + av.vlti;
+        if (config_.type_quotas.count(atom->getType())) {
+            by_type_[atom->getType()].emplace_back(importance, handle);
+        }
+        if (config_.agent_quota && !owner.empty()) {
+            by_owner_[owner].emplace_back(importance, handle);
+        }
+    });
+
+    size_t removed = 0;
+    for (AtomHandle handle : expired) {
+        if (forget(handle)) {
+            ++stats_.forgotten;
+            ++removed;
+        }
+    }
+
+    for (const auto& duplicate : duplicates) {
+        AtomPtr survivor = space_->getAtom(duplicate.survivor);
+        if (!survivor || !fold(duplicate.atom, survivor)) continue;
+
+        survivor->reviseTruthValue(duplicate.atom->getTruthValue());
+        AttentionValue kept = survivor->getAttentionValue();
+        AttentionValue folded = duplicate.atom->getAttentionValue();
+        survivor->setAttentionValue(AttentionValue(std::max(kept.sti, folded.sti),
+                                                   std::max(kept.lti, folded.lti),
+                                                   std::max(kept.vlti, folded.vlti)));
+        ++stats_.merged;
+        ++removed;
+    }
+
+    cursor_ = next;
+    if (next == 0) {
+        for (auto& entry : by_type_) {
+            removed += enforceQuota(entry.second, config_.type_quotas.at(entry.first));
+        }
+        for (auto& entry : by_owner_) {
+            removed += enforceQuota(entry.second, config_.agent_quota);
+        }
+
+        survivors_.clear();
+        by_type_.clear();
+        by_owner_.clear();
+        ++stats_.passes;
+
+        if (Utils::Logger::isEnabled(Utils::LogLevel::DEBUG)) {
+            Utils::Logger::debug("Forgetting pass over " + space_->getName() + ": " +
+                                 std::to_string(stats_.forgotten) + " forgotten, " +
+                                 std::to_string(stats_.merged) + " merged so far");
+        }
+    }
+
+    return removed;
+}
+
+size_t Forgetter::runPass() {
+    size_t removed = 0;
+    size_t passes = getStats().passes;
+    while (getStats().passes == passes) {
+        removed += step();
+    }
+    return removed;
+}
+
+size_t Forgetter::enforceQuota(std::vector<std::pair<double, AtomHandle>>& atoms, size_t quota) {
+    // Atoms forgotten for another quota since the pass saw them no longer count
+    atoms.erase(std::remove_if(atoms.begin(), atoms.end(),
+                               [this](const auto& entry) { return !space_->getAtom(entry.second); }),
+                atoms.end());
+    if (atoms.size() <= quota) return 0;
+
+    size_t excess = atoms.size() - quota;
+    std::nth_element(atoms.begin(), atoms.begin() + excess, atoms.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    size_t removed = 0;
+    for (size_t i = 0; i < excess; ++i) {
+        if (forget(atoms[i].second)) {
+            ++stats_.forgotten;
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+bool Forgetter::forget(AtomHandle handle) {
+    std::vector<AtomHandle> links;
+    space_->forEachIncoming(handle, [&links](const AtomPtr& link) {
+        links.push_back(link->getHandle());
+    });
+
+    for (AtomHandle link : links) {
+        if (forget(link)) {
+            ++stats_.links_removed;
+        }
+    }
+
+    return space_->removeAtom(handle);
+}
+
+bool Forgetter::fold(const AtomPtr& duplicate, const AtomPtr& survivor) {
+    // Rebuilding a link can rebuild links that point at it, which may name
+    // the duplicate too; repeat until a round changes nothing
+    bool progress = true;
+    while (progress) {
+        std::vector<AtomHandle> links;
+        space_->forEachIncoming(duplicate->getHandle(), [&links](const AtomPtr& link) {
+            links.push_back(link->getHandle());
+        });
+
+        progress = false;
+        for (AtomHandle handle : links) {
+            auto link = std::dynamic_pointer_cast<Link>(space_->getAtom(handle));
+            if (link && repoint(link, duplicate, survivor)) {
+                progress = true;
+            }
+        }
+    }
+
+    // Anything that could not be rebuilt is removed with the duplicate
+    return forget(duplicate->getHandle());
+}
+
+bool Forgetter::repoint(const LinkPtr& link, const AtomPtr& from, const AtomPtr& to) {
+    std::vector<AtomPtr> outgoing = link->getOutgoing();
+    std::replace(outgoing.begin(), outgoing.end(), from, to);
+
+    auto replacement = space_->createLink(link->getType(), outgoing, link->getName());
+    replacement->setTruthValue(link->getTruthValue());
+    replacement->setAttentionValue(link->getAttentionValue());
+    for (auto& entry : link->getMetadataEntries()) {
+        replacement->setMetadata(entry.key, std::move(entry.value));
+    }
+    AtomPtr stored = space_->addAtom(replacement);
+    if (!stored) return false;
+
+    std::vector<AtomHandle> links;
+    space_->forEachIncoming(link->getHandle(), [&links](const AtomPtr& outer) {
+        links.push_back(outer->getHandle());
+    });
+    for (AtomHandle handle : links) {
+        auto outer = std::dynamic_pointer_cast<Link>(space_->getAtom(handle));
+        if (outer) repoint(outer, link, stored);
+    }
+
+    if (!space_->removeAtom(link->getHandle())) return false;
+    ++stats_.links_repointed;
+    return true;
+}
+
+ForgettingStats Forgetter::getStats() const {
+    std::lock_guard<std::mutex> lock(step_mutex_);
+    return stats_;
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,456 @@
+#include "swarmcog/graph_index.h"
+#include "swarmcog/agentspace.h"
+#include "swarmcog/utils.h"
+
+namespace SwarmCog {
+
+// Journals shorter than this are always applied, however small the graph
+static constexpr size_t kMinJournal = 1024;
+
+// Runs body(begin, end, worker) over [0, count) in `workers` contiguous
+// ranges; the calling thread takes the first one
+template<typename Body>
+static void parallelFor(size_t count, size_t workers, Body&& body) {
+    if (workers <= 1) {
+        body(size_t(0), count, size_t(0));
+        return;
+    }
+
+    size_t chunk = (count + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        size_t begin = std::min(count, worker * chunk);
+        size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([&body, begin, end, worker] { body(begin, end, worker); });
+    }
+    body(size_t(0), std::min(count, chunk), size_t(0));
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// AdjacencyGraph Implementation
+bool AdjacencyGraph::contains(AtomHandle handle) const {
+    return handle.isValid() && handle.slot() < generations_.size() &&
+           generations_[handle.slot()] == handle.generation();
+}
+
+AtomHandle AdjacencyGraph::handleOf(uint32_t vertex) const {
+    if (vertex >= generations_.size() || generations_[vertex] == 0) return AtomHandle();
+    return AtomHandle(vertex, generations_[vertex]);
+}
+
+size_t AdjacencyGraph::workerCount(size_t items) const {
+    size_t threshold = std::max<size_t>(config_.parallel_threshold, 1);
+    if (items < 2 * threshold) return 1;
+
+    size_t threads = config_.threads ? config_.threads : std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, items / threshold));
+}
+
+AdjacencyGraph::Traversal AdjacencyGraph::traverse(const std::vector<AtomHandle>& sources, uint32_t max_hops,
+                                                   uint32_t stop_at, bool with_parents) const {
+    size_t vertex_count = generations_.size();
+    Traversal result;
+
+    auto depth = std::make_unique<std::atomic<uint32_t>[]>(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        depth[v].store(kUnreachable, std::memory_order_relaxed);
+    }
+    if (with_parents) {
+        result.parent.assign(vertex_count, kNoVertex);
+    }
+
+    std::vector<uint32_t> frontier;
+    for (AtomHandle source : sources) {
+        if (contains(source) && depth[source.slot()].load(std::memory_order_relaxed) == kUnreachable) {
+            depth[source.slot()].store(0, std::memory_order_relaxed);
+            frontier.push_back(source.slot());
+        }
+    }
+
+    for (uint32_t level = 0; !frontier.empty(); ++level) {
+        result.visited.insert(result.visited.end(), frontier.begin(), frontier.end());
+        if (level >= max_hops) break;
+        if (stop_at != kNoVertex && depth[stop_at].load(std::memory_order_relaxed) != kUnreachable) break;
+
+        size_t workers = workerCount(frontier.size());
+        std::vector<std::vector<uint32_t>> next(workers);
+        parallelFor(frontier.size(), workers, [&](size_t begin, size_t end, size_t worker) {
+            auto& discovered = next[worker];
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t v = frontier[i];
+                for (uint64_t e = offsets_[v]; e < offsets_[v + 1]; ++e) {
+                    uint32_t u = targets_[e];
+                    uint32_t unvisited = kUnreachable;
+                    // The worker whose exchange succeeds owns u's parent entry
+                    if (depth[u].load(std::memory_order_relaxed) == kUnreachable &&
+                        depth[u].compare_exchange_strong(unvisited, level + 1, std::memory_order_relaxed)) {
+                        if (with_parents) result.parent[u] = v;
+                        discovered.push_back(u);
+                    }
+                }
+            }
+        });
+
+        frontier.clear();
+        for (const auto& part : next) {
+            frontier.insert(frontier.end(), part.begin(), part.end());
+        }
+    }
+
+    result.depth.resize(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        result.depth[v] = depth[v].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::vector<uint32_t> AdjacencyGraph::distances(const std::vector<AtomHandle>& sources, uint32_t max_hops) const {
+    return traverse(sources, max_hops, kNoVertex, false).depth;
+}
+
+std::vector<AtomHandle> AdjacencyGraph::neighborhood(AtomHandle source, uint32_t hops) const {
+    std::vector<AtomHandle> result;
+    if (!contains(source)) return result;
+
+    auto traversal = traverse({source}, hops, kNoVertex, false);
+    result.reserve(traversal.visited.size() - 1);
+    for (size_t i = 1; i < traversal.visited.size(); ++i) {
+        result.push_back(handleOf(traversal.visited[i]));
+    }
+    return result;
+}
+
+std::vector<AtomHandle> AdjacencyGraph::shortestPath(AtomHandle from, AtomHandle to) const {
+    std::vector<AtomHandle> path;
+    if (!contains(from) || !contains(to)) return path;
+
+    auto traversal = traverse({from}, kUnreachable, to.slot(), true);
+    if (traversal.depth[to.slot()] == kUnreachable) return path;
+
+    for (uint32_t v = to.slot(); v != from.slot(); v = traversal.parent[v]) {
+        path.push_back(handleOf(v));
+    }
+    path.push_back(from);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::vector<uint32_t> AdjacencyGraph::connectedComponents() const {
+    size_t vertex_count = generations_.size();
+
+    // Concurrent union-find. Roots are only ever linked under smaller ids, so
+    // each component ends up rooted at its smallest vertex.
+    auto parent = std::make_unique<std::atomic<uint32_t>[]>(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        parent[v].store(static_cast<uint32_t>(v), std::memory_order_relaxed);
+    }
+
+    auto find = [&parent](uint32_t v) {
+        while (true) {
+            uint32_t p = parent[v].load(std::memory_order_relaxed);
+            if (p == v) return v;
+            uint32_t grandparent = parent[p].load(std::memory_order_relaxed);
+            if (grandparent != p) {
+                parent[v].compare_exchange_weak(p, grandparent, std::memory_order_relaxed);  // path halving
+            }
+            v = grandparent;
+        }
+    };
+
+    size_t workers = workerCount(vertex_count);
+    parallelFor(vertex_count, workers, [&](size_t begin, size_t end, size_t) {
+        for (size_t v = begin; v < end; ++v) {
+            for (uint64_t e = offsets_[v]; e < offsets_[v + 1]; ++e) {
+                uint32_t a = static_cast<uint32_t>(v);
+                uint32_t b = targets_[e];
+                while (true) {
+                    a = find(a);
+                    b = find(b);
+                    if (a == b) break;
+                    if (a < b) std::swap(a, b);
+                    uint32_t root = a;
+                    if (parent[a].compare_exchange_strong(root, b, std::memory_order_relaxed)) break;
+                }
+            }
+        }
+    });
+
+    std::vector<uint32_t> labels(vertex_count, kNoVertex);
+    parallelFor(vertex_count, workers, [&](size_t begin, size_t end, size_t) {
+        for (size_t v = begin; v < end; ++v) {
+            if (generations_[v]) labels[v] = find(static_cast<uint32_t>(v));
+        }
+    });
+    return labels;
+}
+
+std::vector<double> AdjacencyGraph::sumNeighbors(const std::vector<double>& values, uint32_t begin,
+                                                 uint32_t end) const {
+    end = std::min<uint32_t>(end, static_cast<uint32_t>(generations_.size()));
+    if (begin >= end) return {};
+
+    // Rows are pulled independently, so workers never write the same entry
+    std::vector<double> sums(end - begin, 0.0);
+    parallelFor(sums.size(), workerCount(sums.size()), [&](size_t first, size_t last, size_t) {
+        for (size_t i = first; i < last; ++i) {
+            uint32_t u = begin + static_cast<uint32_t>(i);
+            double sum = 0.0;
+            for (uint64_t e = offsets_[u]; e < offsets_[u + 1]; ++e) {
+                sum += values[targets_[e]];
+            }
+            sums[i] = sum;
+        }
+    });
+    return sums;
+}
+
+// GraphIndex Implementation
+std::shared_ptr<const AdjacencyGraph> GraphIndex::get(const GraphSpec& spec, const AgentSpace& space) {
+    std::vector<AtomType> types = spec.link_types;
+    std::sort(types.begin(), types.end());
+    types.erase(std::unique(types.begin(), types.end()), types.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entryFor(types, spec.directed);
+        if (entry.graph) {
+            if (!entry.journal.empty()) {
+                entry.graph = rebuild(entry);
+                entry.journal.clear();
+            }
+            return entry.graph;
+        }
+    }
+
+    // The caller's link-index lock keeps changes out until the graph is
+    // installed; a concurrent request may have installed an equal one first
+    auto graph = build(types, spec.directed, space);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entryFor(types, spec.directed);
+    if (!entry.graph) {
+        entry.graph = std::move(graph);
+    }
+    return entry.graph;
+}
+
+void GraphIndex::linkAdded(const Link& link) {
+    uint64_t bit = typeBit(link.getType());
+    if (!(watched_types_.load() & bit)) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<AtomHandle> endpoints = endpointsOf(link);
+    for (auto& entry : entries_) {
+        if (entry.type_mask & bit) {
+            record(entry, {Change::LINK_ADDED, link.getHandle(), endpoints});
+        }
+    }
+}
+
+void GraphIndex::linkRemoved(AtomHandle link, AtomType type) {
+    uint64_t bit = typeBit(type);
+    if (!(watched_types_.load() & bit)) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (entry.type_mask & bit) {
+            record(entry, {Change::LINK_REMOVED, link, {}});
+        }
+    }
+}
+
+void GraphIndex::atomRemoved(AtomHandle atom) {
+    if (!watched_types_.load()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        // A journal may hold edges to atoms the graph does not have yet
+        if (entry.graph && (entry.graph->contains(atom) || !entry.journal.empty())) {
+            record(entry, {Change::ATOM_REMOVED, atom, {}});
+        }
+    }
+}
+
+void GraphIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        entry.graph.reset();
+        entry.journal.clear();
+    }
+}
+
+GraphIndex::Entry& GraphIndex::entryFor(const std::vector<AtomType>& types, bool directed) {
+    for (auto& entry : entries_) {
+        if (entry.types == types && entry.directed == directed) return entry;
+    }
+
+    Entry entry;
+    entry.types = types;
+    entry.directed = directed;
+    for (AtomType type : types) {
+        entry.type_mask |= typeBit(type);
+    }
+    watched_types_.fetch_or(entry.type_mask);
+    entries_.push_back(std::move(entry));
+    return entries_.back();
+}
+
+void GraphIndex::record(Entry& entry, Change change) {
+    if (!entry.graph) return;  // built from scratch on the next request anyway
+
+    entry.journal.push_back(std::move(change));
+    if (entry.journal.size() > entry.graph->getEdgeCount() / 2 + kMinJournal) {
+        entry.graph.reset();
+        entry.journal.clear();
+    }
+}
+
+std::vector<AtomHandle> GraphIndex::endpointsOf(const Link& link) {
+    std::vector<AtomHandle> endpoints;
+    endpoints.reserve(link.getArity());
+    for (const auto& target : link.getOutgoing()) {
+        endpoints.push_back(target ? target->getHandle() : AtomHandle());
+    }
+    return endpoints;
+}
+
+void GraphIndex::appendEdges(const std::vector<AtomHandle>& endpoints, AtomHandle link, bool directed,
+                             std::vector<Edge>& edges) {
+    if (endpoints.size() < 2 || !endpoints[0].isValid()) return;
+
+    AtomHandle source = endpoints[0];
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+        AtomHandle target = endpoints[i];
+        if (!target.isValid() || target == source) continue;
+
+        edges.push_back({source, target, link});
+        if (!directed) {
+            edges.push_back({target, source, link});
+        }
+    }
+}
+
+std::shared_ptr<const AdjacencyGraph> GraphIndex::build(const std::vector<AtomType>& types, bool directed,
+                                                        const AgentSpace& space) const {
+    std::vector<Edge> edges;
+    for (AtomType type : types) {
+        space.forEachOfType(type, [&](const AtomPtr& atom) {
+            if (auto link = dynamic_cast<const Link*>(atom.get())) {
+                appendEdges(endpointsOf(*link), link->getHandle(), directed, edges);
+            }
+        });
+    }
+
+    auto graph = assemble(directed, nullptr, {}, {}, edges);
+    if (Utils::Logger::isEnabled(Utils::LogLevel::DEBUG)) {
+        Utils::Logger::debug("Built adjacency graph in " + space.getName() + " with " +
+                             std::to_string(graph->getEdgeCount()) + " edges");
+    }
+    return graph;
+}
+
+std::shared_ptr<const AdjacencyGraph> GraphIndex::rebuild(const Entry& entry) const {
+    std::unordered_set<AtomHandle> removed_atoms;
+    std::unordered_set<AtomHandle> removed_links;
+    std::vector<Edge> added;
+
+    // Handles are never reused, so a removal always follows the additions it cancels
+    for (const auto& change : entry.journal) {
+        switch (change.kind) {
+            case Change::LINK_ADDED:
+                appendEdges(change.endpoints, change.handle, entry.directed, added);
+                break;
+            case Change::LINK_REMOVED:
+                removed_links.insert(change.handle);
+                break;
+            case Change::ATOM_REMOVED:
+                removed_atoms.insert(change.handle);
+                break;
+        }
+    }
+
+    return assemble(entry.directed, entry.graph.get(), removed_atoms, removed_links, added);
+}
+
+std::shared_ptr<const AdjacencyGraph> GraphIndex::assemble(bool directed, const AdjacencyGraph* previous,
+                                                           const std::unordered_set<AtomHandle>& removed_atoms,
+                                                           const std::unordered_set<AtomHandle>& removed_links,
+                                                           const std::vector<Edge>& added) const {
+    auto graph = std::make_shared<AdjacencyGraph>(config_, directed);
+
+    std::vector<const Edge*> fresh;
+    fresh.reserve(added.size());
+    size_t slot_count = previous ? previous->generations_.size() : 0;
+    for (const auto& edge : added) {
+        if (removed_links.count(edge.link) || removed_atoms.count(edge.source) || removed_atoms.count(edge.target)) {
+            continue;
+        }
+        fresh.push_back(&edge);
+        slot_count = std::max<size_t>(slot_count, std::max(edge.source.slot(), edge.target.slot()) + size_t(1));
+    }
+
+    graph->generations_.assign(slot_count, 0);
+    std::vector<uint8_t> dead;  // vertices of `previous` removed since
+    if (previous) {
+        std::copy(previous->generations_.begin(), previous->generations_.end(), graph->generations_.begin());
+        if (!removed_atoms.empty()) {
+            dead.assign(previous->generations_.size(), 0);
+            for (AtomHandle atom : removed_atoms) {
+                if (previous->contains(atom)) {
+                    dead[atom.slot()] = 1;
+                    graph->generations_[atom.slot()] = 0;
+                }
+            }
+        }
+    }
+    for (const Edge* edge : fresh) {
+        graph->generations_[edge->source.slot()] = edge->source.generation();
+        graph->generations_[edge->target.slot()] = edge->target.generation();
+    }
+
+    auto kept = [&](uint32_t v, uint64_t e) {
+        if (!dead.empty() && (dead[v] || dead[previous->targets_[e]])) return false;
+        return removed_links.empty() || !removed_links.count(previous->links_[e]);
+    };
+
+    // Counting sort by source: row sizes, then offsets, then the rows
+    std::vector<uint64_t>& offsets = graph->offsets_;
+    offsets.assign(slot_count + 1, 0);
+    size_t previous_slots = previous ? previous->generations_.size() : 0;
+    for (size_t v = 0; v < previous_slots; ++v) {
+        for (uint64_t e = previous->offsets_[v]; e < previous->offsets_[v + 1]; ++e) {
+            if (kept(static_cast<uint32_t>(v), e)) ++offsets[v + 1];
+        }
+    }
+    for (const Edge* edge : fresh) {
+        ++offsets[edge->source.slot() + 1];
+    }
+    for (size_t v = 0; v < slot_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    graph->targets_.resize(offsets[slot_count]);
+    graph->links_.resize(offsets[slot_count]);
+    std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t v = 0; v < previous_slots; ++v) {
+        for (uint64_t e = previous->offsets_[v]; e < previous->offsets_[v + 1]; ++e) {
+            if (!kept(static_cast<uint32_t>(v), e)) continue;
+            uint64_t position = cursor[v]++;
+            graph->targets_[position] = previous->targets_[e];
+            graph->links_[position] = previous->links_[e];
+        }
+    }
+    for (const Edge* edge : fresh) {
+        uint64_t position = cursor[edge->source.slot()]++;
+        graph->targets_[position] = edge->target.slot();
+        graph->links_[position] = edge->link;
+    }
+
+    return graph;
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "swarmcog/metadata.h"
+#include "swarmcog/utils.h"
+
+namespace SwarmCog {
+
+// MetadataKeys Implementation
+MetadataKeys::MetadataKeys() {
+    // Order must match the MetaKey constants
+    for (const char* key : {"type", "capabilities", "creation_time", "created_time", "last_updated",
+                            "trust_level", "memory_type", "collaboration_type", "relation", "owner"}) {
+        ids_.emplace(key, static_cast<MetadataKeyId>(names_.size()));
+        names_.emplace_back(key);
+    }
+}
+
+MetadataKeys& MetadataKeys::instance() {
+    static MetadataKeys keys;
+    return keys;
+}
+
+MetadataKeyId MetadataKeys::intern(const std::string& key) {
+    MetadataKeys& keys = instance();
+
+    {
+        std::shared_lock<std::shared_mutex> lock(keys.mutex_);
+        auto it = keys.ids_.find(key);
+        if (it != keys.ids_.end()) return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(keys.mutex_);
+    auto result = keys.ids_.emplace(key, static_cast<MetadataKeyId>(keys.names_.size()));
+    if (result.second) {
+        keys.names_.push_back(key);
+    }
+    return result.first->second;
+}
+
+bool MetadataKeys::find(const std::string& key, MetadataKeyId& id) {
+    MetadataKeys& keys = instance();
+    std::shared_lock<std::shared_mutex> lock(keys.mutex_);
+
+    auto it = keys.ids_.find(key);
+    if (it == keys.ids_.end()) return false;
+
+    id = it->second;
+    return true;
+}
+
+const std::string& MetadataKeys::name(MetadataKeyId id) {
+    MetadataKeys& keys = instance();
+    std::shared_lock<std::shared_mutex> lock(keys.mutex_);
+    return keys.names_.at(id);
+}
+
+std::string metadataValueToString(const MetadataValue& value) {
+    if (auto str = std::get_if<std::string>(&value)) return *str;
+    if (auto number = std::get_if<double>(&value)) return std::to_string(*number);
+    if (auto integer = std::get_if<int64_t>(&value)) return std::to_string(*integer);
+    return Utils::TimeUtils::timestampToString(std::get<Timestamp>(value));
+}
+
+// AtomMetadata Implementation
+const MetadataValue* AtomMetadata::find(MetadataKeyId key) const {
+    for (size_t i = 0; i < inline_size_; ++i) {
+        if (inline_[i].key == key) return &inline_[i].value;
+    }
+    for (const auto& entry : overflow_) {
+        if (entry.key == key) return &entry.value;
+    }
+    return nullptr;
+}
+
+void AtomMetadata::set(MetadataKeyId key, MetadataValue value) {
+    for (size_t i = 0; i < inline_size_; ++i) {
+        if (inline_[i].key == key) {
+            inline_[i].value = std::move(value);
+            return;
+        }
+    }
+    for (auto& entry : overflow_) {
+        if (entry.key == key) {
+            entry.value = std::move(value);
+            return;
+        }
+    }
+
+    if (inline_size_ < kInlineCapacity) {
+        inline_[inline_size_].key = key;
+        inline_[inline_size_].value = std::move(value);
+        ++inline_size_;
+    } else {
+        overflow_.push_back({key, std::move(value)});
+    }
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -446,7 +446,8 @@ void CognitiveMicrokernel::gatherEnvironmentalData(const AgentId& agent_id, Cogn
     // Get agent's current focus from AgentSpace
     auto focus = agentspace_->getAttentionalFocus();
     
-    // Add relevant atoms to context
+    // Add relevant atoms to context. Perceiving them does not stimulate
+    // them: the focus comes from the spreader, so that would feed back on itself
     for (const auto& atom_id : focus) {
         context.focus_atoms.push_back(atom_id);
     }
@@ -457,10 +458,21 @@ void CognitiveMicrokernel::gatherEnvironmentalData(const AgentId& agent_id, Cogn
 }
 
 void CognitiveMicrokernel::selectAttentionalFocus(const AgentId& agent_id, CognitiveContext& context) {
+    context.focus_atoms.clear();
+    
+    // Focus on what activation has spread to from the atoms agents touched
+    if (spreader_) {
+        for (AtomHandle handle : spreader_->getActiveAtoms(5)) {
+            auto atom = agentspace_->getAtom(handle);
+            if (!atom) continue;
+            context.focus_atoms.push_back(atom->getId());
+            agentspace_->addToAttentionalFocus(handle);
+        }
+        return;
+    }
+    
     // Get most important atoms for this agent
     auto important_atoms = agentspace_->getMostImportantAtoms(5);
-    
-    context.focus_atoms.clear();
     for (const auto& atom : important_atoms) {
         context.focus_atoms.push_back(atom->getId());
         agentspace_->addToAttentionalFocus(atom->getId());
@@ -515,7 +527,8 @@ void CognitiveMicrokernel::updateKnowledge(const AgentId& agent_id, CognitiveCon
     if (actions_executed > 0) {
         // Add memory of successful actions
         auto memory_content = "Executed " + std::to_string(actions_executed) + " actions successfully";
-        agentspace_->addMemoryNode(memory_content, "procedural");
+        auto memory = agentspace_->addMemoryNode(memory_content, "procedural", agent_id);
+        if (memory && spreader_) spreader_->stimulate(memory->getHandle());
         
         context.variables["learning_outcome"] = "knowledge_updated";
     }
@@ -0,0 +1,500 @@
+#include "swarmcog/mutation_log.h"
+#include "swarmcog/agentspace.h"
+#include "swarmcog/snapshot_file.h"
+#include "swarmcog/utils.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define SWARMCOG_HAVE_FSYNC 1
+#endif
+
+namespace SwarmCog {
+
+// Record framing: u32 payload length, u32 payload checksum, then the payload,
+// which starts with the MutationKind byte and the atom id
+static constexpr size_t kRecordHeaderSize = 8;
+
+enum class ValueTag : uint8_t {
+    STRING = 0,
+    NUMBER = 1,
+    INTEGER = 2,
+    TIMESTAMP = 3,
+};
+
+template<typename T>
+static void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void putString(std::string& out, const std::string& str) {
+    put<uint32_t>(out, static_cast<uint32_t>(str.size()));
+    out.append(str);
+}
+
+static void putValue(std::string& out, const MetadataValue& value) {
+    if (auto str = std::get_if<std::string>(&value)) {
+        put(out, ValueTag::STRING);
+        putString(out, *str);
+    } else if (auto number = std::get_if<double>(&value)) {
+        put(out, ValueTag::NUMBER);
+        put(out, *number);
+    } else if (auto integer = std::get_if<int64_t>(&value)) {
+        put(out, ValueTag::INTEGER);
+        put(out, *integer);
+    } else {
+        put(out, ValueTag::TIMESTAMP);
+        put<int64_t>(out, std::get<Timestamp>(value).time_since_epoch().count());
+    }
+}
+
+static uint32_t checksum(const char* data, size_t size) {
+    return static_cast<uint32_t>(SnapshotFormat::hashString(std::string_view(data, size)));
+}
+
+static bool syncFile(std::FILE* file) {
+#ifdef SWARMCOG_HAVE_FSYNC
+    return ::fsync(fileno(file)) == 0;
+#else
+    (void)file;
+    return true;
+#endif
+}
+
+// Bounds-checked decoder over one record payload
+class RecordReader {
+public:
+    RecordReader(const char* data, size_t size) : cursor_(data), end_(data + size) {}
+
+    bool ok() const { return ok_; }
+    bool done() const { return cursor_ == end_; }
+
+    template<typename T>
+    T get() {
+        T value{};
+        if (static_cast<size_t>(end_ - cursor_) < sizeof(T)) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, cursor_, sizeof(T));
+        cursor_ += sizeof(T);
+        return value;
+    }
+
+    std::string getString() {
+        uint32_t length = get<uint32_t>();
+        if (!ok_ || static_cast<size_t>(end_ - cursor_) < length) {
+            ok_ = false;
+            return std::string();
+        }
+        std::string str(cursor_, length);
+        cursor_ += length;
+        return str;
+    }
+
+    MetadataValue getValue() {
+        switch (get<ValueTag>()) {
+            case ValueTag::STRING: return getString();
+            case ValueTag::NUMBER: return get<double>();
+            case ValueTag::INTEGER: return get<int64_t>();
+            case ValueTag::TIMESTAMP: return Timestamp(Timestamp::duration(get<int64_t>()));
+        }
+        ok_ = false;
+        return MetadataValue();
+    }
+
+private:
+    const char* cursor_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+static bool decodeRecord(RecordReader& in, MutationRecord& record) {
+    record.kind = in.get<MutationKind>();
+    record.atom_id = in.getString();
+
+    switch (record.kind) {
+        case MutationKind::ADD_NODE:
+        case MutationKind::ADD_LINK: {
+            uint32_t type = in.get<uint32_t>();
+            if (type >= SnapshotFormat::kTypeCount) return false;
+            record.type = static_cast<AtomType>(type);
+            record.name = in.getString();
+            record.timestamp = Timestamp(Timestamp::duration(in.get<int64_t>()));
+            double strength = in.get<double>();
+            double confidence = in.get<double>();
+            record.truth_value = TruthValue(strength, confidence);
+            double sti = in.get<double>();
+            double lti = in.get<double>();
+            double vlti = in.get<double>();
+            record.attention_value = AttentionValue(sti, lti, vlti);
+
+            if (record.kind == MutationKind::ADD_NODE) {
+                record.value = in.getString();
+            } else {
+                uint32_t arity = in.get<uint32_t>();
+                for (uint32_t i = 0; i < arity && in.ok(); ++i) {
+                    record.outgoing.push_back(in.getString());
+                }
+            }
+
+            uint32_t entries = in.get<uint32_t>();
+            for (uint32_t i = 0; i < entries && in.ok(); ++i) {
+                std::string key = in.getString();
+                record.metadata.emplace_back(std::move(key), in.getValue());
+            }
+            break;
+        }
+        case MutationKind::SET_TRUTH: {
+            double strength = in.get<double>();
+            double confidence = in.get<double>();
+            record.truth_value = TruthValue(strength, confidence);
+            break;
+        }
+        case MutationKind::SET_ATTENTION: {
+            double sti = in.get<double>();
+            double lti = in.get<double>();
+            double vlti = in.get<double>();
+            record.attention_value = AttentionValue(sti, lti, vlti);
+            break;
+        }
+        case MutationKind::SET_METADATA: {
+            std::string key = in.getString();
+            record.metadata.emplace_back(std::move(key), in.getValue());
+            break;
+        }
+        case MutationKind::REMOVE:
+        case MutationKind::CLEAR:
+            break;
+        default:
+            return false;
+    }
+
+    return in.ok() && in.done();
+}
+
+// Decodes the leading run of intact records, passing each to `visit` when
+// one is given; returns the byte length of that run
+static size_t scanRecords(const std::string& contents, const std::function<void(const MutationRecord&)>* visit,
+                          size_t& count) {
+    size_t offset = 0;
+    while (contents.size() - offset >= kRecordHeaderSize) {
+        uint32_t length;
+        uint32_t sum;
+        std::memcpy(&length, contents.data() + offset, sizeof(length));
+        std::memcpy(&sum, contents.data() + offset + sizeof(length), sizeof(sum));
+
+        const char* payload = contents.data() + offset + kRecordHeaderSize;
+        if (length > contents.size() - offset - kRecordHeaderSize || checksum(payload, length) != sum) {
+            break;
+        }
+
+        MutationRecord record;
+        RecordReader reader(payload, length);
+        if (!decodeRecord(reader, record)) {
+            break;
+        }
+
+        if (visit) (*visit)(record);
+        ++count;
+        offset += kRecordHeaderSize + length;
+    }
+    return offset;
+}
+
+// Cuts a torn or corrupt tail off a log file. Replay stops at the first bad
+// record, so anything appended after one would never be read back.
+static bool dropTornTail(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return true;  // nothing written yet
+    }
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    size_t count = 0;
+    size_t intact = scanRecords(contents, nullptr, count);
+    if (intact == contents.size()) {
+        return true;
+    }
+
+    std::error_code error;
+    std::filesystem::resize_file(path, intact, error);
+    if (error) {
+        Utils::Logger::error("Cannot truncate torn mutation log " + path + ": " + error.message());
+        return false;
+    }
+
+    Utils::Logger::warning("Truncated mutation log " + path + " after " + std::to_string(count) +
+                           " records, dropping " + std::to_string(contents.size() - intact) + " unreadable bytes");
+    return true;
+}
+
+// MutationLog Implementation
+MutationLog::MutationLog(const std::string& path, const MutationLogConfig& config, std::FILE* file)
+    : path_(path), config_(config), file_(file) {
+    flusher_ = std::thread(&MutationLog::flushLoop, this);
+}
+
+MutationLog::~MutationLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    flush_cv_.notify_one();
+    flusher_.join();
+
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+std::shared_ptr<MutationLog> MutationLog::open(const std::string& path, const MutationLogConfig& config) {
+    if (!dropTornTail(path)) {
+        return nullptr;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        Utils::Logger::error("Cannot open mutation log: " + path);
+        return nullptr;
+    }
+
+    return std::shared_ptr<MutationLog>(new MutationLog(path, config, file));
+}
+
+size_t MutationLog::beginRecord(MutationKind kind, const AtomId& id) {
+    size_t start = pending_.size();
+    pending_.append(kRecordHeaderSize, '\0');
+    put(pending_, kind);
+    putString(pending_, id);
+    return start;
+}
+
+void MutationLog::endRecord(size_t start) {
+    const char* payload = pending_.data() + start + kRecordHeaderSize;
+    uint32_t length = static_cast<uint32_t>(pending_.size() - start - kRecordHeaderSize);
+    uint32_t sum = checksum(payload, length);
+    std::memcpy(&pending_[start], &length, sizeof(length));
+    std::memcpy(&pending_[start + sizeof(length)], &sum, sizeof(sum));
+    ++appended_;
+
+    // Wake the flusher when a group opens, and early when it grows large
+    if (start == 0 || pending_.size() >= config_.max_pending_bytes) {
+        flush_cv_.notify_one();
+    }
+}
+
+void MutationLog::logAdd(const Atom& atom) {
+    // Read the atom before taking the log lock; the log never calls back into atoms
+    TruthValue tv = atom.getTruthValue();
+    AttentionValue av = atom.getAttentionValue();
+    auto entries = atom.getMetadataEntries();
+    auto link = dynamic_cast<const Link*>(&atom);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t start = beginRecord(link ? MutationKind::ADD_LINK : MutationKind::ADD_NODE, atom.getId());
+    put<uint32_t>(pending_, static_cast<uint32_t>(atom.getType()));
+    putString(pending_, atom.getName());
+    put<int64_t>(pending_, atom.getTimestamp().time_since_epoch().count());
+    put(pending_, tv.strength);
+    put(pending_, tv.confidence);
+    put(pending_, av.sti);
+    put(pending_, av.lti);
+    put(pending_, av.vlti);
+
+    if (link) {
+        put<uint32_t>(pending_, static_cast<uint32_t>(link->getArity()));
+        for (const auto& target : link->getOutgoing()) {
+            putString(pending_, target ? target->getId() : AtomId());
+        }
+    } else if (auto node = dynamic_cast<const Node*>(&atom)) {
+        putString(pending_, node->getValue());
+    } else {
+        putString(pending_, std::string());
+    }
+
+    put<uint32_t>(pending_, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        putString(pending_, MetadataKeys::name(entry.key));
+        putValue(pending_, entry.value);
+    }
+    endRecord(start);
+}
+
+void MutationLog::logRemove(const AtomId& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endRecord(beginRecord(MutationKind::REMOVE, id));
+}
+
+void MutationLog::logTruthValue(const AtomId& id, const TruthValue& tv) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t start = beginRecord(MutationKind::SET_TRUTH, id);
+    put(pending_, tv.strength);
+    put(pending_, tv.confidence);
+    endRecord(start);
+}
+
+void MutationLog::logAttentionValue(const AtomId& id, const AttentionValue& av) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t start = beginRecord(MutationKind::SET_ATTENTION, id);
+    put(pending_, av.sti);
+    put(pending_, av.lti);
+    put(pending_, av.vlti);
+    endRecord(start);
+}
+
+void MutationLog::logMetadata(const AtomId& id, MetadataKeyId key, const MetadataValue& value) {
+    const std::string& key_name = MetadataKeys::name(key);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t start = beginRecord(MutationKind::SET_METADATA, id);
+    putString(pending_, key_name);
+    putValue(pending_, value);
+    endRecord(start);
+}
+
+void MutationLog::logClear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endRecord(beginRecord(MutationKind::CLEAR, AtomId()));
+}
+
+void MutationLog::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        flush_cv_.wait(lock, [this] { return stopping_ || flush_requested_ || !pending_.empty(); });
+
+        // Hold the group open for its window so one sync covers many records,
+        // unless a caller is already waiting on it
+        flush_cv_.wait_for(lock, config_.flush_interval, [this] {
+            return stopping_ || flush_requested_ || pending_.size() >= config_.max_pending_bytes;
+        });
+
+        flush_requested_ = false;
+        uint64_t target = appended_;
+
+        if (!pending_.empty()) {
+            writing_.swap(pending_);
+            lock.unlock();
+            bool ok = writeOut(writing_);
+            writing_.clear();
+            lock.lock();
+
+            if (!ok) failed_ = true;
+            ++syncs_;
+        }
+
+        durable_ = target;
+        durable_cv_.notify_all();
+
+        if (stopping_ && pending_.empty()) break;
+    }
+}
+
+bool MutationLog::writeOut(const std::string& batch) {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+
+    if (!file_ ||
+        std::fwrite(batch.data(), 1, batch.size(), file_) != batch.size() ||
+        std::fflush(file_) != 0 ||
+        (config_.sync && !syncFile(file_))) {
+        Utils::Logger::error("Failed writing mutation log: " + path_);
+        return false;
+    }
+    return true;
+}
+
+bool MutationLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    uint64_t target = appended_;
+    if (durable_ < target) {
+        flush_requested_ = true;
+        flush_cv_.notify_one();
+        durable_cv_.wait(lock, [this, target] { return durable_ >= target; });
+    }
+    return !failed_;
+}
+
+bool MutationLog::rotate() {
+    if (!flush()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    std::fclose(file_);
+    file_ = nullptr;
+
+    std::string rotated = rotatedPath(path_);
+    bool ok = true;
+
+    std::FILE* existing = std::fopen(rotated.c_str(), "rb");
+    if (!existing) {
+        ok = std::rename(path_.c_str(), rotated.c_str()) == 0;
+    } else {
+        // An earlier checkpoint did not finish; its segment must be kept, so
+        // the current records are appended to it instead
+        std::fclose(existing);
+        ok = dropTornTail(rotated);
+        std::ifstream in(path_, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::FILE* out = ok ? std::fopen(rotated.c_str(), "ab") : nullptr;
+        ok = out &&
+             std::fwrite(contents.data(), 1, contents.size(), out) == contents.size() &&
+             std::fflush(out) == 0 && syncFile(out);
+        if (out) std::fclose(out);
+        if (ok) std::remove(path_.c_str());
+    }
+
+    file_ = std::fopen(path_.c_str(), "ab");
+    if (!ok || !file_) {
+        Utils::Logger::error("Failed rotating mutation log: " + path_);
+        std::lock_guard<std::mutex> state_lock(mutex_);
+        failed_ = true;
+        return false;
+    }
+
+    return true;
+}
+
+void MutationLog::discardRotated() {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    std::remove(rotatedPath(path_).c_str());
+}
+
+uint64_t MutationLog::getAppendedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appended_;
+}
+
+uint64_t MutationLog::getDurableCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return durable_;
+}
+
+uint64_t MutationLog::getSyncCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return syncs_;
+}
+
+size_t MutationLog::read(const std::string& path, const std::function<void(const MutationRecord&)>& visit) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t count = 0;
+    size_t intact = scanRecords(contents, &visit, count);
+    if (intact != contents.size()) {
+        Utils::Logger::warning("Mutation log " + path + " ends with " +
+                               std::to_string(contents.size() - intact) + " unreadable bytes");
+    }
+    return count;
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -0,0 +1,534 @@
+#include "swarmcog/pattern_query.h"
+#include "swarmcog/agentspace.h"
+#include "swarmcog/utils.h"
+#include <algorithm>
+#include <sstream>
+#include <limits>
+
+namespace SwarmCog {
+
+AtomHandle PatternTerm::handleOf(const Atom* stored) {
+    return stored ? stored->getHandle() : AtomHandle();
+}
+
+// PatternQuery Implementation
+int PatternQuery::variableIndex(const std::string& variable) {
+    auto it = std::find(variable_names_.begin(), variable_names_.end(), variable);
+    if (it != variable_names_.end()) {
+        return static_cast<int>(it - variable_names_.begin());
+    }
+
+    variable_names_.push_back(variable);
+    variables_.emplace_back();
+    return static_cast<int>(variables_.size() - 1);
+}
+
+PatternQuery& PatternQuery::node(const std::string& variable, AtomType type, const std::string& name) {
+    Variable& var = variables_[variableIndex(variable)];
+    var.typed = true;
+    var.type = type;
+    var.name = name;
+    return *this;
+}
+
+PatternQuery& PatternQuery::link(AtomType type, std::vector<PatternTerm> outgoing,
+                                 const std::string& link_variable, LinkOrder order) {
+    Clause clause;
+    clause.type = type;
+    clause.order = order;
+    for (const auto& term : outgoing) {
+        Term resolved;
+        if (term.isVariable()) {
+            resolved.variable = variableIndex(term.variable);
+        } else {
+            resolved.atom = term.atom;
+        }
+        clause.outgoing.push_back(resolved);
+    }
+    if (!link_variable.empty()) {
+        clause.link_variable = variableIndex(link_variable);
+    }
+
+    clauses_.push_back(std::move(clause));
+    return *this;
+}
+
+PatternQuery& PatternQuery::where(const std::string& variable, Predicate predicate) {
+    variables_[variableIndex(variable)].predicates.push_back(std::move(predicate));
+    return *this;
+}
+
+PatternQuery& PatternQuery::whereTruth(const std::string& variable, double min_strength, double min_confidence) {
+    return where(variable, [min_strength, min_confidence](const Atom& atom) {
+        TruthValue tv = atom.getTruthValue();
+        return tv.strength >= min_strength && tv.confidence >= min_confidence;
+    });
+}
+
+PatternQuery& PatternQuery::whereMetadata(const std::string& variable, MetadataKeyId key,
+                                          std::function<bool(const MetadataValue&)> predicate) {
+    return where(variable, [key, predicate = std::move(predicate)](const Atom& atom) {
+        auto value = atom.getMetadataValue(key);
+        return value && predicate(*value);
+    });
+}
+
+PatternQuery& PatternQuery::parallelThreshold(size_t candidates) {
+    parallel_threshold_ = candidates;
+    return *this;
+}
+
+/**
+ * PatternMatcher - Plans and runs one PatternQuery against one snapshot
+ *
+ * Bindings point at the AtomPtrs held by the snapshot's slots and by link
+ * outgoing sets, so the search itself copies no pointers until a full match
+ * is emitted.
+ */
+class PatternMatcher {
+public:
+    PatternMatcher(const PatternQuery& query, const AgentSpaceSnapshot& snapshot)
+        : query_(query), snapshot_(snapshot) {
+        plan();
+    }
+
+    QueryResult run(size_t limit) const;
+    std::string explain() const;
+
+private:
+    enum class StepKind {
+        SCAN_VARIABLE,  // enumerate a variable from its name or type index
+        SCAN_LINKS,     // enumerate every link of the clause's type
+        EXPAND,         // walk the incoming set of an already bound position
+        CHECK_LINK,     // the clause's link variable is bound; verify it
+    };
+
+    struct Step {
+        StepKind kind = StepKind::SCAN_VARIABLE;
+        int clause = -1;
+        int variable = -1;
+        size_t anchor = 0;  // EXPAND: outgoing position walked from
+        double cost = 0.0;
+    };
+
+    using Bindings = std::vector<const AtomPtr*>;
+    using Rows = std::vector<std::vector<AtomPtr>>;
+
+    const PatternQuery& query_;
+    const AgentSpaceSnapshot& snapshot_;
+    std::vector<Step> plan_;
+
+    // Index statistics
+    size_t typeCount(AtomType type) const;
+    size_t nameCount(const std::string& name) const;
+    size_t incomingCount(AtomHandle handle) const;
+    double variableCost(int variable) const;
+
+    void plan();
+
+    const AtomPtr* anchorAtom(const Step& step, const Bindings& bindings) const;
+    template<typename Visit>
+    void forEachCandidate(const Step& step, const Bindings& bindings, Visit&& visit) const;
+
+    bool bindVariable(int variable, const AtomPtr* atom, Bindings& bindings, std::vector<int>& bound) const;
+    bool matchLink(const PatternQuery::Clause& clause, const AtomPtr* link, bool swapped,
+                   Bindings& bindings, std::vector<int>& bound) const;
+    bool apply(const Step& step, const AtomPtr* candidate, bool swapped,
+               Bindings& bindings, std::vector<int>& bound) const;
+    void search(size_t step, Bindings& bindings, Rows& rows, size_t limit) const;
+};
+
+size_t PatternMatcher::typeCount(AtomType type) const {
+    size_t count = 0;
+    for (const auto& shard : snapshot_.shards_) {
+        const auto& index = shard->index().atoms_by_type;
+        auto it = index.find(type);
+        if (it != index.end()) count += it->second.size();
+    }
+    return count;
+}
+
+size_t PatternMatcher::nameCount(const std::string& name) const {
+    size_t count = 0;
+    for (const auto& shard : snapshot_.shards_) {
+        const auto& index = shard->index().atoms_by_name;
+        auto it = index.find(name);
+        if (it != index.end()) count += it->second.size();
+    }
+    return count;
+}
+
+size_t PatternMatcher::incomingCount(AtomHandle handle) const {
+    auto slot = snapshot_.slotOf(handle);
+    return slot ? slot->incoming.size() : 0;
+}
+
+double PatternMatcher::variableCost(int variable) const {
+    const auto& var = query_.variables_[variable];
+    if (!var.name.empty()) return static_cast<double>(nameCount(var.name));
+    if (var.typed) return static_cast<double>(typeCount(var.type));
+    return static_cast<double>(snapshot_.getAtomCount());
+}
+
+void PatternMatcher::plan() {
+    const auto& clauses = query_.clauses_;
+    std::vector<bool> bound(query_.variables_.size(), false);
+    std::vector<bool> done(clauses.size(), false);
+    double atom_count = std::max<double>(1.0, static_cast<double>(snapshot_.getAtomCount()));
+
+    for (size_t remaining = clauses.size(); remaining > 0;) {
+        Step best;
+        best.cost = std::numeric_limits<double>::infinity();
+        auto consider = [&best](const Step& step) {
+            if (step.cost < best.cost) best = step;
+        };
+
+        for (size_t c = 0; c < clauses.size(); ++c) {
+            if (done[c]) continue;
+            const auto& clause = clauses[c];
+            int index = static_cast<int>(c);
+
+            if (clause.link_variable >= 0 && bound[clause.link_variable]) {
+                consider({StepKind::CHECK_LINK, index, -1, 0, 0.0});
+            }
+
+            // A bound end is the cheapest way in: its incoming set is small
+            double degree = std::max(1.0, typeCount(clause.type) * static_cast<double>(clause.outgoing.size()) / atom_count);
+            for (size_t p = 0; p < clause.outgoing.size(); ++p) {
+                const auto& term = clause.outgoing[p];
+                if (term.variable < 0) {
+                    consider({StepKind::EXPAND, index, -1, p, static_cast<double>(incomingCount(term.atom))});
+                } else if (bound[term.variable]) {
+                    consider({StepKind::EXPAND, index, -1, p, degree});
+                }
+            }
+
+            consider({StepKind::SCAN_LINKS, index, -1, 0, static_cast<double>(typeCount(clause.type))});
+
+            for (const auto& term : clause.outgoing) {
+                if (term.variable < 0 || bound[term.variable]) continue;
+                const auto& var = query_.variables_[term.variable];
+                if (var.typed || !var.name.empty()) {
+                    consider({StepKind::SCAN_VARIABLE, -1, term.variable, 0, variableCost(term.variable)});
+                }
+            }
+        }
+
+        plan_.push_back(best);
+        if (best.kind == StepKind::SCAN_VARIABLE) {
+            bound[best.variable] = true;
+            continue;
+        }
+
+        const auto& clause = clauses[best.clause];
+        done[best.clause] = true;
+        --remaining;
+        for (const auto& term : clause.outgoing) {
+            if (term.variable >= 0) bound[term.variable] = true;
+        }
+        if (clause.link_variable >= 0) bound[clause.link_variable] = true;
+    }
+
+    // Variables outside every clause are enumerated last (a cross product)
+    for (size_t v = 0; v < bound.size(); ++v) {
+        if (!bound[v]) {
+            int variable = static_cast<int>(v);
+            plan_.push_back({StepKind::SCAN_VARIABLE, -1, variable, 0, variableCost(variable)});
+        }
+    }
+}
+
+const AtomPtr* PatternMatcher::anchorAtom(const Step& step, const Bindings& bindings) const {
+    const auto& term = query_.clauses_[step.clause].outgoing[step.anchor];
+    if (term.variable >= 0) return bindings[term.variable];
+
+    auto slot = snapshot_.slotOf(term.atom);
+    return slot ? &slot->atom : nullptr;
+}
+
+// Calls visit(candidate, swapped) until it returns false
+template<typename Visit>
+void PatternMatcher::forEachCandidate(const Step& step, const Bindings& bindings, Visit&& visit) const {
+    auto visitLink = [&](const AtomPtr* link) {
+        if (!visit(link, false)) return false;
+        const auto& clause = query_.clauses_[step.clause];
+        if (clause.order == LinkOrder::ANY_ORDER && clause.outgoing.size() == 2) {
+            return visit(link, true);
+        }
+        return true;
+    };
+
+    switch (step.kind) {
+        case StepKind::SCAN_VARIABLE: {
+            const auto& var = query_.variables_[step.variable];
+            for (const auto& shard : snapshot_.shards_) {
+                if (!var.name.empty() || var.typed) {
+                    const std::vector<uint32_t>* slots = nullptr;
+                    const auto& index = shard->index();
+                    if (!var.name.empty()) {
+                        auto it = index.atoms_by_name.find(var.name);
+                        if (it != index.atoms_by_name.end()) slots = &it->second;
+                    } else {
+                        auto it = index.atoms_by_type.find(var.type);
+                        if (it != index.atoms_by_type.end()) slots = &it->second;
+                    }
+                    if (!slots) continue;
+                    for (uint32_t local_slot : *slots) {
+                        if (!visit(&shard->slot(local_slot).atom, false)) return;
+                    }
+                } else {
+                    for (const auto& chunk : shard->chunks) {
+                        for (const auto& slot : *chunk) {
+                            if (slot.atom && !visit(&slot.atom, false)) return;
+                        }
+                    }
+                }
+            }
+            break;
+        }
+        case StepKind::SCAN_LINKS: {
+            AtomType type = query_.clauses_[step.clause].type;
+            for (const auto& shard : snapshot_.shards_) {
+                const auto& index = shard->index().atoms_by_type;
+                auto it = index.find(type);
+                if (it == index.end()) continue;
+                for (uint32_t local_slot : it->second) {
+                    if (!visitLink(&shard->slot(local_slot).atom)) return;
+                }
+            }
+            break;
+        }
+        case StepKind::EXPAND: {
+            const AtomPtr* anchor = anchorAtom(step, bindings);
+            if (!anchor || !*anchor) return;
+
+            auto slot = snapshot_.slotOf((*anchor)->getHandle());
+            if (!slot) return;
+
+            AtomType type = query_.clauses_[step.clause].type;
+            // A link naming the anchor k times is listed k times, not always
+            // adjacently, since removals swap entries out; visit it only once
+            std::vector<AtomHandle> repeated;
+            for (AtomHandle link_handle : slot->incoming) {
+                auto link_slot = snapshot_.slotOf(link_handle);
+                if (!link_slot || link_slot->atom->getType() != type) continue;
+
+                const auto& outgoing = static_cast<const Link&>(*link_slot->atom).getOutgoing();
+                auto names_anchor = [anchor](const AtomPtr& target) { return target.get() == anchor->get(); };
+                if (std::count_if(outgoing.begin(), outgoing.end(), names_anchor) > 1) {
+                    if (std::find(repeated.begin(), repeated.end(), link_handle) != repeated.end()) continue;
+                    repeated.push_back(link_handle);
+                }
+                if (!visitLink(&link_slot->atom)) return;
+            }
+            break;
+        }
+        case StepKind::CHECK_LINK:
+            visitLink(bindings[query_.clauses_[step.clause].link_variable]);
+            break;
+    }
+}
+
+bool PatternMatcher::bindVariable(int variable, const AtomPtr* atom, Bindings& bindings,
+                                  std::vector<int>& bound) const {
+    if (!atom || !*atom) return false;
+    if (bindings[variable]) {
+        return bindings[variable]->get() == atom->get();
+    }
+
+    const auto& var = query_.variables_[variable];
+    const Atom& candidate = **atom;
+    if (var.typed && candidate.getType() != var.type) return false;
+    if (!var.name.empty() && candidate.getName() != var.name) return false;
+    for (const auto& predicate : var.predicates) {
+        if (!predicate(candidate)) return false;
+    }
+
+    bindings[variable] = atom;
+    bound.push_back(variable);
+    return true;
+}
+
+bool PatternMatcher::matchLink(const PatternQuery::Clause& clause, const AtomPtr* link, bool swapped,
+                               Bindings& bindings, std::vector<int>& bound) const {
+    if ((*link)->getType() != clause.type) return false;
+
+    auto link_atom = std::static_pointer_cast<Link>(*link);
+    const auto& outgoing = link_atom->getOutgoing();
+    if (outgoing.size() != clause.outgoing.size()) return false;
+
+    for (size_t p = 0; p < outgoing.size(); ++p) {
+        const AtomPtr& target = outgoing[swapped ? outgoing.size() - 1 - p : p];
+        const auto& term = clause.outgoing[p];
+
+        if (term.variable < 0) {
+            if (!target || target->getHandle() != term.atom) return false;
+        } else if (!bindVariable(term.variable, &target, bindings, bound)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PatternMatcher::apply(const Step& step, const AtomPtr* candidate, bool swapped,
+                           Bindings& bindings, std::vector<int>& bound) const {
+    if (step.kind == StepKind::SCAN_VARIABLE) {
+        return bindVariable(step.variable, candidate, bindings, bound);
+    }
+
+    const auto& clause = query_.clauses_[step.clause];
+    if (clause.link_variable >= 0 && !bindVariable(clause.link_variable, candidate, bindings, bound)) {
+        return false;
+    }
+    return matchLink(clause, candidate, swapped, bindings, bound);
+}
+
+void PatternMatcher::search(size_t step, Bindings& bindings, Rows& rows, size_t limit) const {
+    if (step == plan_.size()) {
+        std::vector<AtomPtr> row;
+        row.reserve(bindings.size());
+        for (const AtomPtr* atom : bindings) {
+            row.push_back(*atom);
+        }
+        rows.push_back(std::move(row));
+        return;
+    }
+
+    std::vector<int> bound;
+    forEachCandidate(plan_[step], bindings, [&](const AtomPtr* candidate, bool swapped) {
+        if (limit && rows.size() >= limit) return false;
+
+        bound.clear();
+        if (apply(plan_[step], candidate, swapped, bindings, bound)) {
+            search(step + 1, bindings, rows, limit);
+        }
+        for (int variable : bound) {
+            bindings[variable] = nullptr;
+        }
+        return true;
+    });
+}
+
+QueryResult PatternMatcher::run(size_t limit) const {
+    size_t variable_count = query_.variables_.size();
+    Rows rows;
+
+    if (plan_.empty()) {
+        return QueryResult(query_.variable_names_, std::move(rows));
+    }
+
+    // The first step's candidates are the unit of parallel work
+    std::vector<std::pair<const AtomPtr*, bool>> first;
+    Bindings empty(variable_count, nullptr);
+    forEachCandidate(plan_[0], empty, [&first](const AtomPtr* candidate, bool swapped) {
+        first.emplace_back(candidate, swapped);
+        return true;
+    });
+
+    // Each range stops at its own limit rather than a shared count, so the
+    // rows kept after concatenation do not depend on thread timing
+    auto runRange = [&](size_t begin, size_t end, Rows& out) {
+        Bindings bindings(variable_count, nullptr);
+        std::vector<int> bound;
+        for (size_t i = begin; i < end; ++i) {
+            if (limit && out.size() >= limit) break;
+
+            bound.clear();
+            if (apply(plan_[0], first[i].first, first[i].second, bindings, bound)) {
+                search(1, bindings, out, limit);
+            }
+            for (int variable : bound) {
+                bindings[variable] = nullptr;
+            }
+        }
+    };
+
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    if (first.size() < query_.parallel_threshold_ || workers == 1) {
+        runRange(0, first.size(), rows);
+    } else {
+        // Contiguous chunks, concatenated in order, keep results deterministic
+        workers = std::min(workers, first.size());
+        std::vector<Rows> partial(workers);
+        std::vector<std::thread> threads;
+        size_t chunk = (first.size() + workers - 1) / workers;
+        for (size_t w = 0; w < workers; ++w) {
+            size_t begin = std::min(first.size(), w * chunk);
+            size_t end = std::min(first.size(), begin + chunk);
+            threads.emplace_back(runRange, begin, end, std::ref(partial[w]));
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto& part : partial) {
+            std::move(part.begin(), part.end(), std::back_inserter(rows));
+        }
+    }
+
+    if (limit && rows.size() > limit) {
+        rows.resize(limit);
+    }
+    return QueryResult(query_.variable_names_, std::move(rows));
+}
+
+std::string PatternMatcher::explain() const {
+    std::ostringstream oss;
+    for (size_t i = 0; i < plan_.size(); ++i) {
+        const Step& step = plan_[i];
+        oss << i + 1 << ". ";
+        switch (step.kind) {
+            case StepKind::SCAN_VARIABLE:
+                oss << "scan " << query_.variable_names_[step.variable];
+                break;
+            case StepKind::SCAN_LINKS:
+                oss << "scan links of clause " << step.clause;
+                break;
+            case StepKind::EXPAND:
+                oss << "expand clause " << step.clause << " from position " << step.anchor;
+                break;
+            case StepKind::CHECK_LINK:
+                oss << "check clause " << step.clause;
+                break;
+        }
+        oss << " (est. " << static_cast<size_t>(step.cost) << ")\n";
+    }
+    return oss.str();
+}
+
+std::string PatternQuery::explain(const AgentSpaceSnapshot& snapshot) const {
+    return PatternMatcher(*this, snapshot).explain();
+}
+
+// QueryResult Implementation
+int QueryResult::columnIndex(const std::string& variable) const {
+    auto it = std::find(variables_.begin(), variables_.end(), variable);
+    return it != variables_.end() ? static_cast<int>(it - variables_.begin()) : -1;
+}
+
+AtomPtr QueryResult::get(size_t row, const std::string& variable) const {
+    int column = columnIndex(variable);
+    return column >= 0 ? rows_[row][column] : nullptr;
+}
+
+std::vector<AtomPtr> QueryResult::column(const std::string& variable) const {
+    std::vector<AtomPtr> result;
+    int index = columnIndex(variable);
+    if (index < 0) return result;
+
+    result.reserve(rows_.size());
+    for (const auto& row : rows_) {
+        result.push_back(row[index]);
+    }
+    return result;
+}
+
+// Query entry points
+QueryResult AgentSpaceSnapshot::query(const PatternQuery& pattern, size_t limit) const {
+    return PatternMatcher(pattern, *this).run(limit);
+}
+
+QueryResult AgentSpace::query(const PatternQuery& pattern, size_t limit) const {
+    return snapshot()->query(pattern, limit);
+}
+
+} // namespace SwarmCog
\ No newline at end of file
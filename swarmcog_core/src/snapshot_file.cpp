@@ -0,0 +1,429 @@
+#include "swarmcog/snapshot_file.h"
+#include "swarmcog/agentspace.h"
+#include "swarmcog/utils.h"
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SWARMCOG_HAVE_MMAP 1
+#define SWARMCOG_HAVE_FSYNC 1
+#endif
+
+namespace SwarmCog {
+
+namespace SnapshotFormat {
+
+uint64_t hashString(std::string_view str) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // namespace SnapshotFormat
+
+using namespace SnapshotFormat;
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+static bool syncFile(std::FILE* file) {
+#ifdef SWARMCOG_HAVE_FSYNC
+    return ::fsync(fileno(file)) == 0;
+#else
+    (void)file;
+    return true;
+#endif
+}
+
+// Makes a rename inside the file's directory durable
+static bool syncParentDirectory(const std::string& path) {
+#ifdef SWARMCOG_HAVE_FSYNC
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+// Snapshot writer
+bool writeSnapshotFile(const std::string& path, const std::string& space_name,
+                       const std::vector<std::shared_ptr<Atom>>& atoms) {
+    if (atoms.size() >= kNoAtom) {
+        Utils::Logger::error("Snapshot too large: " + std::to_string(atoms.size()) + " atoms");
+        return false;
+    }
+
+    std::string strings;
+    auto addString = [&strings](const std::string& str) {
+        StringRef ref;
+        ref.offset = strings.size();
+        ref.length = static_cast<uint32_t>(str.size());
+        strings.append(str);
+        return ref;
+    };
+
+    std::unordered_map<const Atom*, uint32_t> index_of;
+    index_of.reserve(atoms.size());
+    for (uint32_t i = 0; i < atoms.size(); ++i) {
+        index_of[atoms[i].get()] = i;
+    }
+
+    const uint32_t atom_count = static_cast<uint32_t>(atoms.size());
+    std::vector<AtomRecord> records(atom_count);
+    std::vector<uint32_t> outgoing;
+    std::vector<MetadataRecord> metadata;
+    std::vector<uint32_t> incoming_begin(atom_count + 1, 0);
+    std::vector<uint32_t> type_begin(kTypeCount + 1, 0);
+
+    for (uint32_t i = 0; i < atom_count; ++i) {
+        const Atom& atom = *atoms[i];
+        AtomRecord& record = records[i];
+        record = AtomRecord{};
+
+        record.type = static_cast<uint32_t>(atom.getType());
+        record.id = addString(atom.getId());
+        record.name = addString(atom.getName());
+
+        TruthValue tv = atom.getTruthValue();
+        AttentionValue av = atom.getAttentionValue();
+        record.strength = tv.strength;
+        record.confidence = tv.confidence;
+        record.sti = av.sti;
+        record.lti = av.lti;
+        record.vlti = av.vlti;
+        record.timestamp = atom.getTimestamp().time_since_epoch().count();
+
+        record.outgoing_begin = static_cast<uint32_t>(outgoing.size());
+        if (auto link = dynamic_cast<const Link*>(&atom)) {
+            record.flags |= kLinkRecord;
+            for (const auto& target : link->getOutgoing()) {
+                auto it = index_of.find(target.get());
+                if (it == index_of.end() || it->second >= i) {
+                    Utils::Logger::error("Snapshot link " + atom.getId() + " targets an atom written after it");
+                    return false;
+                }
+                outgoing.push_back(it->second);
+                ++incoming_begin[it->second + 1];
+            }
+        } else if (auto node = dynamic_cast<const Node*>(&atom)) {
+            record.value = addString(node->getValue());
+        }
+        record.outgoing_count = static_cast<uint32_t>(outgoing.size()) - record.outgoing_begin;
+
+        record.metadata_begin = static_cast<uint32_t>(metadata.size());
+        for (const auto& entry : atom.getMetadataEntries()) {
+            MetadataRecord meta{};
+            meta.key = addString(MetadataKeys::name(entry.key));
+
+            if (auto str = std::get_if<std::string>(&entry.value)) {
+                meta.kind = MetadataKind::STRING;
+                meta.text = addString(*str);
+            } else if (auto number = std::get_if<double>(&entry.value)) {
+                meta.kind = MetadataKind::NUMBER;
+                std::memcpy(&meta.scalar, number, sizeof(double));
+            } else if (auto integer = std::get_if<int64_t>(&entry.value)) {
+                meta.kind = MetadataKind::INTEGER;
+                meta.scalar = *integer;
+            } else {
+                meta.kind = MetadataKind::TIMESTAMP;
+                meta.scalar = std::get<Timestamp>(entry.value).time_since_epoch().count();
+            }
+            metadata.push_back(meta);
+        }
+        record.metadata_count = static_cast<uint32_t>(metadata.size()) - record.metadata_begin;
+
+        ++type_begin[record.type + 1];
+    }
+
+    // Prefix sums turn the counts into CSR row starts
+    for (size_t i = 1; i < incoming_begin.size(); ++i) incoming_begin[i] += incoming_begin[i - 1];
+    for (size_t i = 1; i < type_begin.size(); ++i) type_begin[i] += type_begin[i - 1];
+
+    std::vector<uint32_t> incoming(outgoing.size());
+    std::vector<uint32_t> type_atoms(atom_count);
+    {
+        std::vector<uint32_t> incoming_fill(incoming_begin.begin(), incoming_begin.end() - 1);
+        std::vector<uint32_t> type_fill(type_begin.begin(), type_begin.end() - 1);
+        for (uint32_t i = 0; i < atom_count; ++i) {
+            const AtomRecord& record = records[i];
+            for (uint32_t k = 0; k < record.outgoing_count; ++k) {
+                incoming[incoming_fill[outgoing[record.outgoing_begin + k]]++] = i;
+            }
+            type_atoms[type_fill[record.type]++] = i;
+        }
+    }
+
+    // Open-addressing id index at no more than 50% load
+    uint64_t capacity = 16;
+    while (capacity < static_cast<uint64_t>(atom_count) * 2) capacity <<= 1;
+    std::vector<uint32_t> id_index(capacity, kNoAtom);
+    for (uint32_t i = 0; i < atom_count; ++i) {
+        uint64_t pos = hashString(atoms[i]->getId()) & (capacity - 1);
+        while (id_index[pos] != kNoAtom) pos = (pos + 1) & (capacity - 1);
+        id_index[pos] = i;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrderMark;
+    header.space_name = addString(space_name);
+    header.atom_count = atom_count;
+    header.outgoing_count = outgoing.size();
+    header.id_index_capacity = capacity;
+    header.metadata_count = metadata.size();
+    header.strings_size = strings.size();
+
+    uint64_t offset = alignUp(sizeof(Header));
+    auto place = [&offset](uint64_t& field, uint64_t bytes) {
+        field = offset;
+        offset = alignUp(offset + bytes);
+    };
+    place(header.atoms_offset, records.size() * sizeof(AtomRecord));
+    place(header.outgoing_offset, outgoing.size() * sizeof(uint32_t));
+    place(header.incoming_begin_offset, incoming_begin.size() * sizeof(uint32_t));
+    place(header.incoming_offset, incoming.size() * sizeof(uint32_t));
+    place(header.type_begin_offset, type_begin.size() * sizeof(uint32_t));
+    place(header.type_atoms_offset, type_atoms.size() * sizeof(uint32_t));
+    place(header.id_index_offset, id_index.size() * sizeof(uint32_t));
+    place(header.metadata_offset, metadata.size() * sizeof(MetadataRecord));
+    place(header.strings_offset, strings.size());
+    header.file_size = offset;
+
+    // Written beside the target, synced and renamed, so neither readers nor a
+    // crash ever see a partial file, and synced again so the rename sticks
+    std::string temp_path = path + ".tmp";
+    std::FILE* out = std::fopen(temp_path.c_str(), "wb");
+    if (!out) {
+        Utils::Logger::error("Cannot write snapshot file: " + temp_path);
+        return false;
+    }
+
+    uint64_t written = 0;
+    bool ok = true;
+    auto write = [&](uint64_t at, const void* data, uint64_t bytes) {
+        static const char padding[8] = {};
+        size_t gap = static_cast<size_t>(at - written);
+        ok = ok && std::fwrite(padding, 1, gap, out) == gap;
+        ok = ok && (bytes == 0 || std::fwrite(data, 1, bytes, out) == bytes);
+        written = at + bytes;
+    };
+    write(0, &header, sizeof(header));
+    write(header.atoms_offset, records.data(), records.size() * sizeof(AtomRecord));
+    write(header.outgoing_offset, outgoing.data(), outgoing.size() * sizeof(uint32_t));
+    write(header.incoming_begin_offset, incoming_begin.data(), incoming_begin.size() * sizeof(uint32_t));
+    write(header.incoming_offset, incoming.data(), incoming.size() * sizeof(uint32_t));
+    write(header.type_begin_offset, type_begin.data(), type_begin.size() * sizeof(uint32_t));
+    write(header.type_atoms_offset, type_atoms.data(), type_atoms.size() * sizeof(uint32_t));
+    write(header.id_index_offset, id_index.data(), id_index.size() * sizeof(uint32_t));
+    write(header.metadata_offset, metadata.data(), metadata.size() * sizeof(MetadataRecord));
+    write(header.strings_offset, strings.data(), strings.size());
+    write(header.file_size, nullptr, 0);
+
+    ok = ok && std::fflush(out) == 0 && syncFile(out);
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        Utils::Logger::error("Failed writing snapshot file: " + temp_path);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        Utils::Logger::error("Cannot move snapshot into place: " + path);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    if (!syncParentDirectory(path)) {
+        Utils::Logger::error("Cannot sync the directory of snapshot file: " + path);
+        return false;
+    }
+
+    return true;
+}
+
+// MappedSnapshot Implementation
+MappedSnapshot::~MappedSnapshot() {
+#ifdef SWARMCOG_HAVE_MMAP
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+std::shared_ptr<MappedSnapshot> MappedSnapshot::open(const std::string& path) {
+    std::shared_ptr<MappedSnapshot> snapshot(new MappedSnapshot());
+
+#ifdef SWARMCOG_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Utils::Logger::error("Cannot open snapshot file: " + path);
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* memory = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED) {
+            snapshot->data_ = static_cast<const char*>(memory);
+            snapshot->size_ = static_cast<size_t>(info.st_size);
+            snapshot->mapped_ = true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!snapshot->mapped_) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            Utils::Logger::error("Cannot open snapshot file: " + path);
+            return nullptr;
+        }
+        snapshot->buffer_.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(snapshot->buffer_.data(), static_cast<std::streamsize>(snapshot->buffer_.size()));
+        snapshot->data_ = snapshot->buffer_.data();
+        snapshot->size_ = snapshot->buffer_.size();
+    }
+
+    if (!snapshot->validate(path)) {
+        return nullptr;
+    }
+
+    return snapshot;
+}
+
+bool MappedSnapshot::validate(const std::string& path) {
+    if (size_ < sizeof(Header)) {
+        Utils::Logger::error("Snapshot file is truncated: " + path);
+        return false;
+    }
+
+    const Header* header = section<Header>(0);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->byte_order != kByteOrderMark) {
+        Utils::Logger::error("Not a snapshot file for this platform: " + path);
+        return false;
+    }
+    if (header->version != kVersion) {
+        Utils::Logger::error("Unsupported snapshot version " + std::to_string(header->version) + ": " + path);
+        return false;
+    }
+
+    // Every section must lie inside the file before anything is dereferenced
+    auto fits = [this](uint64_t offset, uint64_t count, uint64_t element) {
+        return offset <= size_ && count <= (size_ - offset) / element;
+    };
+    bool ok = header->file_size == size_ &&
+              header->atom_count < kNoAtom &&
+              (header->id_index_capacity & (header->id_index_capacity - 1)) == 0 &&
+              header->id_index_capacity > header->atom_count &&
+              fits(header->atoms_offset, header->atom_count, sizeof(AtomRecord)) &&
+              fits(header->outgoing_offset, header->outgoing_count, sizeof(uint32_t)) &&
+              fits(header->incoming_begin_offset, header->atom_count + 1, sizeof(uint32_t)) &&
+              fits(header->incoming_offset, header->outgoing_count, sizeof(uint32_t)) &&
+              fits(header->type_begin_offset, kTypeCount + 1, sizeof(uint32_t)) &&
+              fits(header->type_atoms_offset, header->atom_count, sizeof(uint32_t)) &&
+              fits(header->id_index_offset, header->id_index_capacity, sizeof(uint32_t)) &&
+              fits(header->metadata_offset, header->metadata_count, sizeof(MetadataRecord)) &&
+              fits(header->strings_offset, header->strings_size, 1);
+    if (!ok) {
+        Utils::Logger::error("Snapshot file is corrupt: " + path);
+        return false;
+    }
+
+    header_ = header;
+    return true;
+}
+
+const AtomRecord& MappedSnapshot::atom(uint32_t index) const {
+    return section<AtomRecord>(header_->atoms_offset)[index];
+}
+
+std::string_view MappedSnapshot::string(const StringRef& ref) const {
+    if (ref.offset > header_->strings_size || ref.length > header_->strings_size - ref.offset) {
+        return std::string_view();
+    }
+    return std::string_view(data_ + header_->strings_offset + ref.offset, ref.length);
+}
+
+uint32_t MappedSnapshot::findById(std::string_view id) const {
+    const uint32_t* index = section<uint32_t>(header_->id_index_offset);
+    uint64_t mask = header_->id_index_capacity - 1;
+
+    // A corrupt index may have no empty cell, so probe each cell at most once
+    uint64_t pos = hashString(id) & mask;
+    for (uint64_t probe = 0; probe <= mask && index[pos] != kNoAtom; ++probe, pos = (pos + 1) & mask) {
+        if (index[pos] < header_->atom_count && string(atom(index[pos]).id) == id) {
+            return index[pos];
+        }
+    }
+    return kNoAtom;
+}
+
+std::pair<const uint32_t*, size_t> MappedSnapshot::atomsOfType(AtomType type) const {
+    size_t t = static_cast<size_t>(type);
+    if (t >= kTypeCount) return {nullptr, 0};
+
+    const uint32_t* begin = section<uint32_t>(header_->type_begin_offset);
+    if (begin[t] > begin[t + 1] || begin[t + 1] > header_->atom_count) return {nullptr, 0};
+    return {section<uint32_t>(header_->type_atoms_offset) + begin[t], begin[t + 1] - begin[t]};
+}
+
+std::pair<const uint32_t*, size_t> MappedSnapshot::outgoing(uint32_t index) const {
+    const AtomRecord& record = atom(index);
+    if (record.outgoing_begin > header_->outgoing_count ||
+        record.outgoing_count > header_->outgoing_count - record.outgoing_begin) {
+        return {nullptr, 0};
+    }
+    return {section<uint32_t>(header_->outgoing_offset) + record.outgoing_begin, record.outgoing_count};
+}
+
+std::pair<const uint32_t*, size_t> MappedSnapshot::incoming(uint32_t index) const {
+    const uint32_t* begin = section<uint32_t>(header_->incoming_begin_offset);
+    if (begin[index] > begin[index + 1] || begin[index + 1] > header_->outgoing_count) return {nullptr, 0};
+    return {section<uint32_t>(header_->incoming_offset) + begin[index], begin[index + 1] - begin[index]};
+}
+
+std::pair<const MetadataRecord*, size_t> MappedSnapshot::metadata(uint32_t index) const {
+    const AtomRecord& record = atom(index);
+    if (record.metadata_begin > header_->metadata_count ||
+        record.metadata_count > header_->metadata_count - record.metadata_begin) {
+        return {nullptr, 0};
+    }
+    return {section<MetadataRecord>(header_->metadata_offset) + record.metadata_begin, record.metadata_count};
+}
+
+MetadataValue MappedSnapshot::metadataValue(const MetadataRecord& record) const {
+    switch (record.kind) {
+        case MetadataKind::NUMBER: {
+            double number;
+            std::memcpy(&number, &record.scalar, sizeof(double));
+            return number;
+        }
+        case MetadataKind::INTEGER:
+            return record.scalar;
+        case MetadataKind::TIMESTAMP:
+            return Timestamp(Timestamp::duration(record.scalar));
+        case MetadataKind::STRING:
+        default:
+            return std::string(string(record.text));
+    }
+}
+
+} // namespace SwarmCog
\ No newline at end of file
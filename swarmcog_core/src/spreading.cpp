@@ -0,0 +1,283 @@
+#include "swarmcog/spreading.h"
+#include "swarmcog/utils.h"
+
+namespace SwarmCog {
+
+// AttentionSpreader Implementation
+AttentionSpreader::AttentionSpreader(std::shared_ptr<AgentSpace> space, const SpreadingConfig& config)
+    : space_(std::move(space)), config_(config), spec_(config.link_types, false) {
+    config_.diffusion_rate = std::clamp(config_.diffusion_rate, 0.0, 1.0);
+    config_.rent = std::max(config_.rent, 0.0);
+    if (config_.max_active == 0) {
+        config_.max_active = 1;
+    }
+}
+
+AttentionSpreader::~AttentionSpreader() {
+    stop();
+}
+
+void AttentionSpreader::start() {
+    if (worker_.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread(&AttentionSpreader::run, this);
+
+    Utils::Logger::info("Started spreading activation for AgentSpace: " + space_->getName());
+}
+
+void AttentionSpreader::stop() {
+    if (!worker_.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stopping_ = true;
+    }
+    worker_cv_.notify_one();
+    worker_.join();
+}
+
+void AttentionSpreader::run() {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+
+    while (!worker_cv_.wait_for(lock, config_.interval, [this] { return stopping_; })) {
+        lock.unlock();
+        step();
+        if (config_.slice_size) {
+            sweepSlice();
+        }
+        lock.lock();
+    }
+}
+
+double AttentionSpreader::outflow(double sti, size_t degree) const {
+    if (degree == 0 || sti <= config_.diffusion_threshold) return 0.0;
+    return config_.diffusion_rate * sti;
+}
+
+double AttentionSpreader::rentFor(double sti, double sent) const {
+    // Rent never pushes a spreading atom below zero
+    return std::min(config_.rent, std::max(sti - sent, 0.0));
+}
+
+bool AttentionSpreader::stimulate(AtomHandle handle, double stimulus) {
+    if (!space_->getAtom(handle)) return false;
+
+    space_->addSti({{handle, config_.wage * stimulus}});
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.insert(handle);
+    }
+
+    ++stimuli_;
+    return true;
+}
+
+size_t AttentionSpreader::step() {
+    std::lock_guard<std::mutex> lock(step_mutex_);
+
+    std::vector<AtomHandle> active;
+    {
+        std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+        active.assign(pending_.begin(), pending_.end());
+        pending_.clear();
+    }
+    ++stats_.steps;
+    if (active.empty()) {
+        std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+        recent_.clear();
+        return 0;
+    }
+
+    // Removed atoms drop out; stored ones stay active even with no edges
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [&](AtomHandle handle) { return !space_->getAtom(handle); }),
+                 active.end());
+    std::vector<double> sti = space_->loadSti(active);
+
+    // Over budget: the hottest atoms spread now, the rest stay pending
+    if (active.size() > config_.max_active) {
+        std::vector<size_t> order(active.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::nth_element(order.begin(), order.begin() + config_.max_active, order.end(),
+                         [&](size_t a, size_t b) { return sti[a] > sti[b]; });
+
+        std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+        for (size_t i = config_.max_active; i < order.size(); ++i) {
+            pending_.insert(active[order[i]]);
+        }
+
+        std::vector<AtomHandle> kept;
+        std::vector<double> kept_sti;
+        for (size_t i = 0; i < config_.max_active; ++i) {
+            kept.push_back(active[order[i]]);
+            kept_sti.push_back(sti[order[i]]);
+        }
+        active.swap(kept);
+        sti.swap(kept_sti);
+    }
+
+    // One column of the sparse product per active atom
+    std::unordered_map<AtomHandle, double> deltas;
+    std::unordered_map<AtomHandle, double> gains;
+    size_t spread = 0;
+    for (size_t i = 0; i < active.size(); ++i) {
+        std::vector<AtomHandle> neighbors = neighborsOf(active[i]);
+        double sent = outflow(sti[i], neighbors.size());
+        if (sent <= 0.0) continue;
+
+        double share = sent / neighbors.size();
+        deltas[active[i]] -= sent + rentFor(sti[i], sent);
+        for (AtomHandle neighbor : neighbors) {
+            deltas[neighbor] += share;
+            gains[neighbor] += share;
+        }
+        ++spread;
+    }
+
+    space_->addSti(std::vector<std::pair<AtomHandle, double>>(deltas.begin(), deltas.end()));
+
+    // Atoms that gained enough carry the wave on in the next step
+    {
+        std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+        recent_ = active;
+        for (const auto& gain : gains) {
+            if (gain.second >= config_.min_activation) {
+                pending_.insert(gain.first);
+            }
+        }
+    }
+
+    stats_.spread += spread;
+    return spread;
+}
+
+std::vector<AtomHandle> AttentionSpreader::neighborsOf(AtomHandle handle) const {
+    // A link repeating the atom is listed once per position; take it once
+    std::vector<AtomPtr> links;
+    space_->forEachIncoming(handle, [&](const AtomPtr& link) {
+        if (std::find(spec_.link_types.begin(), spec_.link_types.end(), link->getType()) != spec_.link_types.end()) {
+            links.push_back(link);
+        }
+    });
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    // The same edges as the adjacency graph: each link joins its first
+    // target to every other one
+    std::vector<AtomHandle> neighbors;
+    for (const auto& link : links) {
+        const auto& outgoing = static_cast<const Link&>(*link).getOutgoing();
+        AtomHandle source = !outgoing.empty() && outgoing[0] ? outgoing[0]->getHandle() : AtomHandle();
+        if (!source.isValid()) continue;
+
+        for (size_t i = 1; i < outgoing.size(); ++i) {
+            AtomHandle target = outgoing[i] ? outgoing[i]->getHandle() : AtomHandle();
+            if (!target.isValid() || target == source) continue;
+            if (source == handle) {
+                neighbors.push_back(target);
+            } else if (target == handle) {
+                neighbors.push_back(source);
+            }
+        }
+    }
+    return neighbors;
+}
+
+bool AttentionSpreader::sweepSlice() {
+    std::lock_guard<std::mutex> lock(step_mutex_);
+
+    if (!sweep_graph_) {
+        sweep_graph_ = space_->getGraph(spec_);
+        uint32_t vertex_count = static_cast<uint32_t>(sweep_graph_->getVertexCount());
+
+        std::vector<AtomHandle> handles(vertex_count);
+        for (uint32_t v = 0; v < vertex_count; ++v) {
+            handles[v] = sweep_graph_->handleOf(v);
+        }
+        sweep_sti_ = space_->loadSti(handles);
+
+        sweep_shares_.assign(vertex_count, 0.0);
+        for (uint32_t v = 0; v < vertex_count; ++v) {
+            size_t degree = sweep_graph_->getDegree(v);
+            double sent = outflow(sweep_sti_[v], degree);
+            if (sent > 0.0) sweep_shares_[v] = sent / degree;
+        }
+        sweep_cursor_ = 0;
+    }
+
+    uint32_t vertex_count = static_cast<uint32_t>(sweep_graph_->getVertexCount());
+    size_t slice = config_.slice_size ? config_.slice_size : vertex_count;
+    uint32_t begin = sweep_cursor_;
+    uint32_t end = static_cast<uint32_t>(std::min<size_t>(vertex_count, begin + slice));
+
+    // Received minus sent is the product's entry for each atom in the slice
+    std::vector<double> received = sweep_graph_->sumNeighbors(sweep_shares_, begin, end);
+    std::vector<std::pair<AtomHandle, double>> deltas;
+    for (uint32_t v = begin; v < end; ++v) {
+        double sent = sweep_shares_[v] * sweep_graph_->getDegree(v);
+        double delta = received[v - begin] - sent;
+        if (sent > 0.0) {
+            delta -= rentFor(sweep_sti_[v], sent);
+            ++stats_.spread;
+        }
+        if (delta != 0.0) {
+            deltas.emplace_back(sweep_graph_->handleOf(v), delta);
+        }
+    }
+    space_->addSti(deltas);
+
+    sweep_cursor_ = end;
+    if (end < vertex_count) return false;
+
+    sweep_graph_.reset();
+    sweep_shares_.clear();
+    sweep_sti_.clear();
+    ++stats_.sweeps;
+    return true;
+}
+
+void AttentionSpreader::runSweep() {
+    while (!sweepSlice()) {
+    }
+}
+
+std::vector<AtomHandle> AttentionSpreader::getActiveAtoms(size_t limit) const {
+    std::unordered_set<AtomHandle> seen;
+    {
+        std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+        seen.insert(pending_.begin(), pending_.end());
+        seen.insert(recent_.begin(), recent_.end());
+    }
+
+    std::vector<AtomHandle> active;
+    for (AtomHandle handle : seen) {
+        if (space_->getAtom(handle)) active.push_back(handle);
+    }
+
+    std::vector<double> sti = space_->loadSti(active);
+    std::vector<size_t> order(active.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    size_t count = std::min(limit, order.size());
+    std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                      [&](size_t a, size_t b) { return sti[a] > sti[b]; });
+
+    std::vector<AtomHandle> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(active[order[i]]);
+    }
+    return result;
+}
+
+SpreadingStats AttentionSpreader::getStats() const {
+    std::lock_guard<std::mutex> lock(step_mutex_);
+    SpreadingStats stats = stats_;
+    stats.stimuli = stimuli_.load();
+    return stats;
+}
+
+} // namespace SwarmCog
\ No newline at end of file
@@ -17,8 +17,11 @@ void SwarmCog::initialize() {
     Utils::Logger::info("Initializing SwarmCog system: " + config_.agentspace_name);
     
     // Initialize core components
-    agentspace_ = std::make_shared<AgentSpace>(config_.agentspace_name);
+    agentspace_ = std::make_shared<AgentSpace>(config_.agentspace_name, config_.agentspace_config);
     microkernel_ = std::make_shared<CognitiveMicrokernel>(agentspace_, config_.processing_mode);
+    forgetter_ = std::make_unique<Forgetter>(agentspace_, config_.forgetting);
+    spreader_ = std::make_shared<AttentionSpreader>(agentspace_, config_.spreading);
+    microkernel_->setAttentionSpreader(spreader_);
     
     // Initialize system status
     system_status_.start_time = Utils::TimeUtils::now();
@@ -40,6 +43,7 @@ void SwarmCog::shutdown() {
     {
         std::unique_lock<std::shared_mutex> lock(agents_mutex_);
         cognitive_agents_.clear();
+        agents_by_node_.clear();
     }
     
     Utils::Logger::info("SwarmCog system shut down");
@@ -96,6 +100,9 @@ std::shared_ptr<CognitiveAgent> SwarmCog::createCognitiveAgent(
         }
         
         cognitive_agents_[id] = agent;
+        if (auto node = agent->getAgentNode()) {
+            agents_by_node_[node->getHandle()] = id;
+        }
         system_status_.active_agents = cognitive_agents_.size();
         
         Utils::Logger::info("Created cognitive agent: " + id);
@@ -126,6 +133,9 @@ bool SwarmCog::removeAgent(const AgentId& agent_id) {
         microkernel_->removeCognitiveAgent(agent_id);
     }
     
+    if (auto node = agent->getAgentNode()) {
+        agents_by_node_.erase(node->getHandle());
+    }
     cognitive_agents_.erase(it);
     system_status_.active_agents = cognitive_agents_.size();
     
@@ -269,6 +279,13 @@ void SwarmCog::startAutonomousProcessing() {
     // Start autonomous thread
     autonomous_thread_ = std::thread(&SwarmCog::autonomousProcessingLoop, this);
     
+    if (forgetter_ && config_.forgetting.enabled) {
+        forgetter_->start();
+    }
+    if (spreader_ && config_.spreading.enabled) {
+        spreader_->start();
+    }
+    
     Utils::Logger::info("Started autonomous processing");
 }
 
@@ -289,6 +306,13 @@ void SwarmCog::stopAutonomousProcessing() {
         autonomous_thread_.join();
     }
     
+    if (forgetter_) {
+        forgetter_->stop();
+    }
+    if (spreader_) {
+        spreader_->stop();
+    }
+    
     Utils::Logger::info("Stopped autonomous processing");
 }
 
@@ -296,16 +320,50 @@ std::vector<AgentId> SwarmCog::findAgentsByCapability(const std::string& capabil
     std::shared_lock<std::shared_mutex> lock(agents_mutex_);
     
     std::vector<AgentId> matching_agents;
-    
-    for (const auto& pair : cognitive_agents_) {
-        if (pair.second->hasCapability(capability)) {
-            matching_agents.push_back(pair.first);
+    if (!agentspace_) return matching_agents;
+    
+    // Agents mirror their capabilities into their nodes, so the registry
+    // answers without visiting every agent
+    for (AtomHandle handle : agentspace_->getCapabilityRegistry().agentsWithAll({capability})) {
+        auto it = agents_by_node_.find(handle);
+        if (it != agents_by_node_.end()) {
+            matching_agents.push_back(it->second);
         }
     }
     
     return matching_agents;
 }
 
+std::vector<AgentId> SwarmCog::getConnectedAgents(const AgentId& agent_id) const {
+    std::shared_lock<std::shared_mutex> lock(agents_mutex_);
+
+    std::vector<AgentId> connected;
+    auto it = cognitive_agents_.find(agent_id);
+    if (!agentspace_ || it == cognitive_agents_.end()) return connected;
+
+    auto node = it->second->getAgentNode();
+    if (!node) return connected;
+
+    // Agents reachable over any chain of collaboration or trust links
+    auto graph = agentspace_->getGraph(GraphSpec({AtomType::COLLABORATION_LINK, AtomType::TRUST_LINK}));
+    auto hops = graph->distances({node->getHandle()});
+    for (const auto& pair : agents_by_node_) {
+        uint32_t slot = pair.first.slot();
+        if (pair.second != agent_id && graph->contains(pair.first) &&
+            hops[slot] != AdjacencyGraph::kUnreachable) {
+            connected.push_back(pair.second);
+        }
+    }
+
+    std::sort(connected.begin(), connected.end());
+    return connected;
+}
+
+bool SwarmCog::stimulateAtom(const AtomId& atom_id, double stimulus) {
+    if (!agentspace_ || !spreader_) return false;
+    return spreader_->stimulate(agentspace_->getHandle(atom_id), stimulus);
+}
+
 void SwarmCog::shareKnowledgeGlobally(const std::string& knowledge_type, 
                                      const std::string& content,
                                      const AgentId& source_agent) {
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <ctime>
 #include <numeric>
 #include <regex>
 
@@ -11,20 +12,28 @@ namespace SwarmCog {
 namespace Utils {
 
 // UUIDGenerator implementation
-std::random_device UUIDGenerator::rd_;
-std::mt19937 UUIDGenerator::gen_(rd_());
-std::uniform_int_distribution<> UUIDGenerator::dis_(0, 15);
+std::mt19937& UUIDGenerator::engine() {
+    thread_local std::mt19937 gen = [] {
+        std::random_device rd;
+        std::seed_seq seed{rd(), rd(), rd(), rd()};
+        return std::mt19937(seed);
+    }();
+    return gen;
+}
 
 std::string UUIDGenerator::generate() {
     std::stringstream ss;
     ss << std::hex;
     
+    std::mt19937& gen = engine();
+    std::uniform_int_distribution<> dis(0, 15);
+    
     // Generate 32 hex digits
     for (int i = 0; i < 32; ++i) {
         if (i == 8 || i == 12 || i == 16 || i == 20) {
             ss << '-';
         }
-        ss << dis_(gen_);
+        ss << dis(gen);
     }
     
     return ss.str();
@@ -34,8 +43,10 @@ std::string UUIDGenerator::generateShort(size_t length) {
     std::stringstream ss;
     ss << std::hex;
     
+    std::mt19937& gen = engine();
+    std::uniform_int_distribution<> dis(0, 15);
     for (size_t i = 0; i < length; ++i) {
-        ss << dis_(gen_);
+        ss << dis(gen);
     }
     
     return ss.str();
@@ -48,8 +59,12 @@ std::string TimeUtils::timestampToString(const Timestamp& timestamp) {
         timestamp.time_since_epoch()
     ) % 1000;
     
+    // localtime() shares a static buffer between threads
+    std::tm local_tm{};
+    localtime_r(&time_t, &local_tm);
+    
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S");
     ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
     
     return ss.str();
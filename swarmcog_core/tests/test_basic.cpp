@@ -1,7 +1,14 @@
 #include "swarmcog/swarmcog.h"
 #include "swarmcog/utils.h"
+#include "swarmcog/snapshot_file.h"
 #include <iostream>
 #include <cassert>
+#include <thread>
+#include <random>
+#include <cstdio>
+#include <fstream>
+#include <cmath>
+#include <tuple>
 
 using namespace SwarmCog;
 
@@ -24,6 +31,2075 @@ void testAgentSpaceBasics() {
     std::cout << "AgentSpace test passed!" << std::endl;
 }
 
+void testAtomHandles() {
+    std::cout << "Testing AgentSpace atom handles..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("handle_test_space");
+    
+    auto node = agentspace->addCapabilityNode("planning", "Planning capability");
+    AtomHandle handle = node->getHandle();
+    assert(handle.isValid());
+    assert(agentspace->getAtom(handle) == node);
+    assert(agentspace->getAtom(node->getId()) == node);
+    assert(agentspace->getHandle(node->getId()) == handle);
+    
+    // Removal invalidates the handle and the string alias
+    assert(agentspace->removeAtom(handle));
+    assert(!node->getHandle().isValid());
+    assert(agentspace->getAtom(handle) == nullptr);
+    assert(agentspace->getAtom(node->getId()) == nullptr);
+    assert(!agentspace->removeAtom(handle));
+    
+    // A recycled slot gets a new generation, so the stale handle stays dead
+    auto replacement = agentspace->addCapabilityNode("reasoning");
+    assert(replacement->getHandle().slot() == handle.slot());
+    assert(replacement->getHandle() != handle);
+    assert(agentspace->getAtom(handle) == nullptr);
+    assert(agentspace->getAtomCount() == 1);
+    
+    // An atom belongs to one space at a time; once removed it may move
+    auto other = std::make_shared<AgentSpace>("other_handle_space");
+    assert(other->addAtom(replacement) == nullptr);
+    assert(other->getAtomCount() == 0 && agentspace->getAtom(replacement->getId()) == replacement);
+    assert(agentspace->addAtom(replacement) == replacement && agentspace->getAtomCount() == 1);
+    assert(agentspace->removeAtom(replacement->getHandle()));
+    assert(other->addAtom(replacement) == replacement);
+    assert(other->getAtom(replacement->getId()) == replacement);
+    
+    // Ids are generated on first use and stable from then on
+    auto fresh = agentspace->createNode(AtomType::BELIEF_NODE, "fresh");
+    const AtomId& id = fresh->getId();
+    assert(!id.empty() && fresh->getId() == id);
+    
+    std::cout << "Atom handle test passed!" << std::endl;
+}
+
+void testAtomArena() {
+    std::cout << "Testing AgentSpace atom arena..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("arena_test_space");
+    
+    for (int i = 0; i < 100; ++i) {
+        agentspace->addBeliefNode("belief_" + std::to_string(i), "value");
+    }
+    auto stats = agentspace->getStatistics();
+    assert(stats["arena_live_blocks"] == 100);
+    size_t reserved = stats["arena_reserved_bytes"];
+    assert(reserved > 0);
+    
+    // Freed blocks are recycled instead of growing the arena
+    for (const auto& atom : agentspace->getAtomsByType(AtomType::BELIEF_NODE)) {
+        agentspace->removeAtom(atom->getHandle());
+    }
+    assert(agentspace->getStatistics()["arena_live_blocks"] == 0);
+    for (int i = 0; i < 100; ++i) {
+        agentspace->addBeliefNode("belief_" + std::to_string(i), "value");
+    }
+    stats = agentspace->getStatistics();
+    assert(stats["arena_live_blocks"] == 100);
+    assert(stats["arena_reserved_bytes"] == reserved);
+    
+    // Blocks freed on another thread are reused, not stranded in its stripe
+    AtomArenaConfig striped_config;
+    striped_config.stripes = 64;
+    striped_config.slab_size = 4096;
+    AtomArena striped(striped_config);
+    std::vector<void*> blocks;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 640; ++i) {
+            blocks.push_back(striped.allocate(64, alignof(std::max_align_t)));
+        }
+        std::thread([&] {
+            for (void* block : blocks) {
+                striped.deallocate(block, 64, alignof(std::max_align_t));
+            }
+        }).join();
+        blocks.clear();
+    }
+    assert(striped.getSlabCount() == 10);
+    assert(striped.getLiveBlocks() == 0);
+    
+    // Atoms stay valid after the space is cleared
+    auto survivor = agentspace->addGoalNode("survive");
+    agentspace->clear();
+    assert(agentspace->getStatistics()["arena_live_blocks"] == 0);
+    assert(survivor->getName() == "survive");
+    
+    std::cout << "Atom arena test passed!" << std::endl;
+}
+
+void testIncomingSets() {
+    std::cout << "Testing AgentSpace incoming sets..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("incoming_test_space");
+    auto alice = agentspace->addAgentNode("alice");
+    auto bob = agentspace->addAgentNode("bob");
+    auto carol = agentspace->addAgentNode("carol");
+    
+    auto ab = agentspace->addCollaborationLink(alice->getId(), bob->getId());
+    agentspace->addCollaborationLink(alice->getId(), carol->getId());
+    agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.9);
+    
+    assert(agentspace->getIncomingCount(alice->getHandle()) == 3);
+    assert(agentspace->getIncoming(alice->getHandle(), AtomType::COLLABORATION_LINK).size() == 2);
+    assert(agentspace->getIncoming(bob->getHandle(), AtomType::TRUST_LINK).size() == 1);
+    assert(agentspace->getCollaborators(alice->getId()).size() == 2);
+    assert(agentspace->getTrustLevel(bob->getId(), alice->getId()) > 0.89);
+    assert(agentspace->getTrustLevel(carol->getId(), alice->getId()) == 0.0);
+    
+    // Removing a link drops it from its targets' incoming sets
+    agentspace->removeAtom(ab->getHandle());
+    assert(agentspace->getCollaborators(alice->getId()).size() == 1);
+    assert(agentspace->getCollaborators(bob->getId()).empty());
+    assert(agentspace->getIncomingCount(bob->getHandle()) == 1);
+    
+    std::cout << "Incoming set test passed!" << std::endl;
+}
+
+void testTrustIndex() {
+    std::cout << "Testing AgentSpace trust index..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("trust_test_space");
+    auto alice = agentspace->addAgentNode("alice");
+    auto bob = agentspace->addAgentNode("bob");
+    auto carol = agentspace->addAgentNode("carol");
+    
+    auto first = agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.4);
+    assert(agentspace->getTrustLink(bob->getHandle(), alice->getHandle()) == first);
+    
+    // Truth-value updates on the link are visible without re-indexing
+    first->setTruthValue(TruthValue(0.7, 0.6));
+    assert(std::abs(agentspace->getTrustLevel(alice->getHandle(), bob->getHandle()) - 0.7) < 1e-6);
+    
+    // The newest link wins; removing it falls back to the older one
+    auto second = agentspace->addTrustRelationship(bob->getId(), alice->getId(), 0.2);
+    assert(agentspace->getTrustLink(alice->getHandle(), bob->getHandle()) == second);
+    agentspace->removeAtom(second->getHandle());
+    assert(agentspace->getTrustLink(alice->getHandle(), bob->getHandle()) == first);
+    
+    // Removing an agent drops its pairs, even once its slot is recycled
+    agentspace->addTrustRelationship(alice->getId(), carol->getId(), 0.8);
+    AtomHandle carol_handle = carol->getHandle();
+    agentspace->removeAtom(carol_handle);
+    assert(agentspace->getTrustLevel(alice->getHandle(), carol_handle) == 0.0);
+    auto dave = agentspace->addAgentNode("dave");
+    assert(dave->getHandle().slot() == carol_handle.slot());
+    assert(agentspace->getTrustLevel(alice->getId(), dave->getId()) == 0.0);
+    
+    std::cout << "Trust index test passed!" << std::endl;
+}
+
+void testShardedAgentSpace() {
+    std::cout << "Testing sharded AgentSpace..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 8;
+    auto agentspace = std::make_shared<AgentSpace>("sharded_space", config);
+    
+    auto hub = agentspace->addAgentNode("hub");
+    
+    // Concurrent writers each build their own agents and link them to the hub
+    const int num_threads = 4;
+    const int per_thread = 100;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                auto agent = agentspace->addAgentNode("worker_" + std::to_string(t) + "_" + std::to_string(i));
+                agentspace->addCollaborationLink(hub->getId(), agent->getId());
+                assert(agentspace->getAtom(agent->getId()) == agent);
+                if (i % 10 == 0) {
+                    agentspace->removeAtom(agent->getHandle());
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Every link survives in the hub's incoming set even when its agent was removed
+    size_t survivors = num_threads * (per_thread - per_thread / 10);
+    assert(agentspace->getAtomsByType(AtomType::AGENT_NODE).size() == survivors + 1);
+    assert(agentspace->getAtomsByType(AtomType::COLLABORATION_LINK).size() == num_threads * per_thread);
+    assert(agentspace->getCollaborators(hub->getId()).size() == num_threads * per_thread);
+    assert(agentspace->getIncomingCount(hub->getHandle()) == num_threads * per_thread);
+    
+    auto stats = agentspace->getStatistics();
+    assert(stats["shard_count"] == 8);
+    assert(stats["total_atoms"] == agentspace->getAtomCount());
+    assert(agentspace->getAtomsByName("worker_0_1").size() == 1);
+    
+    agentspace->clear();
+    assert(agentspace->getAtomCount() == 0);
+    assert(!hub->getHandle().isValid());
+    
+    std::cout << "Sharded AgentSpace test passed!" << std::endl;
+}
+
+void testConcurrentWriters() {
+    std::cout << "Testing concurrent writers..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 8;
+    config.arena.stripes = 4;
+    auto agentspace = std::make_shared<AgentSpace>("writers_space", config);
+    auto hub = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "hub"));
+    agentspace->getGraph(GraphSpec({AtomType::KNOWLEDGE_LINK}));  // cached, so inserts are journaled
+    
+    // Writers insert nodes, links and trust pairs side by side, while one
+    // of them removes atoms and a reader takes snapshots and graphs
+    const int num_threads = 8;
+    const int per_thread = 200;
+    std::vector<std::vector<AtomPtr>> agents(num_threads);
+    std::atomic<bool> writing{true};
+    std::thread reader([&]() {
+        while (writing) {
+            // A snapshot never catches a link stored but not yet in its target's incoming set
+            auto view = agentspace->snapshot();
+            assert(view->getIncoming(hub->getHandle()).size() == view->getAtomsByType(AtomType::KNOWLEDGE_LINK).size());
+            agentspace->getGraph(GraphSpec({AtomType::KNOWLEDGE_LINK}));
+        }
+    });
+    std::vector<std::thread> writers;
+    for (int t = 0; t < num_threads; ++t) {
+        writers.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                auto agent = agentspace->addAtom(agentspace->createNode(
+                    AtomType::AGENT_NODE, "writer_" + std::to_string(t) + "_" + std::to_string(i)));
+                agentspace->addAtom(agentspace->createLink(AtomType::KNOWLEDGE_LINK, {agent, hub}));
+                if (i > 0) {
+                    agentspace->addAtom(createTrustLink(agents[t].back(), agent, 0.7));
+                }
+                agents[t].push_back(agent);
+                if (t == 0 && i % 10 == 9) {
+                    agentspace->removeAtom(agent->getHandle());
+                }
+                if (t == 1) {
+                    // Unlinked nodes are removed without stalling link inserts
+                    auto scratch = agentspace->addBeliefNode("scratch_" + std::to_string(i));
+                    assert(agentspace->removeAtom(scratch->getHandle()));
+                }
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    writing = false;
+    reader.join();
+    
+    // Every index agrees with what was written
+    std::unordered_set<AtomId> ids;
+    for (const auto& thread_agents : agents) {
+        for (const auto& agent : thread_agents) {
+            assert(ids.insert(agent->getId()).second);
+        }
+    }
+    size_t removed = per_thread / 10;
+    assert(agentspace->getAtomsByType(AtomType::AGENT_NODE).size() == num_threads * per_thread - removed);
+    assert(agentspace->getAtomsByType(AtomType::BELIEF_NODE).empty());
+    assert(agentspace->getIncomingCount(hub->getHandle()) == num_threads * per_thread);
+    auto graph = agentspace->getGraph(GraphSpec({AtomType::KNOWLEDGE_LINK}));
+    assert(graph->getDegree(hub->getHandle().slot()) == num_threads * per_thread - removed);
+    for (int t = 1; t < num_threads; ++t) {
+        for (int i = 1; i < per_thread; ++i) {
+            assert(agentspace->getTrustLevel(agents[t][i - 1]->getHandle(), agents[t][i]->getHandle()) == 0.7);
+        }
+    }
+    assert(agentspace->getTrustLink(agents[0][8]->getHandle(), agents[0][9]->getHandle()) == nullptr);
+    assert(agentspace->getStatistics()["arena_live_blocks"] > 0);
+    
+    std::cout << "Concurrent writers test passed!" << std::endl;
+}
+
+void testAttentionColumns() {
+    std::cout << "Testing columnar attention values..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("attention_test_space");
+    auto node = agentspace->createNode(AtomType::BELIEF_NODE, "focus");
+    node->setAttentionValue(AttentionValue(1.0, 0.5, 0.2));
+    agentspace->addAtom(node);
+    
+    // Values set before insertion move into the columns
+    assert(node->getAttentionValue().sti == 1.0);
+    
+    agentspace->updateAttentionValues();
+    auto av = node->getAttentionValue();
+    double expected_lti = 0.5 * 0.999 + 0.99 * 0.001;
+    assert(std::abs(av.sti - 0.99) < 1e-12);
+    assert(std::abs(av.lti - expected_lti) < 1e-12);
+    assert(std::abs(av.vlti - (0.2 * 0.9999 + expected_lti * 0.0001)) < 1e-12);
+    
+    // Setters write through to the columns
+    node->setAttentionValue(AttentionValue(0.9, 0.0, 0.0));
+    assert(agentspace->getMostImportantAtoms(1)[0] == node);
+    
+    // Removed atoms keep their last value and no longer decay
+    agentspace->removeAtom(node->getHandle());
+    agentspace->updateAttentionValues();
+    assert(node->getAttentionValue().sti == 0.9);
+    
+    // Atoms outliving their space keep their values as well
+    auto survivor = agentspace->addAgentNode("survivor");
+    survivor->setAttentionValue(AttentionValue(0.3, 0.0, 0.0));
+    agentspace.reset();
+    assert(survivor->getAttentionValue().sti == 0.3);
+    
+    std::cout << "Columnar attention test passed!" << std::endl;
+}
+
+void testImportanceIndex() {
+    std::cout << "Testing importance index..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("importance_test_space", config);
+    
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<AtomPtr> atoms;
+    for (int i = 0; i < 2000; ++i) {
+        auto node = agentspace->createNode(AtomType::BELIEF_NODE, "belief_" + std::to_string(i));
+        node->setAttentionValue(AttentionValue(dist(rng), dist(rng), std::abs(dist(rng))));
+        atoms.push_back(agentspace->addAtom(node));
+    }
+    
+    auto importance = [](const AtomPtr& atom) {
+        auto av = atom->getAttentionValue();
+        return av.sti + av.lti + av.vlti;
+    };
+    
+    // Top-K must match a full sort after updates, decay and removals
+    auto check = [&]() {
+        auto expected = agentspace->getAtoms();
+        std::sort(expected.begin(), expected.end(), [&](const AtomPtr& a, const AtomPtr& b) {
+            return importance(a) > importance(b);
+        });
+        auto top = agentspace->getMostImportantAtoms(25);
+        assert(top.size() == 25);
+        for (size_t i = 0; i < top.size(); ++i) {
+            assert(importance(top[i]) == importance(expected[i]));
+        }
+    };
+    
+    check();
+    atoms[7]->setAttentionValue(AttentionValue(1.0, 1.0, 1.0));
+    assert(agentspace->getMostImportantAtoms(1)[0] == atoms[7]);
+    for (int i = 0; i < 50; ++i) {
+        agentspace->updateAttentionValues();
+    }
+    check();
+    for (size_t i = 0; i < atoms.size(); i += 3) {
+        agentspace->removeAtom(atoms[i]->getHandle());
+    }
+    check();
+    assert(agentspace->getMostImportantAtoms(100000).size() == agentspace->getAtomCount());
+    
+    // Atoms sharing one value (every new memory node does) still yield
+    // exactly K entries, behind anything more important
+    auto tied = std::make_shared<AgentSpace>("tied_importance_space");
+    for (int i = 0; i < 3000; ++i) {
+        tied->addMemoryNode("memory " + std::to_string(i));
+    }
+    auto star = tied->addBeliefNode("star");
+    star->setAttentionValue(AttentionValue(1.0, 1.0, 1.0));
+    auto tied_top = tied->getMostImportantAtoms(5);
+    assert(tied_top.size() == 5 && tied_top[0] == star);
+    for (size_t i = 1; i < tied_top.size(); ++i) {
+        assert(tied_top[i]->getType() == AtomType::MEMORY_NODE && importance(tied_top[i]) == 0.8);
+    }
+    
+    std::cout << "Importance index test passed!" << std::endl;
+}
+
+void testHashConsing() {
+    std::cout << "Testing hash-consed atoms..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.hash_consing = true;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("consing_test_space", config);
+    
+    // Equal nodes collapse into one atom whose truth value is revised
+    auto goal = agentspace->addGoalNode("explore", 0.2);
+    auto again = agentspace->addGoalNode("explore", 0.6);
+    assert(goal == again);
+    assert(agentspace->getAtomsByType(AtomType::GOAL_NODE).size() == 1);
+    assert(std::abs(goal->getTruthValue().strength - 0.4) < 1e-9);
+    assert(goal->getTruthValue().confidence > 0.8);
+    
+    // Value is part of a node's identity
+    auto belief = agentspace->addBeliefNode("weather", "sunny");
+    assert(agentspace->addBeliefNode("weather", "rainy") != belief);
+    assert(agentspace->addBeliefNode("weather", "sunny") == belief);
+    
+    // Links are keyed by type and ordered outgoing set
+    auto alice = agentspace->addAgentNode("alice");
+    auto bob = agentspace->addAgentNode("bob");
+    auto trust = agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.9);
+    assert(agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.5) == trust);
+    assert(agentspace->addTrustRelationship(bob->getId(), alice->getId(), 0.5) != trust);
+    assert(agentspace->getIncomingCount(alice->getHandle()) == 2);
+    assert(std::abs(trust->getTruthValue().strength - 0.7) < 1e-9);
+    assert(std::get<double>(*trust->getMetadataValue(MetaKey::TRUST_LEVEL)) == trust->getTruthValue().strength);
+    
+    // Removed atoms leave the content index
+    agentspace->removeAtom(goal->getHandle());
+    auto fresh = agentspace->addGoalNode("explore", 0.2);
+    assert(fresh != goal);
+    assert(agentspace->getAtom(fresh->getHandle()) == fresh);
+    
+    // Without hash-consing duplicates are kept as before
+    auto plain = std::make_shared<AgentSpace>("plain_space");
+    assert(plain->addGoalNode("explore") != plain->addGoalNode("explore"));
+    
+    std::cout << "Hash-consing test passed!" << std::endl;
+}
+
+void testSnapshots() {
+    std::cout << "Testing AgentSpace snapshots..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("snapshot_test_space", config);
+    
+    auto alice = agentspace->addAgentNode("alice");
+    auto bob = agentspace->addAgentNode("bob");
+    auto link = agentspace->addCollaborationLink(alice->getId(), bob->getId());
+    
+    auto before = agentspace->snapshot();
+    assert(before->getAtomCount() == 3);
+    assert(agentspace->snapshot()->getVersion() == before->getVersion());
+    
+    // Later changes do not show through a pinned snapshot
+    agentspace->removeAtom(link->getHandle());
+    auto carol = agentspace->addAgentNode("carol");
+    assert(before->getAtomCount() == 3);
+    assert(before->getAtom(link->getId()) == link);
+    assert(before->getIncoming(alice->getHandle()).size() == 1);
+    assert(before->getAtomsByType(AtomType::COLLABORATION_LINK).size() == 1);
+    assert(before->getAtomsByName("carol").empty());
+    
+    auto after = agentspace->snapshot();
+    assert(after->getVersion() > before->getVersion());
+    assert(after->getAtomCount() == 3);
+    assert(after->getAtom(carol->getHandle()) == carol);
+    assert(!after->getAtom(link->getHandle()));
+    assert(after->getIncoming(alice->getHandle()).empty());
+    
+    // Readers keep scanning snapshots while writers carry on
+    std::atomic<bool> done{false};
+    std::thread reader([&]() {
+        while (!done.load()) {
+            auto snap = agentspace->snapshot();
+            assert(snap->getAtoms().size() == snap->getAtomCount());
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        auto node = agentspace->addBeliefNode("belief_" + std::to_string(i));
+        if (i % 2 == 0) {
+            agentspace->removeAtom(node->getHandle());
+        }
+    }
+    done = true;
+    reader.join();
+    assert(agentspace->snapshot()->getAtomCount() == agentspace->getAtomCount());
+    
+    // A new snapshot recopies only the chunks of slots written since the last
+    // one; untouched chunks, and the AtomPtrs in them, are shared
+    AgentSpaceConfig single_config;
+    single_config.num_shards = 1;
+    auto chunked = std::make_shared<AgentSpace>("chunked_snapshot_space", single_config);
+    std::vector<AtomPtr> nodes;
+    for (int i = 0; i < 1000; ++i) {
+        nodes.push_back(chunked->addAtom(chunked->createNode(AtomType::NODE, "n" + std::to_string(i))));
+    }
+    auto first = chunked->snapshot();
+    chunked->addAtom(chunked->createLink(AtomType::KNOWLEDGE_LINK, {nodes[999], nodes[998]}));
+    auto second = chunked->snapshot();
+    assert(&*first->atomsOfType(AtomType::NODE).begin() == &*second->atomsOfType(AtomType::NODE).begin());
+    assert(first->getIncoming(nodes[999]->getHandle()).empty());
+    assert(second->getIncoming(nodes[999]->getHandle()).size() == 1);
+    assert(second->getAtomCount() == 1001 && second->getAtoms().size() == 1001);
+    chunked->removeAtom(nodes[0]->getHandle());
+    auto third = chunked->snapshot();
+    assert(second->getAtom(nodes[0]->getId()) == nodes[0]);
+    assert(!third->getAtom(nodes[0]->getId()));
+    assert(third->getAtomsByType(AtomType::NODE).size() == 999);
+    
+    std::cout << "Snapshot test passed!" << std::endl;
+}
+
+void testAtomMetadata() {
+    std::cout << "Testing interned atom metadata..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("metadata_test_space");
+    auto alice = agentspace->addAgentNode("alice", {"planning", "reasoning"});
+    auto bob = agentspace->addAgentNode("bob");
+    
+    // String keys and interned ids address the same entry
+    assert(alice->getMetadata("capabilities") == "planning,reasoning");
+    assert(alice->getMetadata(MetaKey::CAPABILITIES) == "planning,reasoning");
+    assert(MetadataKeys::intern("capabilities") == MetaKey::CAPABILITIES);
+    assert(alice->getMetadata("never_set_key").empty());
+    
+    // Typed values are stored unformatted and formatted on string reads
+    auto creation = alice->getMetadataValue(MetaKey::CREATION_TIME);
+    assert(creation && std::holds_alternative<Timestamp>(*creation));
+    auto trust = agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.75);
+    assert(std::get<double>(*trust->getMetadataValue(MetaKey::TRUST_LEVEL)) == 0.75);
+    assert(trust->getMetadata("trust_level") == std::to_string(0.75));
+    
+    // Entries beyond the inline capacity spill over and stay addressable
+    for (int i = 0; i < 10; ++i) {
+        bob->setMetadata("extra_" + std::to_string(i), std::to_string(i));
+    }
+    bob->setMetadata("extra_3", "updated");
+    assert(bob->getMetadata("extra_9") == "9");
+    assert(bob->getMetadata("extra_3") == "updated");
+    assert(bob->toDict()["meta_extra_0"] == "0");
+    assert(!bob->getMetadataValue(MetadataKeys::intern("extra_10")));
+    
+    std::cout << "Atom metadata test passed!" << std::endl;
+}
+
+void testVisitorQueries() {
+    std::cout << "Testing visitor queries..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("visitor_test_space", config);
+    
+    auto hub = agentspace->addAgentNode("hub");
+    for (int i = 0; i < 20; ++i) {
+        auto agent = agentspace->addAgentNode("agent_" + std::to_string(i));
+        agentspace->addCollaborationLink(hub->getId(), agent->getId());
+    }
+    agentspace->addBeliefNode("agent_3");
+    
+    size_t agents = 0;
+    agentspace->forEachOfType(AtomType::AGENT_NODE, [&](const AtomPtr& atom) {
+        assert(atom->getType() == AtomType::AGENT_NODE);
+        ++agents;
+    });
+    assert(agents == 21);
+    
+    // Returning false stops the walk
+    size_t visited = 0;
+    agentspace->forEachAtom([&](const AtomPtr&) { return ++visited < 5; });
+    assert(visited == 5);
+    
+    size_t named = 0;
+    agentspace->forEachWithName("agent_3", [&](const AtomPtr&) { ++named; });
+    assert(named == 2);
+    assert(agentspace->findAtoms(AtomType::BELIEF_NODE, "agent_3").size() == 1);
+    
+    size_t incoming = 0;
+    agentspace->forEachIncoming(hub->getHandle(), [&](const AtomPtr& link) {
+        assert(link->getType() == AtomType::COLLABORATION_LINK);
+        ++incoming;
+    });
+    assert(incoming == 20);
+    
+    // Snapshot ranges are lazy and compose filters
+    auto snap = agentspace->snapshot();
+    size_t in_range = 0;
+    for (const auto& atom : snap->atomsOfType(AtomType::AGENT_NODE)) {
+        assert(atom->getType() == AtomType::AGENT_NODE);
+        ++in_range;
+    }
+    assert(in_range == 21);
+    
+    auto low = snap->atomsOfType(AtomType::AGENT_NODE).filter([](const Atom& atom) {
+        return atom.getName().size() == 7;  // agent_0 .. agent_9
+    });
+    assert(std::distance(low.begin(), low.end()) == 10);
+    assert(snap->atomsOfType(AtomType::TRUST_LINK).begin() == snap->atomsOfType(AtomType::TRUST_LINK).end());
+    
+    size_t links = 0;
+    snap->forEachOfType(AtomType::COLLABORATION_LINK, [&](const AtomPtr&) { ++links; });
+    assert(links == 20);
+    
+    std::cout << "Visitor query test passed!" << std::endl;
+}
+
+void testBulkInsert() {
+    std::cout << "Testing bulk insert..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("bulk_test_space", config);
+    
+    std::vector<AtomPtr> agents;
+    for (int i = 0; i < 1000; ++i) {
+        agents.push_back(agentspace->createNode(AtomType::AGENT_NODE, "agent_" + std::to_string(i)));
+    }
+    agents.push_back(nullptr);
+    
+    auto stored = agentspace->addAtoms(agents);
+    assert(stored.size() == agents.size());
+    assert(stored[10] == agents[10] && !stored.back());
+    assert(agentspace->getAtomCount() == 1000);
+    assert(agentspace->getAtom(agents[500]->getId()) == agents[500]);
+    assert(agentspace->getAtomsByName("agent_999").size() == 1);
+    
+    // Batches spread across shards rather than landing on one
+    for (const auto& atom : agentspace->getAtoms()) {
+        assert(atom->getHandle().isValid());
+    }
+    assert(agents[0]->getHandle().slot() % 4 != agents[1]->getHandle().slot() % 4);
+    
+    // Links built in a batch are fully indexed
+    LinkBatch batch(*agentspace);
+    batch.reserve(999);
+    for (int i = 1; i < 1000; ++i) {
+        auto link = batch.add(AtomType::TRUST_LINK, {agents[0], agents[i]});
+        link->setTruthValue(TruthValue(0.6, 0.5));
+    }
+    assert(batch.commit().size() == 999);
+    assert(batch.size() == 0);
+    assert(agentspace->getIncomingCount(agents[0]->getHandle()) == 999);
+    assert(std::abs(agentspace->getTrustLevel(agents[7]->getHandle(), agents[0]->getHandle()) - 0.6) < 1e-9);
+    
+    // Re-adding stored atoms in a batch is a no-op
+    agentspace->addAtoms({agents[1], agents[2]});
+    assert(agentspace->getAtomCount() == 1999);
+    
+    // Duplicates collapse within a batch when hash-consing
+    config.hash_consing = true;
+    auto consing = std::make_shared<AgentSpace>("bulk_consing_space", config);
+    auto first = consing->createNode(AtomType::GOAL_NODE, "goal");
+    auto second = consing->createNode(AtomType::GOAL_NODE, "goal");
+    auto result = consing->addAtoms({first, second});
+    assert(result[0] == first && result[1] == first);
+    assert(consing->getAtomCount() == 1);
+    
+    std::cout << "Bulk insert test passed!" << std::endl;
+}
+
+void testSnapshotFile() {
+    std::cout << "Testing snapshot files..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("file_test_space", config);
+    
+    auto alice = agentspace->addAgentNode("alice", {"reasoning", "planning"});
+    auto bob = agentspace->addAgentNode("bob");
+    auto goal = agentspace->addGoalNode("explore", 0.8);
+    auto trust = agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.7);
+    auto knows = agentspace->addKnowledgeLink(goal->getId(), trust->getId(), "about");
+    alice->setAttentionValue(AttentionValue(0.75, 0.25, 0.5));
+    alice->setMetadata(MetadataKeys::intern("rank"), MetadataValue(int64_t(3)));
+    
+    std::string path = "/tmp/swarmcog_test_" + Utils::UUIDGenerator::generateShort() + ".snap";
+    assert(agentspace->saveSnapshot(path));
+    
+    // The mapped file answers index queries without building a space
+    auto file = MappedSnapshot::open(path);
+    assert(file && file->getSpaceName() == "file_test_space");
+    assert(file->getAtomCount() == 5);
+    uint32_t alice_index = file->findById(alice->getId());
+    assert(alice_index != SnapshotFormat::kNoAtom);
+    assert(file->string(file->atom(alice_index).name) == alice->getName());
+    assert(file->findById("missing") == SnapshotFormat::kNoAtom);
+    assert(file->atomsOfType(AtomType::AGENT_NODE).second == 2);
+    assert(file->incoming(alice_index).second == 1);
+    uint32_t knows_index = file->findById(knows->getId());
+    assert(file->outgoing(knows_index).second == 2);
+    assert(file->outgoing(knows_index).first[1] == file->findById(trust->getId()));
+    
+    // Reopening restores ids, values, metadata and link structure
+    auto restored = AgentSpace::openSnapshot(path, config);
+    assert(restored && restored->getName() == "file_test_space");
+    assert(restored->getAtomCount() == 5);
+    
+    auto restored_alice = restored->getAtom(alice->getId());
+    assert(restored_alice && restored_alice->getType() == AtomType::AGENT_NODE);
+    assert(restored_alice->getTimestamp() == alice->getTimestamp());
+    assert(restored_alice->getAttentionValue().sti == 0.75);
+    assert(restored_alice->getMetadata("capabilities") == "reasoning,planning");
+    assert(std::get<int64_t>(*restored_alice->getMetadataValue(MetadataKeys::intern("rank"))) == 3);
+    assert(restored_alice->getMetadataValue(MetaKey::CREATION_TIME) == alice->getMetadataValue(MetaKey::CREATION_TIME));
+    
+    auto restored_goal = std::dynamic_pointer_cast<Node>(restored->getAtom(goal->getId()));
+    assert(restored_goal && restored_goal->getValue() == goal->getValue());
+    assert(restored_goal->getTruthValue().strength == goal->getTruthValue().strength);
+    
+    // Indices are complete once the background load is done
+    assert(restored->waitForSnapshot());
+    assert(std::abs(restored->getTrustLevel(alice->getId(), bob->getId()) - 0.7) < 1e-9);
+    auto restored_knows = std::dynamic_pointer_cast<Link>(restored->getAtom(knows->getId()));
+    assert(restored_knows && restored_knows->getOutgoing()[1] == restored->getAtom(trust->getId()));
+    assert(restored->getIncomingCount(restored_goal->getHandle()) == 1);
+    
+    // Opening a large file returns before its atoms are in; lookups by id
+    // load them on demand, even for a link whose targets are not in yet
+    std::vector<AtomPtr> many;
+    for (int i = 0; i < 20000; ++i) {
+        many.push_back(agentspace->addBeliefNode("belief_" + std::to_string(i)));
+    }
+    auto late_link = agentspace->addKnowledgeLink(many[19998]->getId(), many[19999]->getId(), "last");
+    auto dave = agentspace->addAgentNode("dave");
+    auto erin = agentspace->addAgentNode("erin");
+    agentspace->addTrustRelationship(dave->getId(), erin->getId(), 0.6);
+    agentspace->addCollaborationLink(dave->getId(), erin->getId());
+    assert(agentspace->saveSnapshot(path));
+    auto large = AgentSpace::openSnapshot(path, config);
+    assert(large && large->getAtomCount() == agentspace->getAtomCount());
+    
+    // Type, incoming and trust queries load what they need rather than
+    // answering from the part inserted so far
+    assert(std::abs(large->getTrustLevel(dave->getId(), erin->getId()) - 0.6) < 1e-9);
+    assert(large->getCollaborators(erin->getId()) == std::vector<AtomId>{dave->getId()});
+    assert(large->getIncoming(large->getHandle(erin->getId())).size() == 2);
+    assert(large->getAtomsByType(AtomType::BELIEF_NODE).size() == 20000);
+    auto late = std::dynamic_pointer_cast<Link>(large->getAtom(late_link->getId()));
+    assert(late && late->getOutgoing()[1] == large->getAtom(many[19999]->getId()));
+    assert(large->getAtomCount() == agentspace->getAtomCount());
+    assert(large->removeAtom(many[5]->getId()));
+    assert(large->waitForSnapshot());
+    assert(large->getAtomCount() == agentspace->getAtomCount() - 1);
+    assert(!large->getAtom(many[5]->getId()));
+    assert(large->getAtomsByType(AtomType::BELIEF_NODE).size() == 19999);
+    large.reset();
+    
+    // A corrupt id index without a single empty cell still ends the probe
+    {
+        SnapshotFormat::Header header;
+        std::FILE* corrupt = std::fopen(path.c_str(), "r+b");
+        assert(std::fread(&header, sizeof(header), 1, corrupt) == 1);
+        std::vector<uint32_t> full(header.id_index_capacity, 0);
+        std::fseek(corrupt, static_cast<long>(header.id_index_offset), SEEK_SET);
+        std::fwrite(full.data(), sizeof(uint32_t), full.size(), corrupt);
+        std::fclose(corrupt);
+    }
+    auto corrupt_file = MappedSnapshot::open(path);
+    assert(corrupt_file && corrupt_file->findById("missing") == SnapshotFormat::kNoAtom);
+    corrupt_file.reset();
+    
+    std::remove(path.c_str());
+    
+    // Missing and foreign files are rejected
+    assert(!AgentSpace::openSnapshot(path));
+    {
+        std::FILE* junk = std::fopen(path.c_str(), "wb");
+        std::fputs("not a snapshot file at all, just some text that is long enough", junk);
+        std::fclose(junk);
+    }
+    assert(!MappedSnapshot::open(path));
+    std::remove(path.c_str());
+    
+    std::cout << "Snapshot file test passed!" << std::endl;
+}
+
+void testMutationLog() {
+    std::cout << "Testing mutation log..." << std::endl;
+    
+    std::string base = "/tmp/swarmcog_wal_" + Utils::UUIDGenerator::generateShort();
+    std::string log_path = base + ".log";
+    std::string snapshot_path = base + ".snap";
+    
+    MutationLogConfig log_config;
+    log_config.flush_interval = std::chrono::milliseconds(20);
+    
+    AgentSpaceConfig config;
+    config.num_shards = 2;
+    auto agentspace = std::make_shared<AgentSpace>("wal_space", config);
+    auto log = MutationLog::open(log_path, log_config);
+    assert(log);
+    agentspace->setMutationLog(log);
+    
+    auto alice = agentspace->addAgentNode("alice", {"reasoning"});
+    auto bob = agentspace->addAgentNode("bob");
+    auto carol = agentspace->addAgentNode("carol");
+    auto trust = agentspace->addTrustRelationship(alice->getId(), bob->getId(), 0.4);
+    trust->setTruthValue(TruthValue(0.9, 0.8));
+    bob->setAttentionValue(AttentionValue(0.5, 0.25, 0.0));
+    alice->setMetadata(MetaKey::TRUST_LEVEL, 0.75);
+    assert(agentspace->removeAtom(carol->getId()));
+    
+    // Unattached atoms are not logged
+    agentspace->createNode(AtomType::GOAL_NODE, "loose")->setTruthValue(TruthValue(0.1, 0.1));
+    
+    // The whole burst shares a handful of syncs rather than one per record
+    assert(log->flush());
+    assert(log->getDurableCount() == log->getAppendedCount());
+    assert(log->getAppendedCount() == 8);
+    assert(log->getSyncCount() < log->getAppendedCount());
+    
+    // Recovery without a snapshot replays the log into an empty space
+    auto recovered = AgentSpace::recover("wal_space", snapshot_path, log_path, config, log_config);
+    assert(recovered && recovered->getAtomCount() == 3);
+    assert(!recovered->getAtom(carol->getId()));
+    assert(recovered->getAtom(trust->getId())->getTruthValue().strength == 0.9);
+    assert(recovered->getAtom(bob->getId())->getAttentionValue().sti == 0.5);
+    assert(recovered->getAtom(alice->getId())->getMetadata(MetaKey::TRUST_LEVEL) == alice->getMetadata(MetaKey::TRUST_LEVEL));
+    assert(recovered->getAtom(alice->getId())->getMetadata("capabilities") == "reasoning");
+    assert(std::abs(recovered->getTrustLevel(alice->getId(), bob->getId()) - 0.9) < 1e-9);
+    agentspace.reset();
+    log.reset();
+    
+    // A checkpoint snapshots the space and starts the log afresh
+    assert(recovered->checkpoint(snapshot_path));
+    assert(!std::ifstream(MutationLog::rotatedPath(log_path)).good());
+    recovered->getAtom(bob->getId())->setTruthValue(TruthValue(0.3, 0.6));
+    auto dave = recovered->addAgentNode("dave");
+    assert(recovered->getMutationLog()->flush());
+    assert(MutationLog::read(log_path, [](const MutationRecord&) {}) == 2);
+    recovered.reset();
+    
+    // A torn record at the tail is ignored
+    {
+        std::ofstream tail(log_path, std::ios::binary | std::ios::app);
+        tail.write("\x40\x00\x00\x00garbage", 11);
+    }
+    
+    auto restarted = AgentSpace::recover("wal_space", snapshot_path, log_path, config, log_config);
+    assert(restarted && restarted->getAtomCount() == 4);
+    assert(restarted->getAtom(bob->getId())->getTruthValue().strength == 0.3);
+    assert(restarted->getAtom(dave->getId()));
+    assert(restarted->getIncomingCount(restarted->getAtom(alice->getId())->getHandle()) == 1);
+    
+    // Reopening cut the torn tail off, so records appended since replay too
+    auto erin = restarted->addAgentNode("erin");
+    assert(restarted->getMutationLog()->flush());
+    restarted.reset();
+    
+    auto again = AgentSpace::recover("wal_space", snapshot_path, log_path, config, log_config);
+    assert(again && again->getAtomCount() == 5);
+    assert(again->getAtom(erin->getId()) && again->getAtom(dave->getId()));
+    assert(MutationLog::read(log_path, [](const MutationRecord&) {}) == 3);
+    again.reset();
+    
+    // Setters log outside their critical sections, yet racing ones still
+    // leave the value the atom ended up with last in the log
+    std::string race_path = base + "_race.log";
+    auto raced = std::make_shared<AgentSpace>("wal_race_space", config);
+    raced->setMutationLog(MutationLog::open(race_path, log_config));
+    auto contested = raced->addBeliefNode("contested");
+    std::vector<std::thread> setters;
+    for (int t = 0; t < 4; ++t) {
+        setters.emplace_back([&contested, t]() {
+            for (int i = 0; i < 500; ++i) {
+                double v = (t * 500 + i) / 2000.0;
+                contested->setTruthValue(TruthValue(v, v));
+                contested->setAttentionValue(AttentionValue(v, 0.0, 0.0));
+            }
+        });
+    }
+    for (auto& setter : setters) {
+        setter.join();
+    }
+    assert(raced->getMutationLog()->flush());
+    auto replayed = AgentSpace::recover("wal_race_space", base + "_race.snap", race_path, config, log_config);
+    assert(replayed);
+    auto copy = replayed->getAtom(contested->getId());
+    assert(copy->getTruthValue().strength == contested->getTruthValue().strength);
+    assert(copy->getAttentionValue().sti == contested->getAttentionValue().sti);
+    replayed.reset();
+    raced.reset();
+    std::remove(race_path.c_str());
+    
+    std::remove(log_path.c_str());
+    std::remove(snapshot_path.c_str());
+    
+    std::cout << "Mutation log test passed!" << std::endl;
+}
+
+void testPatternQuery() {
+    std::cout << "Testing pattern queries..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("query_test_space", config);
+    
+    auto x = agentspace->addAgentNode("x");
+    auto y = agentspace->addAgentNode("y");
+    std::vector<NodePtr> agents;
+    for (int i = 0; i < 10; ++i) {
+        agents.push_back(agentspace->addAgentNode("agent_" + std::to_string(i), {i % 3 == 0 ? "planning" : "vision"}));
+        agentspace->addTrustRelationship(x->getId(), agents[i]->getId(), i / 10.0);
+        if (i % 2 == 0) {
+            // Stored in both directions; the query must not care
+            if (i % 4 == 0) agentspace->addCollaborationLink(agents[i]->getId(), y->getId());
+            else agentspace->addCollaborationLink(y->getId(), agents[i]->getId());
+        }
+    }
+    
+    // Agents trusted at 0.6 or more by x that collaborate with y
+    PatternQuery trusted;
+    trusted.link(AtomType::TRUST_LINK, {x, "agent"}, "trust")
+           .link(AtomType::COLLABORATION_LINK, {"agent", y}, "", LinkOrder::ANY_ORDER)
+           .whereTruth("trust", 0.6);
+    auto result = agentspace->query(trusted);
+    assert(result.size() == 2);
+    auto matched = result.column("agent");
+    assert((matched[0] == agents[6] && matched[1] == agents[8]) || (matched[0] == agents[8] && matched[1] == agents[6]));
+    assert(result.get(0, "trust")->getType() == AtomType::TRUST_LINK);
+    assert(!result.get(0, "missing"));
+    
+    // The planner starts from a fixed atom's incoming set, not a scan
+    assert(trusted.explain(*agentspace->snapshot()).find("1. expand") == 0);
+    
+    // Metadata predicates and limits
+    PatternQuery planners;
+    planners.link(AtomType::TRUST_LINK, {x, "agent"})
+            .whereMetadata("agent", MetaKey::CAPABILITIES, [](const MetadataValue& value) {
+                return std::get<std::string>(value) == "planning";
+            });
+    assert(agentspace->query(planners).size() == 4);
+    assert(agentspace->query(planners, 2).size() == 2);
+    
+    // Ordered links respect direction; standalone variables use their index
+    PatternQuery forward;
+    forward.link(AtomType::COLLABORATION_LINK, {"agent", y});
+    assert(agentspace->query(forward).size() == 3);
+    PatternQuery named;
+    named.node("a", AtomType::AGENT_NODE, "agent_3");
+    assert(agentspace->query(named).size() == 1);
+    
+    // A link naming the anchor twice matches once, even after a removal has
+    // swapped its incoming entries apart
+    auto z = agentspace->addGoalNode("z");
+    for (const auto& agent : agents) {
+        agentspace->addKnowledgeLink(agent->getId(), x->getId(), "noise");
+    }
+    auto gone = agentspace->addKnowledgeLink(z->getId(), x->getId(), "gone");
+    agentspace->addKnowledgeLink(z->getId(), y->getId(), "kept");
+    agentspace->addKnowledgeLink(z->getId(), z->getId(), "self");
+    assert(agentspace->removeAtom(gone->getHandle()));
+    PatternQuery from_z;
+    from_z.link(AtomType::KNOWLEDGE_LINK, {z, "other"});
+    assert(from_z.explain(*agentspace->snapshot()).find("1. expand") == 0);
+    assert(agentspace->query(from_z).size() == 2);
+    
+    // Large candidate sets run in parallel with the same results
+    std::vector<AtomPtr> batch;
+    for (int i = 0; i < 3000; ++i) {
+        batch.push_back(agentspace->createNode(AtomType::BELIEF_NODE, "belief_" + std::to_string(i)));
+    }
+    agentspace->addAtoms(batch);
+    LinkBatch links(*agentspace);
+    for (int i = 0; i < 3000; ++i) {
+        links.add(AtomType::EVALUATION_LINK, {agents[i % 10], batch[i]});
+    }
+    links.commit();
+    
+    PatternQuery fanout;
+    fanout.link(AtomType::EVALUATION_LINK, {"agent", "belief"})
+          .link(AtomType::TRUST_LINK, {x, "agent"}, "trust")
+          .whereTruth("trust", 0.5);
+    auto sequential = agentspace->query(fanout);
+    fanout.parallelThreshold(16);
+    auto parallel = agentspace->query(fanout);
+    assert(sequential.size() == 1500);
+    assert(parallel.size() == sequential.size());
+    for (size_t i = 0; i < parallel.size(); ++i) {
+        assert(parallel.row(i) == sequential.row(i));
+    }
+    
+    // A limit keeps the same leading rows however the workers race
+    auto limited = agentspace->query(fanout, 100);
+    assert(limited.size() == 100);
+    for (size_t i = 0; i < limited.size(); ++i) {
+        assert(limited.row(i) == sequential.row(i));
+    }
+    
+    std::cout << "Pattern query test passed!" << std::endl;
+}
+
+void testUniqueNaming() {
+    std::cout << "Testing unique node naming..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("naming_test_space", config);
+    
+    // A name taken outside the counter is skipped, not duplicated
+    agentspace->addAtom(agentspace->createNode(AtomType::AGENT_NODE, "worker_2"));
+    
+    for (int i = 0; i < 10000; ++i) {
+        agentspace->addAgentNode("worker");
+    }
+    assert(agentspace->getAtomsByName("worker").size() == 1);
+    assert(agentspace->getAtomsByName("worker_1").size() == 1);
+    assert(agentspace->getAtomsByName("worker_2").size() == 1);
+    assert(agentspace->getAtomsByName("worker_10000").size() == 1);
+    assert(agentspace->getAtomsByName("worker_10001").empty());
+    
+    // Concurrent spawns never receive the same name
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&agentspace]() {
+            for (int i = 0; i < 250; ++i) {
+                agentspace->addAgentNode("scout");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::unordered_set<std::string> names;
+    agentspace->forEachOfType(AtomType::AGENT_NODE, [&names](const AtomPtr& atom) {
+        assert(names.insert(atom->getName()).second);
+    });
+    assert(names.size() == 11001);
+    
+    // A base name racing a caller who asked for one of its generated names
+    std::vector<std::thread> racers;
+    for (int t = 0; t < 4; ++t) {
+        racers.emplace_back([&agentspace, t]() {
+            for (int i = 0; i < 200; ++i) {
+                agentspace->addAgentNode(t % 2 ? "runner_1" : "runner");
+            }
+        });
+    }
+    for (auto& racer : racers) {
+        racer.join();
+    }
+    names.clear();
+    agentspace->forEachOfType(AtomType::AGENT_NODE, [&names](const AtomPtr& atom) {
+        assert(names.insert(atom->getName()).second);
+    });
+    assert(names.size() == 11801);
+    
+    // Counters go away with the atoms that named their base
+    size_t counters = agentspace->getStatistics()["name_counters"];
+    auto temp = agentspace->addAgentNode("temp");
+    agentspace->addAgentNode("temp");
+    assert(agentspace->getStatistics()["name_counters"] == counters + 1);
+    agentspace->removeAtom(temp->getHandle());
+    assert(agentspace->getStatistics()["name_counters"] == counters);
+    assert(agentspace->addAgentNode("temp")->getName() == "temp");
+    
+    std::cout << "Unique node naming test passed!" << std::endl;
+}
+
+void testCapabilityRegistry() {
+    std::cout << "Testing capability registry..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("capability_test_space", config);
+    const auto& registry = agentspace->getCapabilityRegistry();
+    
+    // Enough agents to span several bitset blocks
+    std::vector<NodePtr> agents;
+    for (int i = 0; i < 1000; ++i) {
+        std::vector<std::string> capabilities = {"all"};
+        if (i % 2 == 0) capabilities.push_back("even");
+        if (i % 3 == 0) capabilities.push_back("three");
+        agents.push_back(agentspace->addAgentNode("agent", capabilities));
+    }
+    assert(registry.getAgentCount() == 1000);
+    assert(registry.agentsWithAll(std::vector<std::string>{"all"}).size() == 1000);
+    assert(registry.agentsWithAll(std::vector<std::string>{"even", "three"}).size() == 167);
+    assert(registry.agentsWithAll(std::vector<std::string>{"even", "missing"}).empty());
+    
+    CapabilityId even, three;
+    assert(registry.find("even", even) && registry.find("three", three));
+    assert(registry.countWithAll({even, three}) == 167);
+    assert(registry.agentsWithAny({even, three}).size() == 667);
+    assert(registry.hasCapability(agents[6]->getHandle(), "three"));
+    assert(!registry.hasCapability(agents[7]->getHandle(), "even"));
+    
+    // Removal and updates keep the index and the metadata in step
+    agentspace->removeAtom(agents[0]->getHandle());
+    assert(registry.countWithAll({even, three}) == 166);
+    assert(agentspace->setAgentCapabilities(agents[1]->getHandle(), {"even", "three", "flying"}));
+    assert(registry.countWithAll({even, three}) == 167);
+    assert(agents[1]->getMetadata(MetaKey::CAPABILITIES) == "even,three,flying");
+    assert(registry.agentsWithAll(std::vector<std::string>{"flying"}).front() == agents[1]->getHandle());
+    assert(!agentspace->setAgentCapabilities(agents[0]->getHandle(), {"even"}));
+    
+    // Agents added after a removal reuse its member slot
+    auto late = agentspace->addAgentNode("late", {"flying"});
+    assert(registry.agentsWithAll(std::vector<std::string>{"flying"}).size() == 2);
+    assert(registry.getCapabilities(late->getHandle()) == std::vector<std::string>{"flying"});
+    
+    // Setting the metadata directly moves the agent in the registry too
+    auto relabeled = agentspace->addAgentNode("a", {"x"});
+    relabeled->setMetadata("capabilities", "y");
+    assert(registry.agentsWithAll(std::vector<std::string>{"y"}).size() == 1);
+    assert(registry.agentsWithAll(std::vector<std::string>{"x"}).empty());
+
+    agentspace->clear();
+    assert(registry.getAgentCount() == 0);
+    assert(registry.agentsWithAll(std::vector<std::string>{"all"}).empty());
+    
+    // Agent-level lookups go through the registry
+    SwarmCogConfig swarm_config;
+    swarm_config.agentspace_name = "capability_swarm";
+    auto swarmcog = std::make_shared<SwarmCog::SwarmCog>(swarm_config);
+    auto alpha = swarmcog->createCognitiveAgent("alpha", "Alpha", "cognitive_v1", "", {"reasoning", "planning"});
+    swarmcog->createCognitiveAgent("beta", "Beta", "cognitive_v1", "", {"planning"});
+    auto gamma = swarmcog->createCognitiveAgent("gamma", "Gamma", "cognitive_v1", "", {"vision"});
+    assert(swarmcog->findAgentsByCapability("planning").size() == 2);
+    assert(swarmcog->findAgentsByCapability("vision") == std::vector<AgentId>{"gamma"});
+    
+    gamma->addCapability("planning", "Plans ahead");
+    assert(swarmcog->findAgentsByCapability("planning").size() == 3);
+    assert(alpha->findCollaborators("planning", 0.0).size() == 2);
+    
+    swarmcog->removeAgent("beta");
+    assert(swarmcog->findAgentsByCapability("planning").size() == 2);
+    
+    std::cout << "Capability registry test passed!" << std::endl;
+}
+
+void testLazyAttentionDecay() {
+    std::cout << "Testing lazy attention decay..." << std::endl;
+    
+    // Reference: the recurrence applied one tick at a time
+    auto step = [](AttentionValue av, int ticks) {
+        for (int i = 0; i < ticks; ++i) {
+            av.sti *= 0.99;
+            av.lti = av.lti * 0.999 + av.sti * 0.001;
+            av.vlti = av.vlti * 0.9999 + av.lti * 0.0001;
+        }
+        return av;
+    };
+    auto close = [](const AttentionValue& a, const AttentionValue& b) {
+        return std::abs(a.sti - b.sti) < 1e-9 && std::abs(a.lti - b.lti) < 1e-9 &&
+               std::abs(a.vlti - b.vlti) < 1e-9;
+    };
+    
+    for (size_t interval : {size_t(0), size_t(7)}) {
+        AgentSpaceConfig config;
+        config.num_shards = 2;
+        config.attention_sweep_interval = interval;
+        auto agentspace = std::make_shared<AgentSpace>("lazy_decay_space", config);
+        
+        AttentionValue initial(0.8, -0.4, 0.6);
+        auto cold = agentspace->addBeliefNode("cold");
+        auto warm = agentspace->addBeliefNode("warm");
+        cold->setAttentionValue(initial);
+        warm->setAttentionValue(initial);
+        
+        // An atom left unread for many ticks catches up in one step
+        for (int i = 0; i < 500; ++i) {
+            agentspace->updateAttentionValues();
+            if (i == 99) {
+                assert(close(warm->getAttentionValue(), step(initial, 100)));
+                warm->setAttentionValue(AttentionValue(-0.5, 0.9, 0.1));
+            }
+        }
+        assert(close(cold->getAttentionValue(), step(initial, 500)));
+        assert(close(warm->getAttentionValue(), step(AttentionValue(-0.5, 0.9, 0.1), 400)));
+        
+        // Importance ranking reflects the decayed values
+        assert(agentspace->getMostImportantAtoms(1)[0] == warm);
+        agentspace->updateAttentionValues();
+        
+        // Removed atoms keep the value they had decayed to
+        agentspace->removeAtom(warm->getHandle());
+        AttentionValue frozen = warm->getAttentionValue();
+        agentspace->updateAttentionValues();
+        assert(warm->getAttentionValue().sti == frozen.sti);
+        assert(close(frozen, step(AttentionValue(-0.5, 0.9, 0.1), 401)));
+        assert(agentspace->getMostImportantAtoms(1)[0] == cold);
+    }
+    
+    std::cout << "Lazy attention decay test passed!" << std::endl;
+}
+
+void testForgetting() {
+    std::cout << "Testing importance-based forgetting..." << std::endl;
+    
+    AgentSpaceConfig space_config;
+    space_config.num_shards = 2;
+    auto agentspace = std::make_shared<AgentSpace>("forgetting_test_space", space_config);
+    auto agent = agentspace->addAgentNode("rememberer");
+    
+    for (int i = 0; i < 20; ++i) {
+        agentspace->addMemoryNode("fact " + std::to_string(i), "episodic", "a");
+    }
+    // Faded memories go, together with the links that point at them
+    for (int i = 0; i < 10; ++i) {
+        auto faded = agentspace->addMemoryNode("faded " + std::to_string(i), "episodic", "a");
+        faded->setAttentionValue(AttentionValue(0.0, 0.0, 0.01));
+        assert(agentspace->addKnowledgeLink(faded->getId(), agent->getId()));
+    }
+    // Equal memories of one owner collapse into the first one seen, and the
+    // links pointing at them, down to links on links, move to the survivor
+    std::vector<NodePtr> repeats;
+    std::vector<LinkPtr> recalls;
+    for (int i = 0; i < 5; ++i) {
+        repeats.push_back(agentspace->addMemoryNode("Executed 1 actions successfully", "procedural", "b"));
+        recalls.push_back(agentspace->addKnowledgeLink(repeats[i]->getId(), agent->getId(), "recall " + std::to_string(i)));
+    }
+    auto nested = agentspace->createLink(AtomType::EVALUATION_LINK, {recalls[4], agent});
+    agentspace->addAtom(nested);
+    repeats[3]->setAttentionValue(AttentionValue(0.5, 0.0, 0.9));
+    agentspace->addMemoryNode("Executed 1 actions successfully", "procedural", "c");
+    
+    ForgettingConfig config;
+    config.agent_quota = 0;
+    config.batch_size = 4;
+    Forgetter forgetter(agentspace, config);
+    forgetter.runPass();
+    
+    auto stats = forgetter.getStats();
+    assert(stats.forgotten == 10);
+    assert(stats.merged == 4);
+    assert(stats.links_removed == 10);
+    assert(stats.passes == 1);
+    assert(agentspace->getAtomsByType(AtomType::MEMORY_NODE).size() == 22);
+    assert(agentspace->getAtom(agent->getHandle()) == agent);
+    
+    size_t kept = 0;
+    NodePtr survivor;
+    for (const auto& repeat : repeats) {
+        if (agentspace->getAtom(repeat->getHandle())) {
+            ++kept;
+            survivor = repeat;
+            assert(repeat->getAttentionValue().vlti == 0.9);
+        }
+    }
+    assert(kept == 1);
+    
+    auto moved = agentspace->getAtomsByType(AtomType::KNOWLEDGE_LINK);
+    assert(moved.size() == 5);
+    for (const auto& link : moved) {
+        assert(std::static_pointer_cast<Link>(link)->getOutgoing()[0] == survivor);
+        assert(link->getMetadata(MetaKey::RELATION).rfind("recall ", 0) == 0);
+    }
+    auto evaluations = agentspace->getAtomsByType(AtomType::EVALUATION_LINK);
+    assert(evaluations.size() == 1);
+    auto recalled = std::static_pointer_cast<Link>(std::static_pointer_cast<Link>(evaluations[0])->getOutgoing()[0]);
+    assert(recalled->getOutgoing()[0] == survivor && recalled->getMetadata(MetaKey::RELATION) == "recall 4");
+    assert(stats.links_repointed == (survivor == repeats[4] ? 4u : 5u));
+    
+    // Quotas keep the most important atoms of each type and owner
+    agentspace->clear();
+    for (int i = 1; i <= 10; ++i) {
+        for (const char* owner : {"a", "b"}) {
+            auto memory = agentspace->addMemoryNode("note " + std::to_string(i), "episodic", owner);
+            memory->setAttentionValue(AttentionValue(0.0, 0.0, i / 10.0));
+        }
+    }
+    config.agent_quota = 5;
+    config.type_quotas[AtomType::MEMORY_NODE] = 12;
+    Forgetter quota_forgetter(agentspace, config);
+    quota_forgetter.runPass();
+    
+    auto memories = agentspace->getAtomsByType(AtomType::MEMORY_NODE);
+    assert(memories.size() == 10);
+    for (const auto& memory : memories) {
+        assert(memory->getAttentionValue().vlti > 0.55);
+    }
+    
+    // The background thread keeps forgetting on its own
+    config.interval = std::chrono::milliseconds(1);
+    Forgetter background(agentspace, config);
+    background.start();
+    auto faded = agentspace->addMemoryNode("passing thought", "episodic", "a");
+    faded->setAttentionValue(AttentionValue(0.0, 0.0, 0.0));
+    for (int i = 0; i < 2000 && faded->getHandle().isValid(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    background.stop();
+    assert(!faded->getHandle().isValid());
+    assert(background.getStats().forgotten >= 1);
+    
+    std::cout << "Forgetting test passed!" << std::endl;
+}
+
+void testChangeFeed() {
+    std::cout << "Testing change feed..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 2;
+    auto agentspace = std::make_shared<AgentSpace>("feed_test_space", config);
+    auto& feed = agentspace->getChangeFeed();
+    
+    std::mutex events_mutex;
+    std::vector<ChangeEvent> goal_events;
+    ChangeFilter goal_filter;
+    goal_filter.types = {AtomType::GOAL_NODE};
+    auto goal_subscription = agentspace->subscribe(goal_filter, [&](const ChangeBatch& batch) {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        goal_events.insert(goal_events.end(), batch.events.begin(), batch.events.end());
+    });
+    
+    std::atomic<int> watched_updates{0};
+    ChangeFilter watched_filter;
+    watched_filter.name = "watched";
+    watched_filter.kinds = {ChangeKind::ATTENTION_UPDATED};
+    agentspace->subscribe(watched_filter, [&](const ChangeBatch& batch) {
+        for (const auto& event : batch.events) {
+            assert(event.kind == ChangeKind::ATTENTION_UPDATED && event.atom->getName() == "watched");
+            ++watched_updates;
+        }
+    });
+    assert(feed.getSubscriberCount() == 2);
+    
+    auto goal = agentspace->addGoalNode("explore", 0.4);
+    AtomHandle goal_handle = goal->getHandle();
+    goal->setTruthValue(TruthValue(0.9, 0.9));
+    agentspace->addBeliefNode("unrelated");
+    auto watched = agentspace->addBeliefNode("watched");
+    watched->setAttentionValue(AttentionValue(0.7, 0.1, 0.1));
+    agentspace->removeAtom(goal_handle);
+    feed.flush();
+    
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        assert(goal_events.size() == 3);
+        assert(goal_events[0].kind == ChangeKind::ADDED && goal_events[0].atom == goal);
+        assert(goal_events[1].kind == ChangeKind::TRUTH_UPDATED);
+        assert(goal_events[2].kind == ChangeKind::REMOVED && goal_events[2].atom == goal);
+        for (const auto& event : goal_events) {
+            assert(event.handle == goal_handle);
+        }
+    }
+    assert(watched_updates == 1);
+    
+    // Clearing reaches every subscriber whatever its type filter
+    agentspace->clear();
+    feed.flush();
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        assert(goal_events.back().kind == ChangeKind::CLEARED && !goal_events.back().atom);
+    }
+    
+    assert(agentspace->unsubscribe(goal_subscription));
+    assert(!agentspace->unsubscribe(goal_subscription));
+    agentspace->addGoalNode("ignored");
+    feed.flush();
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        assert(goal_events.size() == 4);
+    }
+    
+    // Concurrent writers all land in the ring
+    std::atomic<int> added{0};
+    SubscriptionConfig large;
+    large.capacity = 1 << 16;
+    ChangeFilter added_filter;
+    added_filter.kinds = {ChangeKind::ADDED};
+    auto added_subscription = agentspace->subscribe(added_filter, [&added](const ChangeBatch& batch) {
+        added += static_cast<int>(batch.events.size());
+    }, large);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&agentspace, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                agentspace->addGoalNode("goal_" + std::to_string(t) + "_" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    feed.flush();
+    assert(added == 4000);
+    assert(feed.getDroppedCount(added_subscription) == 0);
+    
+    // A stalled consumer loses events instead of blocking writers, and is told so
+    auto slow_space = std::make_shared<AgentSpace>("slow_feed_space");
+    std::atomic<bool> stalled{false};
+    std::atomic<bool> release{false};
+    std::atomic<uint64_t> reported_drops{0};
+    std::atomic<int> delivered{0};
+    SubscriptionConfig small;
+    small.capacity = 4;
+    auto slow_subscription = slow_space->subscribe(ChangeFilter(), [&](const ChangeBatch& batch) {
+        reported_drops += batch.dropped;
+        delivered += static_cast<int>(batch.events.size());
+        stalled = true;
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }, small);
+    
+    slow_space->addBeliefNode("first");
+    while (!stalled) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int i = 0; i < 20; ++i) {
+        slow_space->addBeliefNode("burst_" + std::to_string(i));
+    }
+    assert(slow_space->getChangeFeed().getDroppedCount(slow_subscription) == 16);
+    release = true;
+    slow_space->getChangeFeed().flush();
+    assert(delivered == 5);
+    assert(reported_drops == 16);
+    
+    std::cout << "Change feed test passed!" << std::endl;
+}
+
+void testMetadataIndex() {
+    std::cout << "Testing metadata indices..." << std::endl;
+    
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    auto agentspace = std::make_shared<AgentSpace>("metadata_index_test_space", config);
+    assert(agentspace->hasMetadataIndex(MetaKey::OWNER));
+    assert(agentspace->hasMetadataIndex(MetaKey::MEMORY_TYPE));
+    assert(!agentspace->createMetadataIndex(MetaKey::OWNER));
+    
+    for (int i = 0; i < 12; ++i) {
+        agentspace->addMemoryNode("note " + std::to_string(i), i % 3 == 0 ? "procedural" : "episodic",
+                                  i % 2 == 0 ? "alice" : "bob");
+    }
+    assert(agentspace->getMemoryNodes("alice").size() == 6);
+    assert(agentspace->getMemoryNodes("alice", "procedural").size() == 2);
+    assert(agentspace->getMemoryNodes("carol").empty());
+    assert(agentspace->findByMetadata(MetaKey::MEMORY_TYPE, std::string("procedural")).size() == 4);
+    
+    // Setters on stored atoms move the index entry; removal drops it
+    auto moved = agentspace->getMemoryNodes("bob").front();
+    moved->setMetadata(MetaKey::OWNER, std::string("carol"));
+    assert(agentspace->getMemoryNodes("bob").size() == 5);
+    assert(agentspace->getMemoryNodes("carol").front() == moved);
+    assert(agentspace->removeAtom(moved->getHandle()));
+    assert(agentspace->getMemoryNodes("carol").empty());
+    
+    // Detached atoms keep their metadata out of the index
+    moved->setMetadata(MetaKey::OWNER, std::string("dave"));
+    assert(agentspace->getMemoryNodes("dave").empty());
+    
+    // An index created later covers atoms already stored
+    MetadataKeyId rank = MetadataKeys::intern("rank");
+    std::vector<AtomPtr> ranked;
+    for (int64_t i = 0; i < 10; ++i) {
+        auto node = agentspace->addBeliefNode("ranked_" + std::to_string(i));
+        node->setMetadata(rank, (i * 7) % 10);
+        ranked.push_back(node);
+    }
+    auto scanned = agentspace->findByMetadataRange(rank, int64_t(2), int64_t(6));
+    assert(!agentspace->hasMetadataIndex(rank));
+    assert(agentspace->createMetadataIndex(rank));
+    auto indexed = agentspace->findByMetadataRange(rank, int64_t(2), int64_t(6));
+    assert(indexed.size() == 5);
+    assert(indexed == scanned);
+    for (size_t i = 0; i < indexed.size(); ++i) {
+        assert(std::get<int64_t>(*indexed[i]->getMetadataValue(rank)) == int64_t(i) + 2);
+    }
+    assert(agentspace->findByMetadata(rank, int64_t(9)).size() == 1);
+    assert(agentspace->findByMetadataRange(rank, int64_t(6), int64_t(2)).empty());
+    
+    // Concurrent setters leave exactly one entry per atom
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&ranked, rank, t]() {
+            for (int i = 0; i < 200; ++i) {
+                ranked[(i + t) % ranked.size()]->setMetadata(rank, int64_t(i % 5));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    auto all_ranked = agentspace->findByMetadataRange(rank, int64_t(0), int64_t(9));
+    assert(all_ranked.size() == ranked.size());
+    for (const auto& atom : all_ranked) {
+        auto value = std::get<int64_t>(*atom->getMetadataValue(rank));
+        auto matches = agentspace->findByMetadata(rank, value);
+        assert(std::find(matches.begin(), matches.end(), atom) != matches.end());
+    }
+    
+    // Clearing empties the indices but keeps them declared
+    agentspace->clear();
+    assert(agentspace->hasMetadataIndex(rank));
+    assert(agentspace->getMemoryNodes("alice").empty());
+    agentspace->addMemoryNode("fresh", "episodic", "alice");
+    assert(agentspace->getMemoryNodes("alice").size() == 1);
+    
+    std::cout << "Metadata index test passed!" << std::endl;
+}
+
+void testLockFreeAtomValues() {
+    std::cout << "Testing lock-free truth and attention values..." << std::endl;
+    
+    auto agentspace = std::make_shared<AgentSpace>("lock_free_test_space");
+    auto node = agentspace->addBeliefNode("contested");
+    
+    // Readers only ever see whole values: each write keeps strength == confidence
+    std::atomic<bool> done{false};
+    std::atomic<size_t> reads{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 1; i <= 2000; ++i) {
+                double v = ((i * 2 + t) % 100) / 100.0;
+                node->setTruthValue(TruthValue(v, v));
+                node->setAttentionValue(AttentionValue(v, v, v));
+            }
+        });
+    }
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&]() {
+            while (!done) {
+                TruthValue tv = node->getTruthValue();
+                assert(tv.strength == tv.confidence);
+                AttentionValue av = node->getAttentionValue();
+                assert(av.sti == av.lti && av.lti == av.vlti);
+                ++reads;
+            }
+        });
+    }
+    threads[0].join();
+    threads[1].join();
+    done = true;
+    threads[2].join();
+    threads[3].join();
+    assert(reads > 0);
+    
+    // Concurrent revisions all land: confidence only grows towards 1
+    auto revised = agentspace->createNode(AtomType::NODE, "revised");
+    revised->setTruthValue(TruthValue(0.5, 0.0));
+    threads.clear();
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&revised]() {
+            for (int i = 0; i < 100; ++i) {
+                revised->reviseTruthValue(TruthValue(0.5, 0.01));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double expected = 1.0 - std::pow(0.99, 400);
+    assert(std::abs(revised->getTruthValue().confidence - expected) < 1e-9);
+    
+    // Attention follows the atom into and out of the space's columns, even
+    // while it is being read
+    done = false;
+    std::thread reader([&]() {
+        while (!done) {
+            AttentionValue av = revised->getAttentionValue();
+            assert(av.sti == 0.25 || av.sti == 0.75);
+        }
+    });
+    revised->setAttentionValue(AttentionValue(0.25, 0.0, 0.0));
+    for (int i = 0; i < 50; ++i) {
+        agentspace->addAtom(revised);
+        assert(revised->getAttentionValue().sti == 0.25);
+        revised->setAttentionValue(AttentionValue(0.75, 0.0, 0.0));
+        assert(agentspace->removeAtom(revised->getHandle()));
+        assert(revised->getAttentionValue().sti == 0.75);
+        revised->setAttentionValue(AttentionValue(0.25, 0.0, 0.0));
+    }
+    done = true;
+    reader.join();
+    
+    // Column reads take no lock and decay on their own: a reader sees STI
+    // only fall while ticks run and inserts grow the columns underneath it
+    auto decaying = agentspace->addBeliefNode("decaying");
+    decaying->setAttentionValue(AttentionValue(0.5, 0.0, 0.0));
+    done = false;
+    std::thread decay_reader([&]() {
+        double last = 0.5;
+        while (!done) {
+            double sti = decaying->getAttentionValue().sti;
+            assert(sti > 0.0 && sti <= last);
+            last = sti;
+        }
+    });
+    for (int i = 0; i < 3000; ++i) {
+        agentspace->addBeliefNode("filler_" + std::to_string(i));
+        if (i % 10 == 0) agentspace->updateAttentionValues();
+    }
+    done = true;
+    decay_reader.join();
+    assert(std::abs(decaying->getAttentionValue().sti - 0.5 * std::pow(0.99, 300)) < 1e-12);
+    
+    // Metadata lives apart and costs nothing until first set
+    auto bare = agentspace->createNode(AtomType::NODE, "bare");
+    assert(bare->getMetadataEntries().empty());
+    assert(bare->getMetadata(MetaKey::OWNER).empty());
+    bare->setMetadata(MetaKey::OWNER, std::string("alice"));
+    assert(bare->getMetadata(MetaKey::OWNER) == "alice");
+    
+    std::cout << "Lock-free atom values test passed!" << std::endl;
+}
+
+void testGraphTraversal() {
+    std::cout << "Testing CSR graph traversal..." << std::endl;
+
+    // Tiny threshold so even small frontiers are split across workers
+    AgentSpaceConfig config;
+    config.num_shards = 4;
+    config.graph.threads = 4;
+    config.graph.parallel_threshold = 2;
+    auto agentspace = std::make_shared<AgentSpace>("graph_test_space", config);
+
+    auto link = [&](const AtomPtr& a, const AtomPtr& b) {
+        return agentspace->addAtom(agentspace->createLink(AtomType::KNOWLEDGE_LINK, {a, b}));
+    };
+    std::vector<AtomPtr> chain;
+    for (int i = 0; i < 10; ++i) {
+        chain.push_back(agentspace->addAtom(agentspace->createNode(AtomType::NODE, "chain" + std::to_string(i))));
+        if (i > 0) link(chain[i - 1], chain[i]);
+    }
+    auto island_a = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "island_a"));
+    auto island_b = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "island_b"));
+    link(island_a, island_b);
+
+    GraphSpec undirected({AtomType::KNOWLEDGE_LINK});
+    auto graph = agentspace->getGraph(undirected);
+    assert(graph->getEdgeCount() == 20);
+
+    auto near = graph->neighborhood(chain[0]->getHandle(), 2);
+    assert(near.size() == 2);
+    assert(near[0] == chain[1]->getHandle() && near[1] == chain[2]->getHandle());
+    assert(graph->neighborhood(chain[5]->getHandle(), 1).size() == 2);
+
+    auto path = graph->shortestPath(chain[0]->getHandle(), chain[6]->getHandle());
+    assert(path.size() == 7);
+    for (size_t i = 0; i < path.size(); ++i) {
+        assert(path[i] == chain[i]->getHandle());
+    }
+    assert(graph->shortestPath(chain[0]->getHandle(), island_a->getHandle()).empty());
+
+    auto labels = graph->connectedComponents();
+    for (const auto& atom : chain) {
+        assert(labels[atom->getHandle().slot()] == labels[chain[0]->getHandle().slot()]);
+    }
+    assert(labels[island_a->getHandle().slot()] == labels[island_b->getHandle().slot()]);
+    assert(labels[island_a->getHandle().slot()] != labels[chain[0]->getHandle().slot()]);
+
+    // Directed graphs only follow links from their first atom
+    auto directed = agentspace->getGraph(GraphSpec({AtomType::KNOWLEDGE_LINK}, true));
+    auto hops = directed->distances({chain[5]->getHandle()});
+    assert(hops[chain[9]->getHandle().slot()] == 4);
+    assert(hops[chain[0]->getHandle().slot()] == AdjacencyGraph::kUnreachable);
+
+    // Unchanged spaces hand back the cached graph
+    assert(agentspace->getGraph(undirected) == graph);
+
+    // Incremental rebuilds match a fresh build from the space
+    auto edgesOf = [](const AdjacencyGraph& g) {
+        std::vector<std::tuple<uint64_t, uint64_t, uint64_t>> edges;
+        for (uint32_t v = 0; v < g.getVertexCount(); ++v) {
+            AtomHandle from = g.handleOf(v);
+            g.forEachNeighbor(from, [&](AtomHandle to, AtomHandle via) {
+                edges.emplace_back(from.value, to.value, via.value);
+            });
+        }
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    };
+    link(chain[9], chain[0]);
+    assert(agentspace->removeAtom(agentspace->getIncoming(chain[4]->getHandle())[0]->getHandle()));
+    AtomHandle removed = island_b->getHandle();
+    assert(agentspace->removeAtom(removed));
+    auto extra = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "extra"));
+    link(extra, island_a);
+    link(chain[2], extra);
+
+    auto rebuilt = agentspace->getGraph(undirected);
+    assert(rebuilt != graph);
+    GraphIndex fresh(config.graph);
+    assert(edgesOf(*rebuilt) == edgesOf(*fresh.get(undirected, *agentspace)));
+    assert(!rebuilt->contains(removed));
+    assert(graph->contains(removed));  // earlier graphs are untouched
+    assert(rebuilt->shortestPath(chain[0]->getHandle(), island_a->getHandle()).size() == 5);
+
+    // Wide frontiers: a two-level tree with 1100 descendants
+    auto root = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "root"));
+    std::vector<AtomPtr> batch;
+    for (int i = 0; i < 100; ++i) {
+        auto child = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "child" + std::to_string(i)));
+        batch.push_back(agentspace->createLink(AtomType::EVALUATION_LINK, {root, child}));
+        for (int j = 0; j < 10; ++j) {
+            auto leaf = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "leaf" + std::to_string(i * 10 + j)));
+            batch.push_back(agentspace->createLink(AtomType::EVALUATION_LINK, {child, leaf}));
+        }
+    }
+    agentspace->addAtoms(batch);
+
+    auto tree = agentspace->getGraph(GraphSpec({AtomType::EVALUATION_LINK}));
+    assert(tree->neighborhood(root->getHandle(), 1).size() == 100);
+    assert(tree->neighborhood(root->getHandle(), 2).size() == 1100);
+    auto tree_labels = tree->connectedComponents();
+    size_t in_tree = 0;
+    for (uint32_t v = 0; v < tree->getVertexCount(); ++v) {
+        if (tree_labels[v] == AdjacencyGraph::kNoVertex) continue;
+        assert(tree_labels[v] == tree_labels[root->getHandle().slot()]);
+        ++in_tree;
+    }
+    assert(in_tree == 1101);
+
+    agentspace->clear();
+    assert(agentspace->getGraph(undirected)->getEdgeCount() == 0);
+
+    // Agents reachable over trust and collaboration links
+    SwarmCogConfig swarm_config;
+    swarm_config.agentspace_name = "graph_swarm";
+    auto swarmcog = std::make_shared<SwarmCog::SwarmCog>(swarm_config);
+    auto alpha = swarmcog->createCognitiveAgent("alpha", "Alpha", "cognitive_v1", "", {"reasoning"});
+    auto beta = swarmcog->createCognitiveAgent("beta", "Beta", "cognitive_v1", "", {"planning"});
+    auto gamma = swarmcog->createCognitiveAgent("gamma", "Gamma", "cognitive_v1", "", {"vision"});
+    swarmcog->createCognitiveAgent("delta", "Delta", "cognitive_v1", "", {"memory"});
+    assert(swarmcog->getConnectedAgents("alpha").empty());
+
+    alpha->establishTrust(beta->getAgentNode()->getId(), 0.8);
+    beta->establishTrust(gamma->getAgentNode()->getId(), 0.6);
+    assert((swarmcog->getConnectedAgents("alpha") == std::vector<AgentId>{"beta", "gamma"}));
+    assert((swarmcog->getConnectedAgents("gamma") == std::vector<AgentId>{"alpha", "beta"}));
+    assert(swarmcog->getConnectedAgents("delta").empty());
+    assert(swarmcog->getConnectedAgents("nobody").empty());
+
+    std::cout << "CSR graph traversal test passed!" << std::endl;
+}
+
+void testEmbeddingSearch() {
+    std::cout << "Testing embedding similarity search..." << std::endl;
+    
+    std::mt19937 rng(7);
+    std::normal_distribution<float> gaussian(0.0f, 1.0f);
+    auto randomVector = [&](size_t dimensions) {
+        std::vector<float> v(dimensions);
+        for (auto& x : v) x = gaussian(rng);
+        return v;
+    };
+    
+    // SIMD kernel agrees with a plain dot product over padded rows
+    std::vector<float> a = randomVector(48), b = randomVector(48);
+    double expected_dot = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) expected_dot += a[i] * b[i];
+    assert(std::abs(VectorKernels::dot(a.data(), b.data(), a.size()) - expected_dot) < 1e-3);
+    
+    // Approximate search finds nearly all of the exact top 10
+    const size_t dimensions = 24;
+    EmbeddingIndex index;
+    std::vector<std::vector<float>> vectors;
+    for (uint32_t i = 0; i < 2000; ++i) {
+        vectors.push_back(randomVector(dimensions));
+        assert(index.insert(AtomHandle(i, 1), vectors.back()));
+    }
+    assert(index.size() == 2000 && index.getDimensions() == dimensions);
+    assert(!index.insert(AtomHandle(5000, 1), randomVector(dimensions + 1)));
+    assert(!index.insert(AtomHandle(5000, 1), std::vector<float>(dimensions, 0.0f)));
+    
+    auto recall = [&](size_t queries) {
+        size_t hits = 0;
+        for (size_t q = 0; q < queries; ++q) {
+            auto query = randomVector(dimensions);
+            auto approximate = index.search(query, 10);
+            auto exact = index.searchExact(query, 10);
+            assert(approximate.size() == 10);
+            for (size_t i = 1; i < approximate.size(); ++i) {
+                assert(approximate[i - 1].first >= approximate[i].first);
+            }
+            for (const auto& match : exact) {
+                for (const auto& found : approximate) {
+                    if (found.second == match.second) ++hits;
+                }
+            }
+        }
+        return static_cast<double>(hits) / (queries * 10);
+    };
+    assert(recall(50) >= 0.9);
+    
+    auto self = index.search(vectors[123], 1);
+    assert(self.size() == 1 && self[0].second == AtomHandle(123, 1));
+    assert(std::abs(self[0].first - 1.0f) < 1e-4);
+    
+    // Removed vectors never come back, and heavy removal compacts the graph
+    assert(index.remove(AtomHandle(123, 1)));
+    assert(!index.remove(AtomHandle(123, 1)));
+    assert(index.search(vectors[123], 1)[0].second != AtomHandle(123, 1));
+    for (uint32_t i = 0; i < 1500; ++i) {
+        index.remove(AtomHandle(i, 1));
+    }
+    assert(index.size() == 500);
+    for (const auto& match : index.search(vectors[1700], 50)) {
+        assert(match.second.slot() >= 1500);
+    }
+    assert(recall(20) >= 0.9);
+    
+    // Readers search while a writer inserts and removes
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&, t]() {
+            std::mt19937 local_rng(t);
+            std::normal_distribution<float> local_gaussian(0.0f, 1.0f);
+            std::vector<float> query(dimensions);
+            while (!done) {
+                for (auto& x : query) x = local_gaussian(local_rng);
+                assert(index.search(query, 5).size() <= 5);
+            }
+        });
+    }
+    for (uint32_t i = 2000; i < 2300; ++i) {
+        index.insert(AtomHandle(i, 1), randomVector(dimensions));
+        index.remove(AtomHandle(i - 150, 1));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    // Memory nodes carry embeddings through the space
+    AgentSpaceConfig config;
+    config.num_shards = 2;
+    config.embedding.dimensions = 4;
+    auto agentspace = std::make_shared<AgentSpace>("embedding_test_space", config);
+    auto cats = agentspace->addMemoryNode("cats purr", "semantic", "alice", {1.0f, 0.1f, 0.0f, 0.0f});
+    auto dogs = agentspace->addMemoryNode("dogs bark", "semantic", "bob", {0.9f, 0.3f, 0.0f, 0.0f});
+    auto rain = agentspace->addMemoryNode("rain falls", "episodic", "alice", {0.0f, 0.0f, 1.0f, 0.2f});
+    auto plain = agentspace->addMemoryNode("no vector", "episodic", "alice");
+    assert(agentspace->getAtom(cats->getHandle()) == cats);  // the stored atom is returned
+    auto concept_node = agentspace->addAtom(agentspace->createNode(AtomType::NODE, "pets"));
+    assert(agentspace->setEmbedding(concept_node->getHandle(), {1.0f, 0.0f, 0.0f, 0.0f}));
+    assert(!agentspace->setEmbedding(plain->getHandle(), {1.0f, 0.0f}));
+    assert(!agentspace->setEmbedding(agentspace->createNode(AtomType::NODE, "loose")->getHandle(),
+                                     {1.0f, 0.0f, 0.0f, 0.0f}));
+    assert(agentspace->getEmbedding(plain->getHandle()).empty());
+    assert(agentspace->getEmbedding(cats->getHandle()).size() == 4);
+    
+    std::vector<float> pets = {1.0f, 0.0f, 0.0f, 0.0f};
+    auto similar = agentspace->findSimilar(pets, 2);
+    assert(similar.size() == 2);
+    assert(similar[0].first == concept_node && std::abs(similar[0].second - 1.0) < 1e-5);
+    assert(similar[1].first == cats);
+    
+    auto memories = agentspace->findSimilarMemories(pets, 2);
+    assert(memories.size() == 2 && memories[0].first == cats && memories[1].first == dogs);
+    auto alice_memories = agentspace->findSimilarMemories(pets, 5, "alice");
+    assert(alice_memories.size() == 2);
+    assert(alice_memories[0].first == cats && alice_memories[1].first == rain);
+    
+    AtomHandle cats_handle = cats->getHandle();
+    assert(agentspace->removeAtom(cats_handle));
+    assert(agentspace->getEmbedding(cats_handle).empty());
+    assert(agentspace->findSimilarMemories(pets, 1)[0].first == dogs);
+    assert(agentspace->getStatistics()["embeddings"] == 3);
+    
+    agentspace->clear();
+    assert(agentspace->findSimilar(pets, 5).empty());
+    assert(agentspace->getEmbeddingIndex().getDimensions() == 4);
+    
+    std::cout << "Embedding similarity search test passed!" << std::endl;
+}
+
+void testSpreadingActivation() {
+    std::cout << "Testing spreading activation..." << std::endl;
+    
+    AgentSpaceConfig space_config;
+    space_config.num_shards = 2;
+    auto agentspace = std::make_shared<AgentSpace>("spreading_test_space", space_config);
+    auto node = [&](const std::string& name) {
+        return agentspace->addAtom(agentspace->createNode(AtomType::NODE, name));
+    };
+    auto link = [&](const AtomPtr& a, const AtomPtr& b) {
+        agentspace->addAtom(agentspace->createLink(AtomType::KNOWLEDGE_LINK, {a, b}));
+    };
+    auto sti = [](const AtomPtr& atom) { return atom->getAttentionValue().sti; };
+    
+    auto hub = node("hub");
+    std::vector<AtomPtr> leaves;
+    for (int i = 0; i < 4; ++i) {
+        leaves.push_back(node("leaf" + std::to_string(i)));
+        link(hub, leaves.back());
+    }
+    auto loner = node("loner");
+    
+    SpreadingConfig config;
+    config.diffusion_rate = 0.4;
+    config.diffusion_threshold = 0.05;
+    config.rent = 0.0;
+    config.wage = 0.5;
+    AttentionSpreader spreader(agentspace, config);
+    
+    // A stimulus pays a wage, then spreads one hop per step
+    assert(spreader.stimulate(hub->getHandle()));
+    assert(!spreader.stimulate(agentspace->createNode(AtomType::NODE, "unstored")->getHandle()));
+    assert(std::abs(sti(hub) - 0.5) < 1e-9);
+    assert(spreader.step() == 1);
+    assert(std::abs(sti(hub) - 0.3) < 1e-9);
+    for (const auto& leaf : leaves) {
+        assert(std::abs(sti(leaf) - 0.05) < 1e-9);
+    }
+    assert(spreader.step() == 0);  // leaves sit at the threshold
+    assert(spreader.step() == 0);  // and nothing is left pending
+    
+    auto focus = agentspace->getMostImportantAtoms(5);
+    assert(focus.size() == 5 && focus[0] == hub);
+    assert(std::find(focus.begin(), focus.end(), loner) == focus.end());
+    
+    // A sweep moves STI without creating or destroying it
+    auto a = node("a");
+    auto b = node("b");
+    auto c = node("c");
+    link(a, b);
+    link(b, c);
+    a->setAttentionValue(AttentionValue(0.6, 0.0, 0.0));
+    std::vector<AtomPtr> linked = {hub, a, b, c};
+    linked.insert(linked.end(), leaves.begin(), leaves.end());
+    auto total = [&]() {
+        double sum = 0.0;
+        for (const auto& atom : linked) sum += sti(atom);
+        return sum;
+    };
+    double before = total();
+    spreader.runSweep();
+    assert(std::abs(total() - before) < 1e-9);
+    assert(std::abs(sti(a) - 0.36) < 1e-9 && std::abs(sti(b) - 0.24) < 1e-9 && sti(c) == 0.0);
+    assert(std::abs(sti(hub) - 0.18) < 1e-9 && std::abs(sti(leaves[0]) - 0.08) < 1e-9);
+    assert(spreader.getStats().sweeps == 1);
+    
+    // Rent is charged to spreading atoms only
+    SpreadingConfig rent_config = config;
+    rent_config.rent = 0.05;
+    AttentionSpreader renting(agentspace, rent_config);
+    renting.runSweep();
+    assert(std::abs(sti(a) - (0.36 - 0.144 - 0.05 + 0.048)) < 1e-9);
+    assert(std::abs(sti(c) - 0.096 * 0.5) < 1e-9);
+    
+    // Sliced parallel sweeps match the product computed one atom at a time
+    AgentSpaceConfig ring_config;
+    ring_config.num_shards = 4;
+    ring_config.graph.threads = 4;
+    ring_config.graph.parallel_threshold = 8;
+    auto ring_space = std::make_shared<AgentSpace>("spreading_ring_space", ring_config);
+    std::vector<AtomPtr> ring;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> uniform(0.0, 0.5);  // clear of the clamp at 1
+    for (int i = 0; i < 600; ++i) {
+        ring.push_back(ring_space->addAtom(ring_space->createNode(AtomType::NODE, "ring" + std::to_string(i))));
+        ring.back()->setAttentionValue(AttentionValue(uniform(rng), 0.0, 0.0));
+    }
+    for (size_t i = 0; i < ring.size(); ++i) {
+        ring_space->addAtom(ring_space->createLink(AtomType::TRUST_LINK, {ring[i], ring[(i + 1) % ring.size()]}));
+        if (i % 7 == 0 && (i * 13) % ring.size() != i) {
+            ring_space->addAtom(ring_space->createLink(AtomType::TRUST_LINK, {ring[i], ring[(i * 13) % ring.size()]}));
+        }
+    }
+    std::vector<double> expected(ring.size());
+    for (size_t i = 0; i < ring.size(); ++i) {
+        expected[i] = sti(ring[i]);
+    }
+    std::vector<double> start = expected;
+    for (size_t i = 0; i < ring.size(); ++i) {
+        auto neighbors = ring_space->getIncoming(ring[i]->getHandle());
+        if (start[i] <= config.diffusion_threshold) continue;
+        double sent = config.diffusion_rate * start[i];
+        expected[i] -= sent;
+        for (const auto& edge : neighbors) {
+            const auto& ends = edge->getOutgoing();
+            const AtomPtr& other = ends[0] == ring[i] ? ends[1] : ends[0];
+            size_t j = std::stoul(other->getName().substr(4));
+            expected[j] += sent / neighbors.size();
+        }
+    }
+    SpreadingConfig sliced = config;
+    sliced.slice_size = 64;
+    AttentionSpreader ring_spreader(ring_space, sliced);
+    size_t slices = 1;
+    while (!ring_spreader.sweepSlice()) ++slices;
+    assert(slices > 1);
+    for (size_t i = 0; i < ring.size(); ++i) {
+        assert(std::abs(sti(ring[i]) - expected[i]) < 1e-9);
+    }
+    
+    // Over budget, the hottest stimulated atoms spread first
+    SpreadingConfig narrow = config;
+    narrow.max_active = 1;
+    AttentionSpreader budgeted(agentspace, narrow);
+    budgeted.stimulate(a->getHandle(), 0.1);
+    budgeted.stimulate(c->getHandle(), 1.0);
+    double c_before = sti(c);
+    assert(budgeted.step() == 1);
+    assert(sti(c) < c_before);
+    assert(budgeted.step() >= 1);
+    
+    // The background thread picks up stimuli on its own
+    SpreadingConfig background_config = config;
+    background_config.interval = std::chrono::milliseconds(1);
+    AttentionSpreader background(agentspace, background_config);
+    background.start();
+    assert(background.isRunning());
+    double leaf_before = sti(leaves[1]);
+    background.stimulate(hub->getHandle(), 1.0);
+    for (int i = 0; i < 2000 && sti(leaves[1]) <= leaf_before; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    background.stop();
+    assert(sti(leaves[1]) > leaf_before);
+    assert(background.getStats().stimuli == 1);
+    
+    // Spread STI is logged and published like any attention update
+    std::string wal_path = "/tmp/swarmcog_spread_" + Utils::UUIDGenerator::generateShort() + ".log";
+    auto logged_space = std::make_shared<AgentSpace>("spreading_wal_space", space_config);
+    logged_space->setMutationLog(MutationLog::open(wal_path));
+    auto source = logged_space->addAtom(logged_space->createNode(AtomType::NODE, "source"));
+    auto sink = logged_space->addAtom(logged_space->createNode(AtomType::NODE, "sink"));
+    logged_space->addAtom(logged_space->createLink(AtomType::KNOWLEDGE_LINK, {source, sink}));
+    std::atomic<int> attention_events{0};
+    ChangeFilter attention_filter;
+    attention_filter.kinds = {ChangeKind::ATTENTION_UPDATED};
+    logged_space->subscribe(attention_filter, [&](const ChangeBatch& batch) {
+        attention_events += static_cast<int>(batch.events.size());
+    });
+    AttentionSpreader logged(logged_space, config);
+    logged.stimulate(source->getHandle());
+    assert(logged.step() == 1);
+    logged_space->getChangeFeed().flush();
+    assert(attention_events == 3);  // the wage, then source and sink in the step
+    assert(logged_space->getMutationLog()->flush());
+    auto replayed = std::make_shared<AgentSpace>("spreading_replay_space", space_config);
+    replayed->replayMutationLog(wal_path);
+    assert(replayed->getAtom(sink->getId())->getAttentionValue().sti == sti(sink));
+    assert(replayed->getAtom(source->getId())->getAttentionValue().sti == sti(source));
+    logged_space.reset();
+    std::remove(wal_path.c_str());
+    
+    // The cognitive cycle focuses on where activation spread, not on the
+    // globally most important atom, and perceiving the focus does not feed it
+    auto focus_space = std::make_shared<AgentSpace>("spreading_focus_space", space_config);
+    auto seen = focus_space->addAtom(focus_space->createNode(AtomType::NODE, "seen"));
+    auto related = focus_space->addAtom(focus_space->createNode(AtomType::NODE, "related"));
+    auto distant = focus_space->addAtom(focus_space->createNode(AtomType::NODE, "distant"));
+    focus_space->addAtom(focus_space->createLink(AtomType::KNOWLEDGE_LINK, {seen, related}));
+    distant->setAttentionValue(AttentionValue(0.9, 0.0, 0.0));
+    focus_space->addToAttentionalFocus(seen->getHandle());
+    auto focus_spreader = std::make_shared<AttentionSpreader>(focus_space, config);
+    CognitiveMicrokernel kernel(focus_space, ProcessingMode::SYNCHRONOUS, 1);
+    kernel.setAttentionSpreader(focus_spreader);
+    kernel.addCognitiveAgent("watcher");
+    CognitiveContext context("watcher");
+    assert(focus_spreader->stimulate(seen->getHandle()));
+    double seen_sti = sti(seen);
+    kernel.processPerceptionPhase("watcher", context);
+    assert(sti(seen) == seen_sti);
+    focus_spreader->step();
+    kernel.processAttentionPhase("watcher", context);
+    assert(context.focus_atoms.size() == 2);
+    assert(std::find(context.focus_atoms.begin(), context.focus_atoms.end(), related->getId()) != context.focus_atoms.end());
+    assert(std::find(context.focus_atoms.begin(), context.focus_atoms.end(), distant->getId()) == context.focus_atoms.end());
+    double related_sti = sti(related);
+    kernel.processPerceptionPhase("watcher", context);
+    assert(sti(related) == related_sti);
+    
+    // A freshly learned memory has no links yet, but still comes into focus
+    context.variables["actions_executed"] = "1";
+    kernel.processLearningPhase("watcher", context);
+    focus_spreader->step();
+    kernel.processAttentionPhase("watcher", context);
+    auto memories = focus_space->getAtomsByType(AtomType::MEMORY_NODE);
+    assert(memories.size() == 1);
+    assert(std::find(context.focus_atoms.begin(), context.focus_atoms.end(), memories[0]->getId()) != context.focus_atoms.end());
+    
+    // Swarm-level stimulus goes through the system's spreader
+    SwarmCogConfig swarm_config;
+    swarm_config.agentspace_name = "spreading_swarm";
+    auto swarmcog = std::make_shared<SwarmCog::SwarmCog>(swarm_config);
+    auto agent = swarmcog->createCognitiveAgent("solo", "Solo", "cognitive_v1", "", {"thinking"});
+    assert(swarmcog->stimulateAtom(agent->getAgentNode()->getId()));
+    assert(agent->getAgentNode()->getAttentionValue().sti > 0.0);
+    assert(!swarmcog->stimulateAtom("no_such_atom"));
+    
+    std::cout << "Spreading activation test passed!" << std::endl;
+}
+
 void testCognitiveMicrokernel() {
     std::cout << "Testing CognitiveMicrokernel basics..." << std::endl;
     
@@ -136,6 +2212,32 @@ int main() {
     try {
         testUtils();
         testAgentSpaceBasics();
+        testAtomHandles();
+        testAtomArena();
+        testIncomingSets();
+        testTrustIndex();
+        testShardedAgentSpace();
+        testConcurrentWriters();
+        testAttentionColumns();
+        testImportanceIndex();
+        testHashConsing();
+        testSnapshots();
+        testAtomMetadata();
+        testVisitorQueries();
+        testBulkInsert();
+        testSnapshotFile();
+        testMutationLog();
+        testPatternQuery();
+        testUniqueNaming();
+        testCapabilityRegistry();
+        testLazyAttentionDecay();
+        testForgetting();
+        testChangeFeed();
+        testMetadataIndex();
+        testLockFreeAtomValues();
+        testGraphTraversal();
+        testEmbeddingSearch();
+        testSpreadingActivation();
         testCognitiveMicrokernel();
         testCognitiveAgent();
         testSwarmCog();